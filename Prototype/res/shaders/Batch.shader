@@ -0,0 +1,32 @@
+#shader vertex
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in uint aDrawId;      // per instance, see DrawBatch
+
+out vec3 ourColor;
+
+uniform samplerBuffer u_DrawData;           // model matrix of every batched draw, 4 texels each
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main()
+{
+    int base = int(aDrawId) * 4;
+    mat4 drawModel = mat4(texelFetch(u_DrawData, base), texelFetch(u_DrawData, base + 1), texelFetch(u_DrawData, base + 2), texelFetch(u_DrawData, base + 3));
+    gl_Position = projection * view * model * drawModel * vec4(aPos, 1.0);
+    ourColor = aColor;
+};
+
+#shader fragment
+#version 330 core
+
+out vec4 FragColor;
+in vec3 ourColor;
+
+void main()
+{
+    FragColor = vec4(ourColor, 1.0);
+};
@@ -0,0 +1,30 @@
+#shader vertex
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+
+out vec3 ourColor;
+
+#include "include/Camera.glsl"
+
+layout (std140) uniform Object {        // UniformBinding::Object, a UniformRing range per draw
+    mat4 model;
+};
+
+void main()
+{
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+    ourColor = aColor;
+};
+
+#shader fragment
+#version 330 core
+
+out vec4 FragColor;
+in vec3 ourColor;
+
+void main()
+{
+    FragColor = vec4(ourColor, 1.0);
+};
\ No newline at end of file
@@ -0,0 +1,28 @@
+#shader vertex
+#version 330 core
+
+out vec2 texCoord;
+
+void main()
+{
+    // viewport-filling strip from gl_VertexID, no vertex buffer
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    texCoord = vec2(corner.x, 1.0 - corner.y);      // depth rows arrive top row first
+    gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+out vec4 FragColor;
+in vec2 texCoord;
+
+uniform usampler2D u_Depth;             // R16UI millimetres
+uniform vec2 u_Range;                   // near (white) .. far (black) in millimetres
+
+void main()
+{
+    uint depth = texture(u_Depth, texCoord).r;
+    float value = depth == 0u ? 0.0 : 1.0 - clamp((float(depth) - u_Range.x) / (u_Range.y - u_Range.x), 0.0, 1.0);
+    FragColor = vec4(vec3(value), 1.0);
+};
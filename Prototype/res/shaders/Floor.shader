@@ -0,0 +1,28 @@
+#shader vertex
+#version 330 core
+
+out vec2 texCoord;
+
+uniform mat4 u_MVP;
+uniform float u_Tiling;                 // texture repeats across the floor
+
+void main()
+{
+    // unit floor quad in the xz plane from gl_VertexID, no vertex buffer
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    texCoord = corner * u_Tiling;
+    gl_Position = u_MVP * vec4(corner.x - 0.5, 0.0, -corner.y, 1.0);
+};
+
+#shader fragment
+#version 330 core
+
+out vec4 FragColor;
+in vec2 texCoord;
+
+uniform sampler2D u_Texture;
+
+void main()
+{
+    FragColor = texture(u_Texture, texCoord);
+};
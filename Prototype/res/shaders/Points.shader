@@ -0,0 +1,35 @@
+#shader vertex
+#version 330 core
+
+layout (location = 0) in vec4 aPos;      // float xyz (w = 1), or a packed position with w = 0 for no depth
+layout (location = 1) in vec3 aColor;
+
+out vec3 ourColor;
+
+#include "include/Camera.glsl"
+
+uniform mat4 model;
+uniform vec4 u_PositionTransform;       // packed positions: xyz origin, w scale
+
+void main()
+{
+    vec3 position = u_PositionTransform.xyz + aPos.xyz * u_PositionTransform.w;
+
+    // pixels without a depth reading come through at the origin, push them outside the clip volume
+    if (aPos.w == 0.0 || position.z == 0.0)
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+    else
+        gl_Position = viewProjection * model * vec4(position, 1.0);
+    ourColor = aColor;
+};
+
+#shader fragment
+#version 330 core
+
+out vec4 FragColor;
+in vec3 ourColor;
+
+void main()
+{
+    FragColor = vec4(ourColor, 1.0);
+};
\ No newline at end of file
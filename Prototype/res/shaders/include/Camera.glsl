@@ -0,0 +1,8 @@
+layout (std140) uniform Camera {        // UniformBinding::Camera, see CameraBlock
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    mat4 inverseView;
+    mat4 inverseProjection;
+    vec4 viewport;
+};
@@ -8,13 +8,35 @@
 #include <string>               // for string operations
 #include <fstream>              // file stream that deal with reading files
 #include <sstream>              // string stream to contain long strings that hold shaders
+#include <memory>               // owning the frame source
+#include <cstdio>               // sscanf for --headless WxH
+#include <cstdlib>              // atoi
+#include <cctype>               // isdigit
+#include <vector>               // decoded depth scratch
+#include <algorithm>            // min
 
 #include "Renderer.h"           // holds renderer + GLCall Macro
 #include "VertexBuffer.h"       // Vertex Buffer Code
-#include "IndexBuffer.h"        // Index Buffer Code
 #include "VertexBufferLayout.h" // Vertex Attrib Layout Code
 #include "VertexArray.h"        // Vertex + Attrib Layout Code
 #include "Shader.h"             // Loads + Compiles Shaders
+#include "FrameSource.h"        // Depth Frame Sources (synthetic, replay)
+#include "FrameProducer.h"      // Producer Thread + Frame Ring
+#include "BackProjector.h"      // Depth -> Point Cloud Kernel
+#include "Profiler.h"           // CPU/GPU stage timings
+#include "Framebuffer.h"        // Offscreen Target + PBO Readback
+#include "Recording.h"          // .kvr Session Record / Playback
+#include "DepthCodec.h"         // Lossless Depth Compression + .kvd Streams
+#include "PointOctree.h"        // Accumulated Cloud + LOD Selection
+#include "ThreadPool.h"         // Worker Threads
+#include "VoxelGridFilter.h"    // Voxel Grid Downsampling
+#include "PointPacking.h"       // Half / Snorm16 Vertex Formats
+#include "GLState.h"            // Redundant Bind Elimination
+#include "ShaderCache.h"        // Program Binary Cache
+#include "ShaderLibrary.h"      // Deferred / Parallel Shader Compiles
+#include "UniformBuffer.h"      // Camera / Per-Object Uniform Blocks
+#include "Texture.h"            // Streaming Depth Texture
+#include "bench/Benchmark.h"    // --bench entry points
 
 
 // control variables
@@ -42,7 +64,75 @@ void key_rollback(GLFWwindow* window, int key, int scancode, int action, int mod
 }
 
 
-int main(void) {
+int main(int argc, char** argv) {
+
+    // COMMAND LINE
+    std::string replayPath;
+    std::string playPath;
+    std::string recordPath;
+    DepthCodec recordCodec = DepthCodec::Raw16;
+    double playSpeed = 1.0;
+    std::string profilePath;
+    std::string snapshotPath;
+    bool headless = false;
+    int headlessWidth = 1280, headlessHeight = 720;
+    unsigned int maxFrames = 0;
+#if GL_ERROR_CHECKING
+    GLErrorMode errorMode = GLErrorMode::PerCall;
+#else
+    GLErrorMode errorMode = GLErrorMode::FrameSweep;
+#endif
+    bool kinectV1 = false;
+    bool accumulate = false;
+    unsigned int accumulateCapacity = 8000000;
+    unsigned int pointBudget = 1000000;
+    float voxelSize = 0.0f;
+    PointFormat pointFormat = PointFormat::Float32;
+    std::string shaderCachePath = "shadercache";
+    bool watchShaders = false;
+    bool depthView = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) replayPath = argv[++i];                              // raw uint16 depth dump, or a .kvd stream
+        else if (arg == "--play" && i + 1 < argc) playPath = argv[++i];                             // .kvr recording, mapped and read in place
+        else if (arg == "--speed" && i + 1 < argc) {                                                // playback rate, "max" = one recorded frame per rendered frame
+            std::string speed = argv[++i];
+            playSpeed = speed == "max" ? 0.0 : std::atof(speed.c_str());
+        }
+        else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];                         // write the live frames to a .kvr recording (or .kvd stream)
+        else if (arg == "--codec" && i + 1 < argc) {                                                // raw | rvl | vbyte, depth compression for --record
+            if (!ParseDepthCodec(argv[++i], recordCodec)) std::cout << "Unknown depth codec " << argv[i] << std::endl;
+        }
+        else if (arg == "--profile" && i + 1 < argc) profilePath = argv[++i];                       // dump <path>.csv + <path>.json on exit
+        else if (arg == "--gl-errors" && i + 1 < argc) {                                            // off | call | callback | frame
+            if (!GLParseErrorMode(argv[++i], errorMode)) std::cout << "Unknown GL error mode " << argv[i] << std::endl;
+        }
+        else if (arg == "--headless") {                                                             // offscreen FBO, no vsync, optional WxH
+            headless = true;
+            if (i + 1 < argc && std::sscanf(argv[i + 1], "%dx%d", &headlessWidth, &headlessHeight) == 2) i++;
+        }
+        else if (arg == "--frames" && i + 1 < argc) maxFrames = std::atoi(argv[++i]);               // stop after N frames
+        else if (arg == "--snapshot" && i + 1 < argc) snapshotPath = argv[++i];                     // last frame as .ppm (headless)
+        else if (arg == "--accumulate") {                                                           // fuse frames into an LOD octree, optional capacity in points
+            accumulate = true;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) accumulateCapacity = std::atoi(argv[++i]);
+        }
+        else if (arg == "--point-budget" && i + 1 < argc) pointBudget = std::atoi(argv[++i]);         // most octree points drawn per frame
+        else if (arg == "--voxel" && i + 1 < argc) voxelSize = (float)std::atof(argv[++i]);        // downsample to one point per voxel (metres)
+        else if (arg == "--packed" && i + 1 < argc) {                                               // float | half | snorm16, point vertex format in the buffer
+            if (!ParsePointFormat(argv[++i], pointFormat)) std::cout << "Unknown point format " << argv[i] << std::endl;
+        }
+        else if (arg == "--shader-cache" && i + 1 < argc) shaderCachePath = argv[++i];             // program binary cache directory, "" or --no-shader-cache to compile every run
+        else if (arg == "--no-shader-cache") shaderCachePath.clear();
+        else if (arg == "--depth-view") depthView = true;                                           // raw depth image inset, streamed as an R16UI texture
+        else if (arg == "--watch-shaders") watchShaders = true;                                     // reload shaders (and their #includes) when saved
+        else if (arg == "--v1") kinectV1 = true;                                                    // 640x480 instead of 512x424
+        else if (arg == "--bench") {                                                                // run a micro benchmark and exit
+            if (i + 1 < argc && bench::Run(argv[i + 1], i + 2 < argc ? argv[i + 2] : "")) return 0;
+            bench::List();
+            return -1;
+        }
+    }
 
     GLFWwindow* window;                                                                                             // Create OpenGL Window
 
@@ -52,6 +142,8 @@ int main(void) {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, errorMode == GLErrorMode::DebugCallback);           // drivers only guarantee debug output there
+    glfwWindowHint(GLFW_VISIBLE, !headless);                                                        // headless still needs a (hidden) window for its context
 
     window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);                                                 // Setting Window Params
     if (!window) {
@@ -60,67 +152,150 @@ int main(void) {
     }
 
     glfwMakeContextCurrent(window);                                                                                 // Setting Window as Current Context
-    glfwSwapInterval(1);                                                                                            // Set VSync On
+    glfwSwapInterval(headless ? 0 : 1);                                                                             // Set VSync On (off when headless)
     glfwSetKeyCallback(window, key_rollback);
 
 
     if (glewInit() != GLEW_OK)                                                                                      // Initializing GLEW after Context Created/Set
         std::cout << "Error!" << std::endl;
+    GLState::Invalidate();                                                                          // fresh context, nothing cached yet
+
+    GLSetErrorMode(errorMode);
+    ShaderCache::SetDirectory(shaderCachePath);
+
+    // SHADERS (compiling in the driver while the frame source and buffers are set up)
+    ShaderLibrary shaders;
+    shaders.Load("points", "res/shaders/Points.shader");
+    if (depthView) shaders.Load("depth", "res/shaders/Depth.shader");
+    if (watchShaders && !shaders.Watch()) std::cout << "Not watching shaders for changes" << std::endl;
+
+    // FRAME SOURCE (producer thread -> lock-free ring -> render loop, or a mapped recording)
+    CameraIntrinsics intrinsics = kinectV1 ? CameraIntrinsics::KinectV1() : CameraIntrinsics::KinectV2();
+    std::unique_ptr<FrameSource> source;
+    std::unique_ptr<RecordingTap> tap;
+    std::unique_ptr<FrameProducer> producer;
+    std::unique_ptr<RecordingReader> recording;
+    std::unique_ptr<RecordingPlayer> player;
+
+    if (!playPath.empty()) {
+        recording.reset(new RecordingReader(playPath));
+        if (!recording->IsOpen() || recording->GetFrameCount() == 0) {
+            glfwTerminate();
+            return -1;
+        }
+        intrinsics = recording->GetIntrinsics();
+        player.reset(new RecordingPlayer(*recording, playSpeed, playSpeed > 0.0 && maxFrames == 0));      // batch ("max") runs end with the recording
+    }
+    else {
+        bool stream = replayPath.size() >= 4 && replayPath.compare(replayPath.size() - 4, 4, ".kvd") == 0;
+        if (stream) source.reset(new DepthStreamReader(replayPath));
+        else if (!replayPath.empty()) source.reset(new FileReplaySource(replayPath, intrinsics));
+        else source.reset(new SyntheticDepthSource(intrinsics));
+        intrinsics = source->GetIntrinsics();
+
+        FrameSource* input = source.get();
+        if (!recordPath.empty()) {
+            tap.reset(new RecordingTap(*source, recordPath, recordCodec));
+            input = tap.get();
+        }
 
-    // Define the vertices and colors for the cube
-    float positions[] = {
-        // top vertexes
-        -0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,     // front left    // red      // 0
-         0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,     // front right   // green    // 1
-        -0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 0.0f,     // back left     // blue     // 2
-         0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 0.0f,     // back right    // yellow   // 3
-        
-        // bottom vertexes
-        -0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 1.0f,     // front left    // magenta  // 4
-         0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 1.0f,     // front right   // cyan     // 5
-        -0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f,     // back left     // orange   // 6
-         0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f,     // back right    // black    // 7
-    };
+        producer.reset(new FrameProducer(*input));
+        producer->Start();
+    }
 
-    // INDEX DATA
-    unsigned int indicies[] = {
-        2, 6, 3, 3, 6, 7,   // back
-        0, 2, 1, 1, 2, 3,   // top
-        4, 0, 5, 5, 0, 1,   // front
-        6, 4, 7, 7, 4, 5,   // bottom
-        3, 7, 1, 1, 7, 5,   // right
-        0, 4, 2, 2, 4, 6,   // left
-    };
+    // POINT CLOUD (one vertex per depth pixel, streamed through a ring of fenced regions)
+    unsigned int pointCount = intrinsics.width * intrinsics.height;
+
+    using PointVertex = FloatPointVertex;                                                           // what the back-projector, filter and octree work in
+
+    if (accumulate && pointFormat != PointFormat::Float32) {
+        std::cout << "--packed is ignored with --accumulate, octree pages stay float" << std::endl;
+        pointFormat = PointFormat::Float32;
+    }
+    bool packed = pointFormat != PointFormat::Float32;
+    unsigned int vertexStride = GetPointStride(pointFormat);
+    PointQuantization quantization = packed ? PointQuantization::Box(glm::vec3(0.0f, 0.0f, -4.0f), 4.5f) : PointQuantization::None();     // 9 m cube in front of the sensor
 
     VertexArray va;
-    VertexBuffer vb(positions, 8 * 6 * sizeof(float));
-    VertexBufferLayout layout;
-    layout.Push<float>(3);
-    layout.Push<float>(3);
-    va.AddBuffer(vb, layout);
+    VertexBuffer vb(pointCount * vertexStride, BufferUsage::Streaming, 3);
+    if (pointFormat == PointFormat::Half) va.AddBuffer(vb, HalfPointVertex());
+    else if (pointFormat == PointFormat::Snorm16) va.AddBuffer(vb, Snorm16PointVertex());
+    else va.AddBuffer(vb, PointVertex());
+
+    BackProjector projector(intrinsics, PointLayout::From<PointVertex>());                         // depth -> xyz + colour straight into the vertex layout
+    std::vector<uint16_t> decoded(recording && recording->GetHeader().depthCodec != (uint32_t)DepthCodec::Raw16 ? pointCount : 0);
+
+    unsigned int drawCount = pointCount;
+
+    // VOXEL FILTER (--voxel: one centroid per voxel, binned in parallel across the pool)
+    std::unique_ptr<ThreadPool> pool;
+    std::unique_ptr<VoxelGridFilter> voxelFilter;
+    if (voxelSize > 0.0f) {
+        pool.reset(new ThreadPool());
+        voxelFilter.reset(new VoxelGridFilter(voxelSize, PointLayout::From<PointVertex>(), pool.get()));
+    }
 
-    // INDEX BUFFER (Keeps track of different vertexes)
-    IndexBuffer ib(indicies, 12 * 3);
+    // ACCUMULATED CLOUD (--accumulate: every frame is fused into an octree, drawn within a point budget)
+    std::unique_ptr<PointOctree> octree;
+    OctreeSelection selection = {};
+    const unsigned int octreeUploadBudget = 500000;                                                 // points per frame
+    if (accumulate)
+        octree.reset(new PointOctree(glm::vec3(0.0f, 0.0f, -4.0f), 4.5f, accumulateCapacity, PointVertex()));      // 9 m cube in front of the sensor
+
+    // CPU side point staging when a stage sits between the back-projector and the vertex buffer;
+    // packing on its own goes through a few rows at a time so the floats never leave the cache
+    const int packRows = 16;
+    size_t stagingPoints = octree || voxelFilter ? pointCount : packed ? (size_t)packRows * intrinsics.width : 0;
+    std::vector<unsigned char> staging(stagingPoints * PointVertex::Stride);
+    std::vector<unsigned char> filtered(voxelFilter && (octree || packed) ? (size_t)pointCount * PointVertex::Stride : 0);
 
     // SHADERS    
-    Shader shader("res/shaders/Basic.shader");
+    Shader& shader = shaders.Get("points");
     shader.Bind();
+    shader.SetUniform4f("u_PositionTransform", quantization.origin.x, quantization.origin.y, quantization.origin.z, quantization.scale);
     //shader.SetUniform4f("u_Color", 0.2f, 0.3f, 0.8f, 1.0f);
 
+    // DEPTH VIEW (the raw depth frame through a PBO ring, drawn as an inset)
+    std::unique_ptr<Texture> depthTexture;
+    std::unique_ptr<VertexArray> quad;
+    auto setDepthUniforms = [&]() {
+        Shader& depthShader = shaders.Get("depth");
+        depthShader.Bind();
+        depthShader.SetUniform("u_Depth", 0);
+        depthShader.SetUniform("u_Range", glm::vec2(500.0f, 4500.0f));
+    };
+    if (depthView) {
+        depthTexture.reset(new Texture(intrinsics.width, intrinsics.height, TextureFormat::R16UI));
+        quad.reset(new VertexArray());
+        setDepthUniforms();
+    }
+
+    // OFFSCREEN TARGET (headless: render into an FBO of any size and read it back through PBOs)
+    std::unique_ptr<Framebuffer> offscreen;
+    std::unique_ptr<FramebufferReadback> readback;
+    if (headless) {
+        offscreen.reset(new Framebuffer(headlessWidth, headlessHeight));
+        readback.reset(new FramebufferReadback(headlessWidth, headlessHeight));
+    }
+
     // Set up projection matrix
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+    float aspect = headless ? (float)headlessWidth / headlessHeight : 800.0f / 600.0f;
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), aspect, 0.1f, 100.0f);
+
+    // Set up view matrix (points are already in camera space)
+    glm::mat4 view = glm::mat4(1.0f);
 
-    // Set up view matrix
-    glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
+    // Camera block shared by every program, rewritten once per frame
+    UniformBuffer camera(sizeof(CameraBlock));
+    camera.Bind(UniformBinding::Camera);
 
-    // Set up model matrix and rotate cube
-    glm::mat4 model = glm::rotate(glm::mat4(1.0f), 0.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+    // Rotate the cloud around a pivot in front of the sensor
+    glm::vec3 pivot(0.0f, 0.0f, -2.5f);
 
     // UNBIND EVERYTHING
     va.Unbind();
     shader.Unbind();
     vb.Unbind();
-    ib.Unbind();
 
     // RENDERER
     Renderer renderer;
@@ -129,17 +304,78 @@ int main(void) {
     float red_channel = 0.0f;
     float increment = 0.05f;
 
-    GLCall(glEnable(GL_DEPTH_TEST));
+    GLState::Enable(GL_DEPTH_TEST);
+    GLCall(glPointSize(2.0f));
+
 
+    Profiler& profiler = Profiler::Get();
+    unsigned int frameCount = 0;
+    double startTime = glfwGetTime();
 
-    while (!glfwWindowShouldClose(window)) {
+    while (!glfwWindowShouldClose(window) && (maxFrames == 0 || frameCount < maxFrames) && !(player && player->IsFinished())) {
 
+        profiler.BeginFrame();
+        if (offscreen) offscreen->Bind();
         renderer.Clear();
 
-        // DRAWING A TRIANLGE
+        // UPLOAD NEWEST DEPTH FRAME (never waits on the producer)
+        const uint16_t* depth = nullptr;
+        const DepthFrame* liveFrame = nullptr;
+        unsigned int recordedFrame;
+        if (player && player->Advance(glfwGetTime(), recordedFrame)) {
+            RecordedFrame frame = recording->GetFrame(recordedFrame);
+            depth = frame.GetDepth16();                                                             // raw: straight from the mapped file, no copy
+            if (!depth && frame.DecodeDepth(decoded.data(), pointCount)) depth = decoded.data();
+        }
+        else if (producer && (liveFrame = producer->AcquireLatest()))
+            depth = liveFrame->depth.data();
+
+        if (depth && (octree || voxelFilter)) {
+            PROFILE_SCOPE("Upload");
+            projector.Process(depth, staging.data());
+            const void* points = staging.data();
+            unsigned int count = pointCount;
+            if (voxelFilter) {
+                void* out = octree || packed ? filtered.data() : vb.BeginWrite();
+                count = voxelFilter->Process(staging.data(), pointCount, out);
+                points = out;
+            }
+            if (octree) octree->Insert(points, count);
+            else {
+                if (packed) PackPoints(pointFormat, projector.GetLayout(), points, count, quantization, vb.BeginWrite());
+                vb.EndWrite(count * vertexStride);
+            }
+            drawCount = count;
+        }
+        else if (depth && packed) {
+            PROFILE_SCOPE("Upload");
+            unsigned char* out = (unsigned char*)vb.BeginWrite();
+            for (int row = 0; row < intrinsics.height; row += packRows) {
+                int rows = std::min(packRows, intrinsics.height - row);
+                unsigned int count = rows * intrinsics.width;
+                projector.ProcessRows(depth, staging.data(), row, rows);
+                PackPoints(pointFormat, projector.GetLayout(), staging.data(), count, quantization, out + (size_t)row * intrinsics.width * vertexStride);
+            }
+            vb.EndWrite(pointCount * vertexStride);
+        }
+        else if (depth) {
+            PROFILE_SCOPE("Upload");
+            projector.Process(depth, vb.BeginWrite());
+            vb.EndWrite(pointCount * vertexStride);
+        }
+        if (depth && depthTexture) {
+            PROFILE_SCOPE("DepthTexture");
+            depthTexture->Update(depth);
+        }
+        if (liveFrame) producer->Release();
+        if (octree) octree->Upload(octreeUploadBudget);
+
+        // DRAWING THE POINT CLOUD
         va.Bind();
-        ib.Bind();
+        bool reloaded = shaders.Update() > 0;
+        if (reloaded && depthView) setDepthUniforms();
         shader.Bind();
+        if (reloaded) shader.SetUniform4f("u_PositionTransform", quantization.origin.x, quantization.origin.y, quantization.origin.z, quantization.scale);      // a reloaded program starts with default uniforms
 
         // Set up view matrix
         // glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -3.0f));
@@ -176,17 +412,103 @@ int main(void) {
         }
 
 
-        // Set up model matrix and rotate cube
-        glm::mat4 model = glm::rotate(glm::rotate(glm::mat4(1.0f), rotationAngleX, glm::vec3(0.0f, 1.0f, 0.0f)), rotationAngleY, glm::vec3(1.0f, 0.0f, 0.0f));
+        // Set up model matrix and rotate the cloud about the pivot
+        glm::mat4 model = glm::translate(glm::mat4(1.0f), pivot);
+        model = glm::rotate(glm::rotate(model, rotationAngleX, glm::vec3(0.0f, 1.0f, 0.0f)), rotationAngleY, glm::vec3(1.0f, 0.0f, 0.0f));
+        model = glm::translate(model, -pivot);
+
 
 
+        int viewportWidth = headlessWidth, viewportHeight = headlessHeight;
+        if (!headless) glfwGetFramebufferSize(window, &viewportWidth, &viewportHeight);
+        CameraBlock cameraBlock = CameraBlock::From(view, projection, glm::vec4(0.0f, 0.0f, (float)viewportWidth, (float)viewportHeight));
+        camera.SetData(&cameraBlock, sizeof(cameraBlock));
+        shader.SetUniformMat4f("model", model);
+        if (octree) {
+            octree->Select(projection, view * model, (float)viewportHeight, pointBudget, selection);
+            renderer.DrawPointRanges(octree->GetVertexArray(), shader, selection.firsts.data(), selection.counts.data(), (unsigned int)selection.firsts.size());
+        }
+        else {
+            renderer.DrawPoints(va, shader, vb.GetRegionOffset() / vertexStride, drawCount);
+            vb.FenceRegion();
+        }
 
-        shader.SetUniformMVP(model, view, projection);
-        renderer.Draw(va, ib, shader);
+        if (depthTexture) {
+            int insetWidth = viewportWidth / 4, insetHeight = insetWidth * intrinsics.height / intrinsics.width;
+            GLCall(glViewport(0, 0, insetWidth, insetHeight));
+            GLState::Disable(GL_DEPTH_TEST);
+            depthTexture->Bind(0);
+            renderer.DrawQuad(*quad, shaders.Get("depth"));
+            GLState::Enable(GL_DEPTH_TEST);
+            GLCall(glViewport(0, 0, viewportWidth, viewportHeight));
+        }
 
 
-        glfwSwapBuffers(window);
+        if (headless) {
+            PROFILE_SCOPE("Readback");
+            readback->Capture(*offscreen);
+            readback->MapPrevious();                                                                // frame k-1, already finished on the GPU
+            readback->Unmap();
+        }
+        else {
+            PROFILE_SCOPE("Swap");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+        GLFrameErrorSweep();
+        profiler.EndFrame();
+        GLState::EndFrame();
+        frameCount++;
+    }
+
+    double elapsed = glfwGetTime() - startTime;
+    std::cout << frameCount << " frames in " << elapsed << " s (" << frameCount / elapsed << " fps)" << std::endl;
+
+    if (headless && !snapshotPath.empty()) {
+        readback->Capture(*offscreen);                                                              // pushes the last rendered frame into "previous"
+        const unsigned char* pixels = readback->MapPrevious();
+        if (!pixels || !FramebufferReadback::WritePPM(snapshotPath, pixels, headlessWidth, headlessHeight))
+            std::cout << "Could not write snapshot " << snapshotPath << std::endl;
+        readback->Unmap();
+    }
+    readback.reset();
+    offscreen.reset();
+    quad.reset();
+
+    if (producer) producer->Stop();
+    profiler.Shutdown();
+    profiler.Report(std::cout);
+    if (!profilePath.empty()) {
+        profiler.WriteCsv(profilePath + ".csv");
+        profiler.WriteChromeTrace(profilePath + ".json");
+    }
+
+    if (producer)
+        std::cout << "Frames produced: " << producer->GetProducedFrames() << ", dropped: " << producer->GetDroppedFrames() << ", skipped: " << producer->GetSkippedFrames() << std::endl;
+    if (voxelFilter)
+        std::cout << "Voxel filter (" << voxelSize * 100.0f << " cm, " << pool->GetConcurrency() << " threads): last frame " << drawCount << " of " << pointCount << " points" << std::endl;
+    if (octree)
+        std::cout << "Octree: " << octree->GetPointCount() << " points in " << octree->GetNodeCount() << " nodes (" << octree->GetRejectedCount() << " rejected), last frame drew "
+            << selection.points << " points from " << selection.nodes << " nodes in " << selection.firsts.size() << " ranges, " << selection.culled << " nodes culled" << std::endl;
+    if (tap)
+        std::cout << "Recorded " << tap->GetFrameCount() << " frames to " << recordPath << std::endl;
+
+    const ShaderCacheStats& shaderStats = ShaderCache::GetStats();
+    std::cout << "Shaders: " << shaderStats.seconds * 1000.0 << " ms, " << shaderStats.hits << " from the cache, " << shaderStats.compiled << " compiled" << (ShaderLibrary::IsParallelSupported() ? " in parallel" : "")
+        << (shaderStats.rejected ? " (" + std::to_string(shaderStats.rejected) + " cached binaries rejected)" : std::string()) << std::endl;
+
+    const GLStateStats& state = GLState::GetTotalStats();
+    if (GLState::GetFrameCount())
+        std::cout << "GL state changes per frame: " << state.issued / GLState::GetFrameCount() << " issued, " << state.elided / GLState::GetFrameCount() << " elided" << std::endl;
+
+    const StreamStats& uploads = vb.GetStats();
+    std::cout << "Point uploads (" << GetPointFormatName(pointFormat) << ", " << vertexStride << " B/point, " << (vb.IsPersistent() ? "persistent" : "orphaned") << "): " << uploads.uploads << " frames, "
+        << uploads.GetWriteMilliseconds() << " ms filling + " << uploads.GetUploadMilliseconds() << " ms in upload calls per frame, " << uploads.stalls << " fence stalls (" << uploads.stallSeconds * 1000.0 << " ms)" << std::endl;
+    if (depthTexture) {
+        const StreamStats& textureUploads = depthTexture->GetStats();
+        std::cout << "Depth texture uploads (" << (depthTexture->IsPersistent() ? "persistent" : "orphaned") << " PBO): " << textureUploads.uploads << " frames, "
+            << textureUploads.GetWriteMilliseconds() << " ms filling + " << textureUploads.GetUploadMilliseconds() << " ms in upload calls per frame, " << textureUploads.stalls << " fence stalls (" << textureUploads.stallSeconds * 1000.0 << " ms)" << std::endl;
+        depthTexture.reset();
     }
 
     glfwTerminate();
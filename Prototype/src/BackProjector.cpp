@@ -0,0 +1,191 @@
+#include "BackProjector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "VertexBufferLayout.h"
+
+PointLayout::PointLayout(unsigned int stride, int positionOffset, int colorOffset)
+	:stride(stride), positionOffset(positionOffset), colorOffset(colorOffset) {}
+
+PointLayout::PointLayout(const VertexBufferLayout& layout)
+	:stride(layout.GetStride()), positionOffset(0), colorOffset(-1) {
+
+	const auto& elements = layout.GetElements();
+	ASSERT(!elements.empty() && elements[0].type == GL_FLOAT && elements[0].count == 3);
+
+	if (elements.size() > 1 && elements[1].type == GL_FLOAT && elements[1].count == 3)
+		colorOffset = elements[0].count * VertexBufferElement::GetSizeOfType(elements[0].type);
+}
+
+
+BackProjector::BackProjector(const CameraIntrinsics& intrinsics, const PointLayout& layout)
+	:m_Intrinsics(intrinsics), m_Layout(layout), m_DepthScale(intrinsics.depthScale), m_Level(Simd::Detect()) {
+
+	SetColorRange(0.5f, 4.5f);
+	BuildRayTable();
+}
+
+void BackProjector::SetIntrinsics(const CameraIntrinsics& intrinsics) {
+	bool changed = std::memcmp(&intrinsics, &m_Intrinsics, sizeof(CameraIntrinsics)) != 0;
+	m_Intrinsics = intrinsics;
+	m_DepthScale = intrinsics.depthScale;
+	if (changed) BuildRayTable();
+}
+
+void BackProjector::SetColorRange(float nearMetres, float farMetres) {
+	m_ColorNear = nearMetres;
+	m_ColorInvRange = 1.0f / std::max(farMetres - nearMetres, 1e-6f);
+}
+
+void BackProjector::SetSimdLevel(Simd::Level level) {
+	m_Level = Simd::Clamp(level);
+}
+
+void BackProjector::BuildRayTable() {
+	const CameraIntrinsics& k = m_Intrinsics;
+	size_t count = (size_t)k.width * k.height;
+	m_RayX.resize(count);
+	m_RayY.resize(count);
+
+	for (int v = 0; v < k.height; v++) {
+		for (int u = 0; u < k.width; u++) {
+			// distorted normalised coordinates, undistorted by fixed point iteration
+			float xd = (u - k.cx) / k.fx;
+			float yd = (v - k.cy) / k.fy;
+			float x = xd, y = yd;
+
+			for (int it = 0; it < 8; it++) {
+				float r2 = x * x + y * y;
+				float radial = 1.0f + r2 * (k.k1 + r2 * (k.k2 + r2 * k.k3));
+				float dx = 2.0f * k.p1 * x * y + k.p2 * (r2 + 2.0f * x * x);
+				float dy = k.p1 * (r2 + 2.0f * y * y) + 2.0f * k.p2 * x * y;
+				x = (xd - dx) / radial;
+				y = (yd - dy) / radial;
+			}
+
+			size_t i = (size_t)v * k.width + u;
+			m_RayX[i] = x;
+			m_RayY[i] = -y;
+		}
+	}
+}
+
+bool BackProjector::IsPackedPositionColor() const {
+	return m_Layout.stride == 6 * sizeof(float) && m_Layout.positionOffset == 0 && m_Layout.colorOffset == 3 * sizeof(float);
+}
+
+void BackProjector::Process(const uint16_t* depth, void* vertices) const {
+	ProcessRows(depth, vertices, 0, m_Intrinsics.height);
+}
+
+void BackProjector::ProcessRows(const uint16_t* depth, void* vertices, int firstRow, int rowCount) const {
+	size_t begin = (size_t)firstRow * m_Intrinsics.width;
+	size_t end = begin + (size_t)rowCount * m_Intrinsics.width;
+	unsigned char* out = (unsigned char*)vertices;		// vertex `begin`
+
+	if (m_Level == Simd::Level::AVX2 && IsPackedPositionColor()) ProcessAVX2(depth, out, begin, end);
+	else if (m_Level == Simd::Level::SSE41 && IsPackedPositionColor()) ProcessSSE41(depth, out, begin, end);
+	else ProcessScalar(depth, out, begin, end);
+}
+
+void BackProjector::ProcessScalar(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const {
+	for (size_t i = begin; i < end; i++) {
+		float z = depth[i] * m_DepthScale;
+		unsigned char* vertex = out + (i - begin) * m_Layout.stride;
+
+		float* p = (float*)(vertex + m_Layout.positionOffset);
+		p[0] = m_RayX[i] * z;
+		p[1] = m_RayY[i] * z;
+		p[2] = -z;
+
+		if (m_Layout.colorOffset >= 0) {
+			float t = std::min(std::max((z - m_ColorNear) * m_ColorInvRange, 0.0f), 1.0f);
+			float* c = (float*)(vertex + m_Layout.colorOffset);
+			c[0] = t;
+			c[1] = 1.0f - std::fabs(2.0f * t - 1.0f);
+			c[2] = 1.0f - t;
+		}
+	}
+}
+
+#if SIMD_X86
+// 4 points as xyzrgb rows: transpose xyzr, then pair up gb
+static inline void StoreInterleaved4(float* out, __m128 x, __m128 y, __m128 z, __m128 r, __m128 g, __m128 b) {
+	_MM_TRANSPOSE4_PS(x, y, z, r);
+	__m128 gb01 = _mm_unpacklo_ps(g, b);
+	__m128 gb23 = _mm_unpackhi_ps(g, b);
+
+	_mm_storeu_ps(out + 0, x);	_mm_storel_pi((__m64*)(out + 4), gb01);
+	_mm_storeu_ps(out + 6, y);	_mm_storeh_pi((__m64*)(out + 10), gb01);
+	_mm_storeu_ps(out + 12, z);	_mm_storel_pi((__m64*)(out + 16), gb23);
+	_mm_storeu_ps(out + 18, r);	_mm_storeh_pi((__m64*)(out + 22), gb23);
+}
+
+SIMD_TARGET_SSE41 void BackProjector::ProcessSSE41(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const {
+	const __m128 scale = _mm_set1_ps(m_DepthScale);
+	const __m128 nearZ = _mm_set1_ps(m_ColorNear);
+	const __m128 invRange = _mm_set1_ps(m_ColorInvRange);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 sign = _mm_set1_ps(-0.0f);
+
+	size_t i = begin;
+	float* dst = (float*)out;
+	for (; i + 4 <= end; i += 4, dst += 24) {
+		__m128i d = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(depth + i)));
+		__m128 z = _mm_mul_ps(_mm_cvtepi32_ps(d), scale);
+		__m128 x = _mm_mul_ps(_mm_loadu_ps(&m_RayX[i]), z);
+		__m128 y = _mm_mul_ps(_mm_loadu_ps(&m_RayY[i]), z);
+
+		__m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(z, nearZ), invRange), zero), one);
+		__m128 g = _mm_sub_ps(one, _mm_andnot_ps(sign, _mm_sub_ps(_mm_mul_ps(two, t), one)));
+		__m128 b = _mm_sub_ps(one, t);
+
+		StoreInterleaved4(dst, x, y, _mm_xor_ps(z, sign), t, g, b);
+	}
+
+	ProcessScalar(depth, (unsigned char*)dst, i, end);
+}
+
+SIMD_TARGET_AVX2 void BackProjector::ProcessAVX2(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const {
+	const __m256 scale = _mm256_set1_ps(m_DepthScale);
+	const __m256 invRange = _mm256_set1_ps(m_ColorInvRange);
+	const __m256 nearBias = _mm256_set1_ps(-m_ColorNear * m_ColorInvRange);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 two = _mm256_set1_ps(2.0f);
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+
+	size_t i = begin;
+	float* dst = (float*)out;
+	for (; i + 8 <= end; i += 8, dst += 48) {
+		__m256i d = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(depth + i)));
+		__m256 z = _mm256_mul_ps(_mm256_cvtepi32_ps(d), scale);
+		__m256 x = _mm256_mul_ps(_mm256_loadu_ps(&m_RayX[i]), z);
+		__m256 y = _mm256_mul_ps(_mm256_loadu_ps(&m_RayY[i]), z);
+		__m256 nz = _mm256_xor_ps(z, sign);
+
+		__m256 t = _mm256_min_ps(_mm256_max_ps(_mm256_fmadd_ps(z, invRange, nearBias), zero), one);
+		__m256 g = _mm256_sub_ps(one, _mm256_andnot_ps(sign, _mm256_fmsub_ps(two, t, one)));
+		__m256 b = _mm256_sub_ps(one, t);
+
+		StoreInterleaved4(dst, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(nz),
+			_mm256_castps256_ps128(t), _mm256_castps256_ps128(g), _mm256_castps256_ps128(b));
+		StoreInterleaved4(dst + 24, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(nz, 1),
+			_mm256_extractf128_ps(t, 1), _mm256_extractf128_ps(g, 1), _mm256_extractf128_ps(b, 1));
+	}
+
+	ProcessScalar(depth, (unsigned char*)dst, i, end);
+}
+#else
+void BackProjector::ProcessSSE41(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const {
+	ProcessScalar(depth, out, begin, end);
+}
+
+void BackProjector::ProcessAVX2(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const {
+	ProcessScalar(depth, out, begin, end);
+}
+#endif
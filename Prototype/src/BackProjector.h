@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "FrameSource.h"
+#include "Simd.h"
+
+class VertexBufferLayout;
+
+// Where the back-projector writes inside one interleaved vertex
+struct PointLayout {
+	unsigned int stride;		// bytes per vertex
+	int positionOffset;			// byte offset of 3 floats xyz
+	int colorOffset;			// byte offset of 3 floats rgb, -1 when the layout has no colour
+
+	PointLayout(unsigned int stride, int positionOffset, int colorOffset);
+	PointLayout(const VertexBufferLayout& layout);		// element 0 = position, element 1 (if present) = colour
+
+	template<typename L>
+	static PointLayout From() { return PointLayout(L::Stride, (int)L::Offset(0), L::Count > 1 ? (int)L::Offset(1) : -1); }
+};
+
+// Turns raw depth frames into camera space points (camera looks down -z, y up).
+// Per-pixel rays are precomputed once per intrinsics set, so each frame costs one
+// multiply per component; the kernel is dispatched to AVX2 / SSE4.1 / scalar.
+class BackProjector {
+private:
+	CameraIntrinsics m_Intrinsics;
+	PointLayout m_Layout;
+	std::vector<float> m_RayX;				// x / z per pixel (undistorted)
+	std::vector<float> m_RayY;				// y / z per pixel, flipped to y up
+	float m_DepthScale;
+	float m_ColorNear, m_ColorInvRange;		// depth colormap range
+	Simd::Level m_Level;
+public:
+	BackProjector(const CameraIntrinsics& intrinsics, const PointLayout& layout);
+
+	void SetIntrinsics(const CameraIntrinsics& intrinsics);		// rebuilds the ray table only when it changed
+	void SetColorRange(float nearMetres, float farMetres);
+	void SetSimdLevel(Simd::Level level);						// clamped to what the CPU supports
+
+	// writes width * height vertices into `vertices`, pixels without depth land on the origin
+	void Process(const uint16_t* depth, void* vertices) const;
+	// rowCount * width vertices, `vertices` receives the first vertex of `firstRow`
+	void ProcessRows(const uint16_t* depth, void* vertices, int firstRow, int rowCount) const;
+
+	inline const CameraIntrinsics& GetIntrinsics() const { return m_Intrinsics; }
+	inline const PointLayout& GetLayout() const { return m_Layout; }
+	inline Simd::Level GetSimdLevel() const { return m_Level; }
+	inline unsigned int GetPointCount() const { return m_Intrinsics.width * m_Intrinsics.height; }
+
+private:
+	void BuildRayTable();
+	bool IsPackedPositionColor() const;
+	// `out` points at vertex `begin`
+	void ProcessScalar(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const;
+	void ProcessSSE41(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const;
+	void ProcessAVX2(const uint16_t* depth, unsigned char* out, size_t begin, size_t end) const;
+};
@@ -0,0 +1,251 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstring>
+
+const char* GetBlockFormatName(BlockFormat format) {
+	switch (format) {
+		case BlockFormat::None:	return "none";
+		case BlockFormat::BC1:	return "bc1";
+		case BlockFormat::BC4:	return "bc4";
+	}
+	return "?";
+}
+
+bool ParseBlockFormat(const std::string& name, BlockFormat& format) {
+	for (BlockFormat candidate : { BlockFormat::None, BlockFormat::BC1, BlockFormat::BC4 }) {
+		if (name == GetBlockFormatName(candidate)) {
+			format = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t GetBlockCompressedSize(BlockFormat format, int width, int height) {
+	if (format == BlockFormat::None) return (size_t)width * height * 4;
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+// 4x4 texels starting at (bx, by), rows of 16 bytes, edges clamped
+static void FetchBlock(const unsigned char* rgba, int width, int height, int bx, int by, unsigned char block[64]) {
+	for (int y = 0; y < 4; y++) {
+		const unsigned char* row = rgba + (size_t)std::min(by + y, height - 1) * width * 4;
+		if (bx + 4 <= width) {
+			std::memcpy(block + y * 16, row + bx * 4, 16);
+			continue;
+		}
+		for (int x = 0; x < 4; x++)
+			std::memcpy(block + y * 16 + x * 4, row + std::min(bx + x, width - 1) * 4, 4);
+	}
+}
+
+static inline uint16_t To565(const int rgb[3]) {
+	return (uint16_t)(((rgb[0] >> 3) << 11) | ((rgb[1] >> 2) << 5) | (rgb[2] >> 3));
+}
+
+static inline void From565(uint16_t color, int rgb[3]) {
+	int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+struct BC1Palette {
+	uint16_t color0, color1;				// color0 >= color1, four colour mode (or a flat block)
+	uint32_t entries[4];					// what a decoder makes of them, RGB in the low bytes, alpha 0
+};
+
+// endpoints from the bounding box pulled in by 1/16 of its size on each side, which trades
+// the extremes for a lower error over the rest of the block
+static BC1Palette MakeBC1Palette(const int minimum[3], const int maximum[3]) {
+	int low[3], high[3];
+	for (int i = 0; i < 3; i++) {
+		int inset = (maximum[i] - minimum[i]) >> 4;
+		low[i] = minimum[i] + inset;
+		high[i] = maximum[i] - inset;
+	}
+
+	BC1Palette palette;
+	palette.color0 = To565(high);
+	palette.color1 = To565(low);
+
+	int c[4][3];
+	From565(palette.color0, c[0]);
+	From565(palette.color1, c[1]);
+	for (int i = 0; i < 3; i++) {
+		c[2][i] = (2 * c[0][i] + c[1][i]) / 3;
+		c[3][i] = (c[0][i] + 2 * c[1][i]) / 3;
+	}
+	for (int k = 0; k < 4; k++)
+		palette.entries[k] = (uint32_t)c[k][0] | ((uint32_t)c[k][1] << 8) | ((uint32_t)c[k][2] << 16);
+	return palette;
+}
+
+static void WriteBC1(const BC1Palette& palette, uint32_t indices, unsigned char* out) {
+	out[0] = (unsigned char)palette.color0;
+	out[1] = (unsigned char)(palette.color0 >> 8);
+	out[2] = (unsigned char)palette.color1;
+	out[3] = (unsigned char)(palette.color1 >> 8);
+	for (int i = 0; i < 4; i++) out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+static void EncodeBC1(const unsigned char* block, unsigned char* out) {
+	int minimum[3] = { 255, 255, 255 }, maximum[3] = { 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+		for (int c = 0; c < 3; c++) {
+			minimum[c] = std::min(minimum[c], (int)block[i * 4 + c]);
+			maximum[c] = std::max(maximum[c], (int)block[i * 4 + c]);
+		}
+	BC1Palette palette = MakeBC1Palette(minimum, maximum);
+
+	// nearest entry by the sum of absolute differences, the lowest index on a tie
+	uint32_t indices = 0;
+	for (int i = 0; i < 16; i++) {
+		int best = 0x7fffffff, index = 0;
+		for (int k = 0; k < 4; k++) {
+			int distance = 0;
+			for (int c = 0; c < 3; c++) distance += std::abs((int)block[i * 4 + c] - (int)((palette.entries[k] >> (8 * c)) & 0xff));
+			if (distance < best) {
+				best = distance;
+				index = k;
+			}
+		}
+		indices |= (uint32_t)index << (2 * i);
+	}
+	WriteBC1(palette, indices, out);
+}
+
+// 8 value mode: red0 = max > red1 = min, then indices 2..7 step from max towards min
+static inline int BC4Index(int t) {						// t: 0 at the minimum .. 7 at the maximum
+	return t == 7 ? 0 : t == 0 ? 1 : 8 - t;
+}
+
+static void WriteBC4(int minimum, int maximum, const int* indices, unsigned char* out) {
+	out[0] = (unsigned char)maximum;
+	out[1] = (unsigned char)minimum;
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; i++) bits |= (uint64_t)indices[i] << (3 * i);
+	for (int i = 0; i < 6; i++) out[2 + i] = (unsigned char)(bits >> (8 * i));
+}
+
+static void EncodeBC4(const unsigned char* block, unsigned char* out) {
+	int minimum = 255, maximum = 0;
+	for (int i = 0; i < 16; i++) {
+		minimum = std::min(minimum, (int)block[i * 4]);
+		maximum = std::max(maximum, (int)block[i * 4]);
+	}
+
+	int indices[16] = {};
+	if (maximum > minimum) {
+		float scale = 7.0f / (maximum - minimum);
+		for (int i = 0; i < 16; i++)
+			indices[i] = BC4Index((int)((float)(block[i * 4] - minimum) * scale + 0.5f));
+	}
+	WriteBC4(minimum, maximum, indices, out);
+}
+
+#if SIMD_X86
+// per texel |a - b| summed over RGB, four texels as 32 bit lanes; alpha is masked off beforehand
+SIMD_TARGET_SSE41 static inline __m128i Distance(__m128i a, __m128i b) {
+	__m128i difference = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+	return _mm_madd_epi16(_mm_maddubs_epi16(difference, _mm_set1_epi8(1)), _mm_set1_epi16(1));
+}
+
+// same palette and index choice as EncodeBC1, bit for bit
+SIMD_TARGET_SSE41 static void EncodeBC1SSE41(const unsigned char* block, unsigned char* out) {
+	const __m128i rgb = _mm_set1_epi32(0x00ffffff);
+	__m128i rows[4];
+	for (int r = 0; r < 4; r++) rows[r] = _mm_and_si128(_mm_loadu_si128((const __m128i*)(block + r * 16)), rgb);
+
+	__m128i low = _mm_min_epu8(_mm_min_epu8(rows[0], rows[1]), _mm_min_epu8(rows[2], rows[3]));
+	__m128i high = _mm_max_epu8(_mm_max_epu8(rows[0], rows[1]), _mm_max_epu8(rows[2], rows[3]));
+	low = _mm_min_epu8(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(2, 3, 0, 1)));
+	low = _mm_min_epu8(low, _mm_shuffle_epi32(low, _MM_SHUFFLE(1, 0, 3, 2)));
+	high = _mm_max_epu8(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(2, 3, 0, 1)));
+	high = _mm_max_epu8(high, _mm_shuffle_epi32(high, _MM_SHUFFLE(1, 0, 3, 2)));
+
+	uint32_t lowBits = (uint32_t)_mm_cvtsi128_si32(low), highBits = (uint32_t)_mm_cvtsi128_si32(high);
+	int minimum[3], maximum[3];
+	for (int c = 0; c < 3; c++) {
+		minimum[c] = (lowBits >> (8 * c)) & 0xff;
+		maximum[c] = (highBits >> (8 * c)) & 0xff;
+	}
+	BC1Palette palette = MakeBC1Palette(minimum, maximum);
+
+	__m128i entries[4];
+	for (int k = 0; k < 4; k++) entries[k] = _mm_set1_epi32((int)palette.entries[k]);
+	const __m128i weights = _mm_setr_epi32(1, 4, 16, 64);		// 2 bit index of texel x at bit 2x
+
+	uint32_t indices = 0;
+	for (int r = 0; r < 4; r++) {
+		__m128i best = Distance(rows[r], entries[0]);
+		__m128i index = _mm_setzero_si128();
+		for (int k = 1; k < 4; k++) {
+			__m128i distance = Distance(rows[r], entries[k]);
+			index = _mm_blendv_epi8(index, _mm_set1_epi32(k), _mm_cmplt_epi32(distance, best));
+			best = _mm_min_epi32(best, distance);
+		}
+		__m128i bits = _mm_mullo_epi32(index, weights);
+		bits = _mm_add_epi32(bits, _mm_shuffle_epi32(bits, _MM_SHUFFLE(2, 3, 0, 1)));
+		bits = _mm_add_epi32(bits, _mm_shuffle_epi32(bits, _MM_SHUFFLE(1, 0, 3, 2)));
+		indices |= (uint32_t)_mm_cvtsi128_si32(bits) << (8 * r);
+	}
+	WriteBC1(palette, indices, out);
+}
+
+// same as EncodeBC4, bit for bit
+SIMD_TARGET_SSE41 static void EncodeBC4SSE41(const unsigned char* block, unsigned char* out) {
+	// the red bytes of the four rows, gathered into one register
+	const __m128i reds = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	__m128i rows[4];
+	for (int r = 0; r < 4; r++) rows[r] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + r * 16)), reds);
+	__m128i red = _mm_unpacklo_epi64(_mm_unpacklo_epi32(rows[0], rows[1]), _mm_unpacklo_epi32(rows[2], rows[3]));
+
+	__m128i low = _mm_min_epu8(red, _mm_srli_si128(red, 8)), high = _mm_max_epu8(red, _mm_srli_si128(red, 8));
+	low = _mm_min_epu8(low, _mm_srli_si128(low, 4));
+	high = _mm_max_epu8(high, _mm_srli_si128(high, 4));
+	low = _mm_min_epu8(low, _mm_srli_si128(low, 2));
+	high = _mm_max_epu8(high, _mm_srli_si128(high, 2));
+	low = _mm_min_epu8(low, _mm_srli_si128(low, 1));
+	high = _mm_max_epu8(high, _mm_srli_si128(high, 1));
+	int minimum = _mm_cvtsi128_si32(low) & 0xff, maximum = _mm_cvtsi128_si32(high) & 0xff;
+
+	alignas(16) int indices[16] = {};
+	if (maximum > minimum) {
+		const __m128 offset = _mm_set1_ps((float)minimum), scale = _mm_set1_ps(7.0f / (maximum - minimum)), half = _mm_set1_ps(0.5f);
+		const __m128i seven = _mm_set1_epi32(7), eight = _mm_set1_epi32(8), one = _mm_set1_epi32(1), zero = _mm_setzero_si128();
+		__m128i rest = red;
+		for (int q = 0; q < 4; q++, rest = _mm_srli_si128(rest, 4)) {
+			__m128i values = _mm_cvtepu8_epi32(rest);
+			__m128i t = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_cvtepi32_ps(values), offset), scale), half));
+			__m128i index = _mm_sub_epi32(eight, t);
+			index = _mm_blendv_epi8(index, zero, _mm_cmpeq_epi32(t, seven));
+			index = _mm_blendv_epi8(index, one, _mm_cmpeq_epi32(t, zero));
+			_mm_store_si128((__m128i*)(indices + q * 4), index);
+		}
+	}
+	WriteBC4(minimum, maximum, indices, out);
+}
+#endif
+
+void CompressBlocks(BlockFormat format, const unsigned char* rgba, int width, int height, unsigned char* out, Simd::Level level) {
+	if (format == BlockFormat::None) {
+		std::memcpy(out, rgba, GetBlockCompressedSize(format, width, height));
+		return;
+	}
+
+	typedef void (*Encoder)(const unsigned char* block, unsigned char* out);
+	Encoder encode = format == BlockFormat::BC1 ? EncodeBC1 : EncodeBC4;
+#if SIMD_X86
+	if (Simd::Clamp(level) >= Simd::Level::SSE41) encode = format == BlockFormat::BC1 ? EncodeBC1SSE41 : EncodeBC4SSE41;
+#endif
+
+	alignas(16) unsigned char block[64];
+	for (int by = 0; by < height; by += 4)
+		for (int bx = 0; bx < width; bx += 4) {
+			FetchBlock(rgba, width, height, bx, by, block);
+			encode(block, out);
+			out += 8;
+		}
+}
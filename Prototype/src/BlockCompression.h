@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Simd.h"
+
+// GPU block compressed texture formats, 4x4 texels per 8 byte block:
+//
+//   BC1   RGB, two 565 endpoints + 2 bit indices, 0.5 byte/texel (EXT_texture_compression_s3tc)
+//   BC4   one channel, two 8 bit endpoints + 3 bit indices, 0.5 byte/texel (RGTC1, core GL 3.0)
+//
+// The encoder takes the inset bounding box of each block as its endpoints (J.M.P. van Waveren,
+// "Real-Time DXT Compression") and picks every texel's nearest palette entry, so it runs at
+// load time rather than offline. Images whose size isn't a multiple of 4 repeat their edge.
+enum class BlockFormat : uint32_t {
+	None = 0,								// uncompressed RGBA8
+	BC1 = 1,
+	BC4 = 2
+};
+
+const char* GetBlockFormatName(BlockFormat format);
+bool ParseBlockFormat(const std::string& name, BlockFormat& format);		// none | bc1 | bc4
+size_t GetBlockCompressedSize(BlockFormat format, int width, int height);	// also RGBA8 for None
+
+// RGBA8 rows (`width` x `height`) into blocks, left to right then up; BC4 keeps the red channel
+void CompressBlocks(BlockFormat format, const unsigned char* rgba, int width, int height, unsigned char* out,
+	Simd::Level level = Simd::Detect());
@@ -0,0 +1,385 @@
+#include "DepthCodec.h"
+
+#include <cstring>
+#include <iostream>
+
+static const char s_StreamMagic[4] = { 'K', 'V', 'D', '1' };
+
+const char* GetDepthCodecName(DepthCodec codec) {
+	switch (codec) {
+		case DepthCodec::Raw16: return "raw";
+		case DepthCodec::RVL: return "rvl";
+		case DepthCodec::DeltaVByte: return "vbyte";
+	}
+	return "unknown";
+}
+
+bool ParseDepthCodec(const std::string& name, DepthCodec& codec) {
+	if (name == "raw") codec = DepthCodec::Raw16;
+	else if (name == "rvl") codec = DepthCodec::RVL;
+	else if (name == "vbyte") codec = DepthCodec::DeltaVByte;
+	else return false;
+	return true;
+}
+
+
+// RVL: values are written as varints of 3 bit nibbles (bit 3 = more follows),
+// eight nibbles to a little-endian uint32, most significant nibble first
+
+struct NibbleWriter {
+	unsigned char* out;
+	uint32_t word;
+	int nibbles;
+
+	inline void Put(uint32_t value) {
+		do {
+			uint32_t nibble = value & 7;
+			value >>= 3;
+			if (value) nibble |= 8;
+			word = (word << 4) | nibble;
+			if (++nibbles == 8) {
+				std::memcpy(out, &word, 4);
+				out += 4;
+				word = 0;
+				nibbles = 0;
+			}
+		} while (value);
+	}
+
+	inline void Flush() {
+		if (nibbles == 0) return;
+		word <<= 4 * (8 - nibbles);
+		std::memcpy(out, &word, 4);
+		out += 4;
+	}
+};
+
+struct NibbleReader {
+	const unsigned char* in;
+	const unsigned char* end;
+	uint32_t word;
+	int nibbles;
+
+	inline bool Get(uint32_t& value) {
+		value = 0;
+		for (int shift = 0; shift < 33; shift += 3) {
+			if (nibbles == 0) {
+				if (end - in < 4) return false;
+				std::memcpy(&word, in, 4);
+				in += 4;
+				nibbles = 8;
+			}
+			uint32_t nibble = word >> 28;
+			word <<= 4;
+			nibbles--;
+			value |= (nibble & 7) << shift;
+			if (!(nibble & 8)) return true;
+		}
+		return false;		// longer than any value the encoder writes
+	}
+};
+
+static size_t EncodeRVL(const uint16_t* depth, unsigned int count, unsigned char* out) {
+	NibbleWriter writer = { out, 0, 0 };
+	const uint16_t* end = depth + count;
+	int previous = 0;
+
+	while (depth != end) {
+		uint32_t zeros = 0, nonzeros = 0;
+		for (; depth != end && *depth == 0; depth++) zeros++;
+		writer.Put(zeros);
+		for (const uint16_t* p = depth; p != end && *p != 0; p++) nonzeros++;
+		writer.Put(nonzeros);
+
+		for (uint32_t i = 0; i < nonzeros; i++) {
+			int current = *depth++;
+			int delta = current - previous;
+			writer.Put(((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31));
+			previous = current;
+		}
+	}
+
+	writer.Flush();
+	return writer.out - out;
+}
+
+static bool DecodeRVL(const unsigned char* data, size_t bytes, uint16_t* depth, unsigned int count) {
+	NibbleReader reader = { data, data + bytes, 0, 0 };
+	unsigned int position = 0;
+	int previous = 0;
+
+	while (position < count) {
+		uint32_t zeros, nonzeros;
+		if (!reader.Get(zeros) || zeros > count - position) return false;
+		std::memset(depth + position, 0, zeros * sizeof(uint16_t));
+		position += zeros;
+
+		if (!reader.Get(nonzeros) || nonzeros > count - position) return false;
+		for (uint32_t i = 0; i < nonzeros; i++) {
+			uint32_t zigzag;
+			if (!reader.Get(zigzag)) return false;
+			previous += (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+			depth[position++] = (uint16_t)previous;
+		}
+	}
+	return true;
+}
+
+
+// DeltaVByte: a control stream of 2 bits per value (0 = delta is zero, 1 = one byte,
+// 2 = two bytes, 3 is never written) followed by the data stream. Deltas wrap at 16 bits.
+
+static inline unsigned int VByteControlBytes(unsigned int count) {
+	return (count + 3) / 4;
+}
+
+static inline uint16_t ZigZag16(uint16_t current, uint16_t previous) {
+	int16_t delta = (int16_t)(uint16_t)(current - previous);
+	return (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+}
+
+static size_t EncodeVByte(const uint16_t* depth, unsigned int count, unsigned char* out) {
+	unsigned char* control = out;
+	unsigned char* data = out + VByteControlBytes(count);
+	std::memset(control, 0, VByteControlBytes(count));
+
+	uint16_t previous = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		uint16_t zigzag = ZigZag16(depth[i], previous);
+		previous = depth[i];
+
+		unsigned int code = zigzag == 0 ? 0 : zigzag < 256 ? 1 : 2;
+		control[i / 4] |= code << (2 * (i % 4));
+		if (code >= 1) *data++ = (unsigned char)zigzag;
+		if (code == 2) *data++ = (unsigned char)(zigzag >> 8);
+	}
+	return data - out;
+}
+
+// decodes values [begin, count), returns the end of the data stream or nullptr when it runs out
+static const unsigned char* DecodeVByteScalar(const unsigned char* control, const unsigned char* data, const unsigned char* end,
+	uint16_t* depth, unsigned int begin, unsigned int count, uint16_t previous) {
+
+	for (unsigned int i = begin; i < count; i++) {
+		unsigned int code = (control[i / 4] >> (2 * (i % 4))) & 3;
+		if (code == 3 || end - data < (ptrdiff_t)code) return nullptr;
+
+		uint16_t zigzag = 0;
+		if (code >= 1) zigzag = data[0];
+		if (code == 2) zigzag |= data[1] << 8;
+		data += code;
+
+		previous = (uint16_t)(previous + ((zigzag >> 1) ^ (uint16_t)-(zigzag & 1)));
+		depth[i] = previous;
+	}
+	return data;
+}
+
+#if SIMD_X86
+// pshufb masks that expand one control byte (4 values) into 4 zero-extended uint16s
+struct VByteShuffle {
+	alignas(16) uint8_t mask[16];
+	unsigned int length;
+};
+
+static const VByteShuffle* GetVByteShuffleTable() {
+	static VByteShuffle table[256];
+	static bool built = [] {
+		for (unsigned int control = 0; control < 256; control++) {
+			VByteShuffle& entry = table[control];
+			std::memset(entry.mask, 0x80, sizeof(entry.mask));
+			unsigned int offset = 0;
+			for (unsigned int j = 0; j < 4; j++) {
+				unsigned int code = (control >> (2 * j)) & 3;
+				if (code >= 1) entry.mask[2 * j] = (uint8_t)offset++;
+				if (code >= 2) entry.mask[2 * j + 1] = (uint8_t)offset++;
+			}
+			entry.length = offset;
+		}
+		return true;
+	}();
+	(void)built;
+	return table;
+}
+
+SIMD_TARGET_SSE41 static bool DecodeVByteSSE41(const unsigned char* control, const unsigned char* data, const unsigned char* end,
+	uint16_t* depth, unsigned int count) {
+
+	const VByteShuffle* table = GetVByteShuffleTable();
+	const __m128i one = _mm_set1_epi16(1);
+	const __m128i broadcastLast = _mm_set_epi8(15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14, 15, 14);
+	__m128i previous = _mm_setzero_si128();
+
+	// 8 values per step; the second 16 byte load starts at most 8 bytes in, so keep 24 in hand
+	unsigned int i = 0;
+	for (; i + 8 <= count && end - data >= 24; i += 8) {
+		unsigned int c0 = control[i / 4], c1 = control[i / 4 + 1];
+		if ((c0 & (c0 >> 1) & 0x55) | (c1 & (c1 >> 1) & 0x55)) return false;		// code 3
+
+		__m128i lo = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), _mm_load_si128((const __m128i*)table[c0].mask));
+		data += table[c0].length;
+		__m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)data), _mm_load_si128((const __m128i*)table[c1].mask));
+		data += table[c1].length;
+
+		// undo the zigzag, then an inclusive prefix sum across the 8 lanes
+		__m128i zigzag = _mm_unpacklo_epi64(lo, hi);
+		__m128i delta = _mm_xor_si128(_mm_srli_epi16(zigzag, 1), _mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(zigzag, one)));
+		delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 2));
+		delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 4));
+		delta = _mm_add_epi16(delta, _mm_slli_si128(delta, 8));
+		__m128i values = _mm_add_epi16(delta, previous);
+
+		_mm_storeu_si128((__m128i*)(depth + i), values);
+		previous = _mm_shuffle_epi8(values, broadcastLast);
+	}
+
+	uint16_t last = i ? depth[i - 1] : 0;
+	return DecodeVByteScalar(control, data, end, depth, i, count, last) == end;
+}
+#endif
+
+static bool DecodeVByte(const unsigned char* data, size_t bytes, uint16_t* depth, unsigned int count, Simd::Level level) {
+	unsigned int controlBytes = VByteControlBytes(count);
+	if (bytes < controlBytes) return false;
+
+	const unsigned char* control = data;
+	const unsigned char* end = data + bytes;
+	data += controlBytes;
+
+#if SIMD_X86
+	// the 16 bit prefix sum doesn't gain from 256 bit lanes, AVX2 machines run the SSE path
+	if (Simd::Clamp(level) >= Simd::Level::SSE41) return DecodeVByteSSE41(control, data, end, depth, count);
+#endif
+	return DecodeVByteScalar(control, data, end, depth, 0, count, 0) == end;
+}
+
+
+size_t GetMaxEncodedSize(DepthCodec codec, unsigned int count) {
+	switch (codec) {
+		case DepthCodec::Raw16: return (size_t)count * sizeof(uint16_t);
+		case DepthCodec::RVL: return (size_t)count * 3 + 32;		// 6 nibbles for a 17 bit zigzag delta, plus run lengths
+		case DepthCodec::DeltaVByte: return VByteControlBytes(count) + (size_t)count * sizeof(uint16_t);
+	}
+	return 0;
+}
+
+size_t EncodeDepth(DepthCodec codec, const uint16_t* depth, unsigned int count, void* out) {
+	switch (codec) {
+		case DepthCodec::Raw16:
+			std::memcpy(out, depth, (size_t)count * sizeof(uint16_t));
+			return (size_t)count * sizeof(uint16_t);
+		case DepthCodec::RVL: return EncodeRVL(depth, count, (unsigned char*)out);
+		case DepthCodec::DeltaVByte: return EncodeVByte(depth, count, (unsigned char*)out);
+	}
+	return 0;
+}
+
+bool DecodeDepth(DepthCodec codec, const void* data, size_t bytes, uint16_t* depth, unsigned int count, Simd::Level level) {
+	switch (codec) {
+		case DepthCodec::Raw16:
+			if (bytes != (size_t)count * sizeof(uint16_t)) return false;
+			std::memcpy(depth, data, bytes);
+			return true;
+		case DepthCodec::RVL: return DecodeRVL((const unsigned char*)data, bytes, depth, count);
+		case DepthCodec::DeltaVByte: return DecodeVByte((const unsigned char*)data, bytes, depth, count, level);
+	}
+	return false;
+}
+
+
+DepthStreamWriter::DepthStreamWriter(const std::string& filepath, const CameraIntrinsics& intrinsics, double frameRate, DepthCodec codec)
+	:m_Stream(filepath, std::ios::binary | std::ios::trunc), m_Header(), m_FrameCount(0), m_RawBytes(0), m_EncodedBytes(0) {
+
+	if (!m_Stream.is_open()) {
+		std::cout << "Warning: could not create depth stream " << filepath << std::endl;
+		return;
+	}
+
+	std::memcpy(m_Header.magic, s_StreamMagic, 4);
+	m_Header.codec = (uint32_t)codec;
+	m_Header.width = intrinsics.width;
+	m_Header.height = intrinsics.height;
+	m_Header.fx = intrinsics.fx;
+	m_Header.fy = intrinsics.fy;
+	m_Header.cx = intrinsics.cx;
+	m_Header.cy = intrinsics.cy;
+	m_Header.depthScale = intrinsics.depthScale;
+	m_Header.k1 = intrinsics.k1;
+	m_Header.k2 = intrinsics.k2;
+	m_Header.k3 = intrinsics.k3;
+	m_Header.p1 = intrinsics.p1;
+	m_Header.p2 = intrinsics.p2;
+	m_Header.frameRate = frameRate;
+	m_Stream.write((const char*)&m_Header, sizeof(m_Header));
+
+	m_Encoded.resize(GetMaxEncodedSize(codec, intrinsics.width * intrinsics.height));
+}
+
+bool DepthStreamWriter::WriteFrame(double timestamp, const uint16_t* depth) {
+	if (!m_Stream.is_open()) return false;
+
+	unsigned int count = m_Header.width * m_Header.height;
+	DepthStreamFrame frame = {};
+	frame.timestamp = timestamp;
+	frame.encodedBytes = (uint32_t)EncodeDepth((DepthCodec)m_Header.codec, depth, count, m_Encoded.data());
+
+	m_Stream.write((const char*)&frame, sizeof(frame));
+	m_Stream.write((const char*)m_Encoded.data(), frame.encodedBytes);
+	if (!m_Stream) return false;
+
+	m_FrameCount++;
+	m_RawBytes += (size_t)count * sizeof(uint16_t);
+	m_EncodedBytes += frame.encodedBytes;
+	return true;
+}
+
+
+DepthStreamReader::DepthStreamReader(const std::string& filepath)
+	:m_FilePath(filepath), m_Stream(filepath, std::ios::binary), m_Header(), m_Intrinsics(), m_FrameIndex(0), m_Valid(false) {
+
+	if (!m_Stream.read((char*)&m_Header, sizeof(m_Header))) {
+		std::cout << "Warning: could not open depth stream " << filepath << std::endl;
+		return;
+	}
+	if (std::memcmp(m_Header.magic, s_StreamMagic, 4) != 0 || m_Header.codec > (uint32_t)DepthCodec::DeltaVByte
+		|| m_Header.width <= 0 || m_Header.height <= 0 || m_Header.width > 8192 || m_Header.height > 8192 || !(m_Header.frameRate > 0.0)) {
+		std::cout << "Warning: " << filepath << " is not a .kvd depth stream" << std::endl;
+		return;
+	}
+
+	m_Intrinsics = { m_Header.width, m_Header.height, m_Header.fx, m_Header.fy, m_Header.cx, m_Header.cy,
+		m_Header.depthScale, m_Header.k1, m_Header.k2, m_Header.k3, m_Header.p1, m_Header.p2 };
+	m_Valid = true;
+}
+
+bool DepthStreamReader::ReadFrame(DepthFrame& frame) {
+	if (!m_Valid) return false;
+
+	if (!ReadNext(frame)) {
+		// loop back to the first frame
+		m_Stream.clear();
+		m_Stream.seekg(sizeof(DepthStreamHeader));
+		if (!ReadNext(frame)) return false;
+	}
+
+	m_FrameIndex++;
+	return true;
+}
+
+bool DepthStreamReader::ReadNext(DepthFrame& frame) {
+	unsigned int count = m_Header.width * m_Header.height;
+
+	DepthStreamFrame header;
+	if (!m_Stream.read((char*)&header, sizeof(header))) return false;
+	if (header.encodedBytes > GetMaxEncodedSize(GetCodec(), count)) return false;
+
+	m_Encoded.resize(header.encodedBytes);
+	if (!m_Stream.read((char*)m_Encoded.data(), header.encodedBytes)) return false;
+
+	frame.index = m_FrameIndex;
+	frame.timestamp = m_FrameIndex / GetFrameRate();
+	frame.width = m_Header.width;
+	frame.height = m_Header.height;
+	frame.depth.resize(count);
+	return DecodeDepth(GetCodec(), m_Encoded.data(), m_Encoded.size(), frame.depth.data(), count);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "FrameSource.h"
+#include "Simd.h"
+
+// Lossless compression of raw uint16 depth frames.
+//
+//   Raw16        width * height uint16, no compression
+//   RVL          run length of zeros / non-zeros + zigzag deltas as 3 bit nibble varints
+//                (Wilson, "Fast Lossless Depth Image Compression"); best ratio, scalar decode
+//   DeltaVByte   zigzag delta to the previous pixel, 2 bit control per value (same, 1 or 2 bytes),
+//                controls and data in two streams so a pshufb decodes 8 pixels at a time
+//
+// Every codec round-trips bit exact. Decoders never read or write outside the buffers
+// they are given and return false on truncated or corrupt input.
+
+enum class DepthCodec : uint32_t {
+	Raw16 = 0,
+	RVL = 1,
+	DeltaVByte = 2
+};
+
+const char* GetDepthCodecName(DepthCodec codec);
+bool ParseDepthCodec(const std::string& name, DepthCodec& codec);		// raw | rvl | vbyte
+
+size_t GetMaxEncodedSize(DepthCodec codec, unsigned int count);			// worst case output of EncodeDepth
+size_t EncodeDepth(DepthCodec codec, const uint16_t* depth, unsigned int count, void* out);		// returns bytes written
+bool DecodeDepth(DepthCodec codec, const void* data, size_t bytes, uint16_t* depth, unsigned int count,
+	Simd::Level level = Simd::Detect());
+
+// Framed .kvd stream: a 64 byte header, then per frame a DepthStreamFrame followed by
+// its encoded payload. Sequential only; use a .kvr recording when seeking matters.
+struct DepthStreamHeader {
+	char magic[4];					// "KVD1"
+	uint32_t codec;
+	int32_t width, height;
+	float fx, fy, cx, cy;
+	float depthScale;
+	float k1, k2, k3, p1, p2;
+	double frameRate;
+};
+
+struct DepthStreamFrame {
+	double timestamp;
+	uint32_t encodedBytes;
+	uint32_t reserved;
+};
+
+static_assert(sizeof(DepthStreamHeader) == 64, "DepthStreamHeader layout changed");
+static_assert(sizeof(DepthStreamFrame) == 16, "DepthStreamFrame layout changed");
+
+class DepthStreamWriter {
+private:
+	std::ofstream m_Stream;
+	DepthStreamHeader m_Header;
+	std::vector<unsigned char> m_Encoded;
+	unsigned int m_FrameCount;
+	size_t m_RawBytes, m_EncodedBytes;
+public:
+	DepthStreamWriter(const std::string& filepath, const CameraIntrinsics& intrinsics, double frameRate, DepthCodec codec);
+
+	bool WriteFrame(double timestamp, const uint16_t* depth);
+
+	inline bool IsOpen() const { return m_Stream.is_open(); }
+	inline unsigned int GetFrameCount() const { return m_FrameCount; }
+	inline double GetRatio() const { return m_EncodedBytes ? (double)m_RawBytes / m_EncodedBytes : 0.0; }
+};
+
+// Plays a .kvd stream as a frame source, looping at the end like FileReplaySource
+class DepthStreamReader : public FrameSource {
+private:
+	std::string m_FilePath;
+	std::ifstream m_Stream;
+	DepthStreamHeader m_Header;
+	CameraIntrinsics m_Intrinsics;
+	std::vector<unsigned char> m_Encoded;
+	unsigned int m_FrameIndex;
+	bool m_Valid;
+public:
+	DepthStreamReader(const std::string& filepath);
+
+	bool ReadFrame(DepthFrame& frame) override;
+	inline const CameraIntrinsics& GetIntrinsics() const override { return m_Intrinsics; }
+	inline double GetFrameRate() const override { return m_Header.frameRate; }
+	inline bool IsOpen() const { return m_Valid; }
+	inline DepthCodec GetCodec() const { return (DepthCodec)m_Header.codec; }
+
+private:
+	bool ReadNext(DepthFrame& frame);
+};
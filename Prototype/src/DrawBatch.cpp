@@ -0,0 +1,124 @@
+#include "DrawBatch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+
+#include "GLState.h"
+#include "VertexArray.h"
+#include "VertexBufferLayout.h"
+
+// the texture buffer caps the batch size: GL 3.3 only promises 65536 texels
+static unsigned int ClampMaxDraws(unsigned int maxDraws) {
+	GLint texels = 0;
+	GLCall(glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &texels));
+	unsigned int limit = std::max(texels, 4) / 4;
+	if (maxDraws > limit) {
+		std::cout << "Warning: draw batch of " << maxDraws << " limited to " << limit << " draws by GL_MAX_TEXTURE_BUFFER_SIZE" << std::endl;
+		return limit;
+	}
+	return maxDraws;
+}
+
+static std::vector<unsigned int> DrawIdSequence(unsigned int count) {
+	std::vector<unsigned int> ids(count);
+	for (unsigned int i = 0; i < count; i++) ids[i] = i;
+	return ids;
+}
+
+DrawBatch::DrawBatch(VertexArray& va, unsigned int drawIdLocation, unsigned int maxDraws)
+	:m_VertexArray(&va), m_MaxDraws(ClampMaxDraws(maxDraws)), m_IndirectBuffer(0), m_DataBuffer(0), m_DataTexture(0),
+	m_DrawIds(DrawIdSequence(m_MaxDraws).data(), m_MaxDraws * sizeof(unsigned int)), m_DrawIdLocation(drawIdLocation), m_Path(BatchPath::Instanced) {
+
+	va.AddInstanceBuffer(m_DrawIds, Layout<attrib::uint1>(), drawIdLocation);
+	va.Unbind();
+
+	GLCall(glGenBuffers(1, &m_DataBuffer));
+	GLState::BindBuffer(GL_TEXTURE_BUFFER, m_DataBuffer);
+	GLCall(glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)m_MaxDraws * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW));
+	GLCall(glGenTextures(1, &m_DataTexture));
+	GLState::BindTexture(GL_TEXTURE_BUFFER, m_DataTexture);
+	GLCall(glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_DataBuffer));
+	GLState::BindTexture(GL_TEXTURE_BUFFER, 0);
+	GLState::BindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	if (IsIndirectSupported()) {
+		GLCall(glGenBuffers(1, &m_IndirectBuffer));
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+		GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)m_MaxDraws * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW));
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		m_Path = BatchPath::Indirect;
+	}
+
+	m_Commands.reserve(m_MaxDraws);
+	m_Models.reserve(m_MaxDraws);
+}
+
+DrawBatch::~DrawBatch() {
+	if (m_IndirectBuffer) GLState::DeleteBuffer(m_IndirectBuffer);
+	GLState::DeleteTexture(m_DataTexture);
+	GLState::DeleteBuffer(m_DataBuffer);
+}
+
+bool DrawBatch::IsIndirectSupported() {
+	return (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect) && (GLEW_VERSION_4_2 || GLEW_ARB_base_instance);
+}
+
+void DrawBatch::SetPath(BatchPath path) {
+	m_Path = path == BatchPath::Indirect && m_IndirectBuffer ? BatchPath::Indirect : BatchPath::Instanced;
+}
+
+void DrawBatch::Clear() {
+	m_Commands.clear();
+	m_Models.clear();
+}
+
+bool DrawBatch::Add(const MeshRange& mesh, const glm::mat4& model) {
+	if (m_Models.size() >= m_MaxDraws) return false;
+
+	DrawElementsIndirectCommand* last = m_Commands.empty() ? nullptr : &m_Commands.back();
+	if (last && last->count == mesh.indexCount && last->firstIndex == mesh.firstIndex && last->baseVertex == mesh.baseVertex)
+		last->instanceCount++;
+	else
+		m_Commands.push_back({ mesh.indexCount, 1, mesh.firstIndex, mesh.baseVertex, (unsigned int)m_Models.size() });
+
+	m_Models.push_back(model);
+	return true;
+}
+
+void DrawBatch::Upload() {
+	// orphan + refill, the driver hands out fresh storage while last frame's draws still read the old one
+	GLState::BindBuffer(GL_TEXTURE_BUFFER, m_DataBuffer);
+	GLCall(glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)m_MaxDraws * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW));
+	GLCall(glBufferSubData(GL_TEXTURE_BUFFER, 0, (GLsizeiptr)m_Models.size() * sizeof(glm::mat4), m_Models.data()));
+	GLState::BindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	if (m_Path == BatchPath::Indirect) {
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+		GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)m_MaxDraws * sizeof(DrawElementsIndirectCommand), nullptr, GL_STREAM_DRAW));
+		GLCall(glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, (GLsizeiptr)m_Commands.size() * sizeof(DrawElementsIndirectCommand), m_Commands.data()));
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+}
+
+void DrawBatch::Submit() const {
+	if (m_Commands.empty()) return;
+
+	GLState::BindTexture(0, GL_TEXTURE_BUFFER, m_DataTexture);
+
+	if (m_Path == BatchPath::Indirect) {
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_IndirectBuffer);
+		GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, (GLsizei)m_Commands.size(), 0));
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+		return;
+	}
+
+	// no base instance: start the draw id attribute at the command's first draw instead
+	m_DrawIds.Bind();
+	for (const DrawElementsIndirectCommand& command : m_Commands) {
+		GLCall(glVertexAttribIPointer(m_DrawIdLocation, 1, GL_UNSIGNED_INT, 0, (const void*)((uintptr_t)command.baseInstance * sizeof(unsigned int))));
+		GLCall(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT,
+			(const void*)((uintptr_t)command.firstIndex * sizeof(unsigned int)), command.instanceCount, command.baseVertex));
+	}
+	GLCall(glVertexAttribIPointer(m_DrawIdLocation, 1, GL_UNSIGNED_INT, 0, nullptr));
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+#include "VertexBuffer.h"
+
+class VertexArray;
+
+// Layout glMultiDrawElementsIndirect reads from GL_DRAW_INDIRECT_BUFFER
+struct DrawElementsIndirectCommand {
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;				// first draw of this command, the draw id of its instance 0
+};
+
+// Part of a shared index buffer that makes up one mesh
+struct MeshRange {
+	unsigned int indexCount;
+	unsigned int firstIndex;
+	int baseVertex;
+};
+
+enum class BatchPath {
+	Indirect,								// one glMultiDrawElementsIndirect (GL 4.3 / ARB_multi_draw_indirect + ARB_base_instance)
+	Instanced								// one glDrawElementsInstancedBaseVertex per command (GL 3.3)
+};
+
+// Collects many draws of meshes that live in one vertex array + index buffer and submits
+// them together through Renderer::Draw(va, ib, shader, batch). Every draw carries a model
+// matrix; they go into a texture buffer the vertex shader reads with texelFetch, indexed by
+// a per-instance draw id attribute (see res/shaders/Batch.shader). Consecutive draws of the
+// same mesh share one command as instances, so sorting by mesh helps the GL 3.3 path.
+class DrawBatch {
+private:
+	const VertexArray* m_VertexArray;		// the one carrying the draw id attribute
+	unsigned int m_MaxDraws;
+	unsigned int m_IndirectBuffer;
+	unsigned int m_DataBuffer;				// 4 RGBA32F texels (model matrix columns) per draw
+	unsigned int m_DataTexture;
+	VertexBuffer m_DrawIds;					// 0 .. maxDraws-1, read once per instance
+	unsigned int m_DrawIdLocation;
+	BatchPath m_Path;
+	std::vector<DrawElementsIndirectCommand> m_Commands;
+	std::vector<glm::mat4> m_Models;
+public:
+	// adds the draw id attribute to `va` at `drawIdLocation`
+	DrawBatch(VertexArray& va, unsigned int drawIdLocation, unsigned int maxDraws);
+	~DrawBatch();
+
+	DrawBatch(const DrawBatch&) = delete;
+	DrawBatch& operator=(const DrawBatch&) = delete;
+
+	void Clear();
+	bool Add(const MeshRange& mesh, const glm::mat4& model);		// false once maxDraws is reached
+	void Upload();							// commands + per-draw data to the GPU, after the last Add
+
+	// with the vertex array, index buffer and shader bound; the draw data is on texture unit 0
+	void Submit() const;
+
+	void SetPath(BatchPath path);			// Indirect falls back to Instanced where unsupported
+	static bool IsIndirectSupported();
+
+	inline const VertexArray& GetVertexArray() const { return *m_VertexArray; }
+	inline BatchPath GetPath() const { return m_Path; }
+	inline unsigned int GetDrawCount() const { return (unsigned int)m_Models.size(); }
+	inline unsigned int GetCommandCount() const { return (unsigned int)m_Commands.size(); }
+	inline unsigned int GetSubmitCalls() const { return m_Path == BatchPath::Indirect ? (m_Commands.empty() ? 0 : 1) : GetCommandCount(); }
+};
@@ -0,0 +1,244 @@
+#include "FileWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif defined(__linux__)
+	#include <poll.h>
+	#include <sys/inotify.h>
+	#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const int QuietMilliseconds = 100;			// an editor's save is several events, report it once
+
+std::string FileWatcher::Normalize(const std::string& path) {
+	std::error_code error;
+	fs::path absolute = fs::absolute(fs::path(path), error);
+	std::string key = (error ? fs::path(path) : absolute).lexically_normal().generic_string();
+#ifdef _WIN32
+	std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+	return key;
+}
+
+void FileWatcher::Collect(const std::string& directory, const std::string& name, std::vector<std::string>& changed) const {
+	std::string key = Normalize(directory + "/" + name);
+	for (size_t i = 0; i < m_Keys.size(); i++)
+		if (m_Keys[i] == key && std::find(changed.begin(), changed.end(), m_Files[i]) == changed.end())
+			changed.push_back(m_Files[i]);
+}
+
+#if defined(_WIN32)
+
+struct FileWatcher::Watch {
+	std::string directory;
+	HANDLE handle;
+	OVERLAPPED overlapped;
+	DWORD buffer[4096];						// FILE_NOTIFY_INFORMATION records, DWORD aligned
+};
+
+static const DWORD NotifyFilter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+
+static bool Listen(HANDLE handle, OVERLAPPED& overlapped, DWORD* buffer, DWORD size) {
+	return ReadDirectoryChangesW(handle, buffer, size, FALSE, NotifyFilter, nullptr, &overlapped, nullptr) != 0;
+}
+
+bool FileWatcher::Open(const std::vector<std::string>& directories) {
+	if (directories.size() > MAXIMUM_WAIT_OBJECTS) return false;
+
+	for (const std::string& directory : directories) {
+		std::unique_ptr<Watch> watch(new Watch());
+		watch->directory = directory;
+		watch->handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (watch->handle == INVALID_HANDLE_VALUE) continue;				// e.g. a missing #include's directory
+
+		watch->overlapped.hEvent = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+		bool listening = watch->overlapped.hEvent && Listen(watch->handle, watch->overlapped, watch->buffer, sizeof(watch->buffer));
+		m_Watches.push_back(std::move(watch));
+		if (!listening) return false;
+	}
+	return !m_Watches.empty();
+}
+
+bool FileWatcher::Wait(std::vector<std::string>& changed, int milliseconds) {
+	HANDLE events[MAXIMUM_WAIT_OBJECTS];
+	for (size_t i = 0; i < m_Watches.size(); i++) events[i] = m_Watches[i]->overlapped.hEvent;
+
+	DWORD result = WaitForMultipleObjects((DWORD)m_Watches.size(), events, FALSE, milliseconds);
+	if (result < WAIT_OBJECT_0 || result >= WAIT_OBJECT_0 + m_Watches.size()) return false;
+
+	Watch& watch = *m_Watches[result - WAIT_OBJECT_0];
+	DWORD bytes = 0;
+	if (GetOverlappedResult(watch.handle, &watch.overlapped, &bytes, FALSE)) {
+		if (bytes == 0) {												// the buffer overflowed, assume the worst
+			for (size_t i = 0; i < m_Keys.size(); i++)
+				if (fs::path(m_Keys[i]).parent_path().generic_string() == watch.directory) Collect(watch.directory, fs::path(m_Keys[i]).filename().string(), changed);
+		}
+		for (DWORD offset = 0; bytes > 0;) {
+			const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)((const unsigned char*)watch.buffer + offset);
+			if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+				int wide = (int)(info->FileNameLength / sizeof(WCHAR));
+				int length = WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide, nullptr, 0, nullptr, nullptr);
+				std::string name(length, '\0');
+				WideCharToMultiByte(CP_UTF8, 0, info->FileName, wide, &name[0], length, nullptr, nullptr);
+				Collect(watch.directory, name, changed);
+			}
+			if (!info->NextEntryOffset) break;
+			offset += info->NextEntryOffset;
+		}
+	}
+	ResetEvent(watch.overlapped.hEvent);
+	Listen(watch.handle, watch.overlapped, watch.buffer, sizeof(watch.buffer));
+	return true;
+}
+
+void FileWatcher::Close() {
+	for (std::unique_ptr<Watch>& watch : m_Watches) {
+		if (watch->handle != INVALID_HANDLE_VALUE) {
+			DWORD bytes = 0;
+			if (CancelIoEx(watch->handle, &watch->overlapped)) GetOverlappedResult(watch->handle, &watch->overlapped, &bytes, TRUE);
+			CloseHandle(watch->handle);
+		}
+		if (watch->overlapped.hEvent) CloseHandle(watch->overlapped.hEvent);
+	}
+	m_Watches.clear();
+}
+
+#elif defined(__linux__)
+
+struct FileWatcher::Watch {
+	std::string directory;
+	int descriptor;
+};
+
+bool FileWatcher::Open(const std::vector<std::string>& directories) {
+	m_Notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_Notify < 0) return false;
+
+	for (const std::string& directory : directories) {
+		int descriptor = inotify_add_watch(m_Notify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);		// not IN_MODIFY, that fires mid-write
+		if (descriptor < 0) continue;										// e.g. a missing #include's directory
+		m_Watches.emplace_back(new Watch{ directory, descriptor });
+	}
+	return !m_Watches.empty();
+}
+
+bool FileWatcher::Wait(std::vector<std::string>& changed, int milliseconds) {
+	pollfd request = { m_Notify, POLLIN, 0 };
+	if (poll(&request, 1, milliseconds) <= 0) return false;
+
+	alignas(inotify_event) char buffer[4096];
+	bool any = false;
+	for (ssize_t length; (length = read(m_Notify, buffer, sizeof(buffer))) > 0;) {
+		for (ssize_t offset = 0; offset < length;) {
+			const inotify_event* event = (const inotify_event*)(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+			any = true;
+			if (!event->len) continue;
+			for (const std::unique_ptr<Watch>& watch : m_Watches)
+				if (watch->descriptor == event->wd) Collect(watch->directory, event->name, changed);
+		}
+	}
+	return any;
+}
+
+void FileWatcher::Close() {
+	if (m_Notify >= 0) close(m_Notify);					// drops the watches with it
+	m_Notify = -1;
+	m_Watches.clear();
+}
+
+#else
+
+struct FileWatcher::Watch {
+	std::string directory;
+	std::vector<std::pair<size_t, fs::file_time_type>> files;		// index into m_Files, last write seen
+};
+
+bool FileWatcher::Open(const std::vector<std::string>& directories) {
+	for (const std::string& directory : directories) {
+		std::unique_ptr<Watch> watch(new Watch{ directory, {} });
+		for (size_t i = 0; i < m_Keys.size(); i++) {
+			if (fs::path(m_Keys[i]).parent_path().generic_string() != directory) continue;
+			std::error_code error;
+			watch->files.emplace_back(i, fs::last_write_time(m_Keys[i], error));
+		}
+		m_Watches.push_back(std::move(watch));
+	}
+	return true;
+}
+
+bool FileWatcher::Wait(std::vector<std::string>& changed, int milliseconds) {
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+
+	bool any = false;
+	for (std::unique_ptr<Watch>& watch : m_Watches) {
+		for (auto& file : watch->files) {
+			std::error_code error;
+			fs::file_time_type time = fs::last_write_time(m_Keys[file.first], error);
+			if (error || time == file.second) continue;
+			file.second = time;
+			Collect(watch->directory, fs::path(m_Keys[file.first]).filename().string(), changed);
+			any = true;
+		}
+	}
+	return any;
+}
+
+void FileWatcher::Close() {
+	m_Watches.clear();
+}
+
+#endif
+
+FileWatcher::FileWatcher(const std::vector<std::string>& files, Callback callback)
+	:m_Notify(-1), m_Callback(std::move(callback)), m_Stopping(false), m_Watching(false) {
+
+	std::vector<std::string> directories;
+	for (const std::string& file : files) {
+		std::string key = Normalize(file);
+		if (std::find(m_Keys.begin(), m_Keys.end(), key) != m_Keys.end()) continue;
+		m_Files.push_back(file);
+		m_Keys.push_back(key);
+
+		std::string directory = fs::path(key).parent_path().generic_string();
+		if (std::find(directories.begin(), directories.end(), directory) == directories.end())
+			directories.push_back(directory);
+	}
+
+	if (!Open(directories)) {
+		std::cout << "Failed to watch " << directories.size() << " director" << (directories.size() == 1 ? "y" : "ies") << " for changes" << std::endl;
+		Close();
+		return;
+	}
+	m_Watching = true;
+	m_Thread = std::thread(&FileWatcher::Run, this);
+}
+
+FileWatcher::~FileWatcher() {
+	m_Stopping = true;
+	if (m_Thread.joinable()) m_Thread.join();
+	Close();
+}
+
+void FileWatcher::Run() {
+	std::vector<std::string> changed;
+	auto last = std::chrono::steady_clock::now();
+
+	while (!m_Stopping) {
+		if (Wait(changed, 50)) last = std::chrono::steady_clock::now();		// short, so the destructor doesn't wait long
+		else if (!changed.empty() && std::chrono::steady_clock::now() - last >= std::chrono::milliseconds(QuietMilliseconds)) {
+			m_Callback(changed);
+			changed.clear();
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Calls back when any of a set of files is written. A background thread watches the files'
+// directories (ReadDirectoryChangesW on Windows, inotify on Linux, last-write times elsewhere),
+// so editors that save through a temporary file and a rename are seen too. Changes are
+// collected until the directories stay quiet for a moment, then reported in one call on the
+// watcher thread.
+class FileWatcher {
+public:
+	using Callback = std::function<void(const std::vector<std::string>& changed)>;		// paths as passed to the constructor
+private:
+	std::vector<std::string> m_Files;		// as passed in
+	std::vector<std::string> m_Keys;		// normalized, to match what the OS reports
+	struct Watch;							// one per directory, defined per platform
+	std::vector<std::unique_ptr<Watch>> m_Watches;
+	int m_Notify;							// inotify instance, Linux only
+	Callback m_Callback;
+	std::atomic<bool> m_Stopping;
+	bool m_Watching;
+	std::thread m_Thread;
+public:
+	FileWatcher(const std::vector<std::string>& files, Callback callback);
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	inline bool IsWatching() const { return m_Watching; }
+	inline const std::vector<std::string>& GetFiles() const { return m_Files; }
+
+	static std::string Normalize(const std::string& path);
+
+private:
+	bool Open(const std::vector<std::string>& directories);
+	bool Wait(std::vector<std::string>& changed, int milliseconds);		// true if anything happened
+	void Run();
+	void Close();
+	void Collect(const std::string& directory, const std::string& name, std::vector<std::string>& changed) const;
+};
@@ -0,0 +1,57 @@
+#include "FrameProducer.h"
+
+#include <chrono>
+
+FrameProducer::FrameProducer(FrameSource& source)
+	:m_Source(source), m_Running(false), m_Exhausted(false), m_Produced(0), m_Dropped(0), m_Skipped(0) {}
+
+FrameProducer::~FrameProducer() {
+	Stop();
+}
+
+void FrameProducer::Start() {
+	if (m_Running.exchange(true)) return;
+	m_Thread = std::thread(&FrameProducer::Run, this);
+}
+
+void FrameProducer::Stop() {
+	m_Running = false;
+	if (m_Thread.joinable()) m_Thread.join();
+}
+
+const DepthFrame* FrameProducer::AcquireLatest() {
+	unsigned int skipped = 0;
+	const DepthFrame* frame = m_Ring.BeginReadLatest(&skipped);
+	m_Skipped += skipped;
+	return frame;
+}
+
+void FrameProducer::Release() {
+	m_Ring.EndRead();
+}
+
+void FrameProducer::Run() {
+	using clock = std::chrono::steady_clock;
+	const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / m_Source.GetFrameRate()));
+	auto next = clock::now();
+
+	while (m_Running) {
+		// write straight into the ring when there is room, otherwise keep the source moving and drop
+		DepthFrame* slot = m_Ring.BeginWrite();
+		DepthFrame& frame = slot ? *slot : m_Scratch;
+
+		if (!m_Source.ReadFrame(frame)) {
+			m_Exhausted = true;
+			break;
+		}
+
+		if (slot) m_Ring.EndWrite();
+		else m_Dropped++;
+		m_Produced++;
+
+		next += period;
+		auto now = clock::now();
+		if (next < now) next = now;					// fell behind, don't try to catch up in a burst
+		std::this_thread::sleep_until(next);
+	}
+}
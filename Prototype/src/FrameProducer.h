@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "FrameSource.h"
+#include "FrameRing.h"
+
+// Pulls frames from a FrameSource on its own thread at the source frame rate and
+// publishes them through a FrameRing, so sensor I/O never stalls the render loop.
+class FrameProducer {
+public:
+	static const unsigned int RingSize = 4;
+private:
+	FrameSource& m_Source;
+	FrameRing<DepthFrame, RingSize> m_Ring;
+	DepthFrame m_Scratch;							// sink for frames produced while the ring is full
+	std::thread m_Thread;
+	std::atomic<bool> m_Running;
+	std::atomic<bool> m_Exhausted;
+	std::atomic<unsigned int> m_Produced;
+	std::atomic<unsigned int> m_Dropped;			// never made it into the ring
+	unsigned int m_Skipped;							// in the ring but superseded before being read (render thread only)
+public:
+	FrameProducer(FrameSource& source);
+	~FrameProducer();
+
+	void Start();
+	void Stop();
+
+	// render thread: newest frame since the last call, or nullptr. Pair with Release().
+	const DepthFrame* AcquireLatest();
+	void Release();
+
+	inline bool IsExhausted() const { return m_Exhausted.load(); }
+	inline unsigned int GetProducedFrames() const { return m_Produced.load(); }
+	inline unsigned int GetDroppedFrames() const { return m_Dropped.load(); }
+	inline unsigned int GetSkippedFrames() const { return m_Skipped; }
+
+private:
+	void Run();
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+
+// Bounded single producer / single consumer ring of preallocated slots.
+// Neither side ever blocks: the producer gets nullptr when the ring is full and
+// the consumer gets nullptr when there is nothing new to read.
+template<typename T, unsigned int N>
+class FrameRing {
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "FrameRing size must be a power of two");
+private:
+	T m_Slots[N];
+	alignas(64) std::atomic<unsigned int> m_Head;		// next slot the producer fills
+	alignas(64) std::atomic<unsigned int> m_Tail;		// next slot the consumer reads
+public:
+	FrameRing()
+		:m_Head(0), m_Tail(0) {}
+
+	// producer side
+	T* BeginWrite() {
+		unsigned int head = m_Head.load(std::memory_order_relaxed);
+		if (head - m_Tail.load(std::memory_order_acquire) == N) return nullptr;
+		return &m_Slots[head & (N - 1)];
+	}
+
+	void EndWrite() {
+		m_Head.store(m_Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// consumer side, skips straight to the newest published slot
+	T* BeginReadLatest(unsigned int* skipped = nullptr) {
+		unsigned int tail = m_Tail.load(std::memory_order_relaxed);
+		unsigned int head = m_Head.load(std::memory_order_acquire);
+		if (head == tail) return nullptr;
+
+		if (skipped) *skipped = head - tail - 1;
+		m_Tail.store(head - 1, std::memory_order_release);		// hand the stale slots back to the producer
+		return &m_Slots[(head - 1) & (N - 1)];
+	}
+
+	void EndRead() {
+		m_Tail.store(m_Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	inline unsigned int Capacity() const { return N; }
+};
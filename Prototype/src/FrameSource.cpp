@@ -0,0 +1,90 @@
+#include "FrameSource.h"
+
+#include <cmath>
+#include <iostream>
+
+CameraIntrinsics CameraIntrinsics::KinectV2() {
+	return { 512, 424, 365.5f, 365.5f, 254.9f, 205.4f, 0.001f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+}
+
+CameraIntrinsics CameraIntrinsics::KinectV1() {
+	return { 640, 480, 594.2f, 591.0f, 339.3f, 242.7f, 0.001f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+}
+
+
+SyntheticDepthSource::SyntheticDepthSource(const CameraIntrinsics& intrinsics)
+	:m_Intrinsics(intrinsics), m_FrameIndex(0) {}
+
+bool SyntheticDepthSource::ReadFrame(DepthFrame& frame) {
+	const CameraIntrinsics& k = m_Intrinsics;
+	float t = m_FrameIndex / (float)GetFrameRate();
+
+	frame.index = m_FrameIndex;
+	frame.timestamp = t;
+	frame.width = k.width;
+	frame.height = k.height;
+	frame.depth.resize((size_t)k.width * k.height);
+
+	// sphere bobbing side to side in front of the wall (metres)
+	float sx = 0.4f * std::sin(t);
+	float sy = 0.1f * std::cos(t * 1.7f);
+	float sz = 2.0f;
+	float r = 0.35f;
+
+	for (int v = 0; v < k.height; v++) {
+		for (int u = 0; u < k.width; u++) {
+			float dx = (u - k.cx) / k.fx;
+			float dy = (v - k.cy) / k.fy;
+
+			float z = 3.0f + 0.15f * std::sin(u * 0.03f + t * 2.0f);
+
+			// ray (dx, dy, 1) against the sphere
+			float a = dx * dx + dy * dy + 1.0f;
+			float b = -2.0f * (dx * sx + dy * sy + sz);
+			float c = sx * sx + sy * sy + sz * sz - r * r;
+			float disc = b * b - 4.0f * a * c;
+			if (disc >= 0.0f) {
+				float hit = (-b - std::sqrt(disc)) / (2.0f * a);
+				if (hit > 0.0f && hit < z) z = hit;
+			}
+
+			// sprinkle in the dropouts a real sensor has
+			bool hole = ((u * 7 + v * 13 + m_FrameIndex * 5) % 211) == 0;
+
+			frame.depth[(size_t)v * k.width + u] = hole ? 0 : (uint16_t)(z / k.depthScale);
+		}
+	}
+
+	m_FrameIndex++;
+	return true;
+}
+
+
+FileReplaySource::FileReplaySource(const std::string& filepath, const CameraIntrinsics& intrinsics)
+	:m_FilePath(filepath), m_Stream(filepath, std::ios::binary), m_Intrinsics(intrinsics), m_FrameIndex(0) {
+
+	if (!m_Stream.is_open()) std::cout << "Warning: could not open replay file " << filepath << std::endl;
+}
+
+bool FileReplaySource::ReadFrame(DepthFrame& frame) {
+	if (!m_Stream.is_open()) return false;
+
+	const CameraIntrinsics& k = m_Intrinsics;
+	size_t bytes = (size_t)k.width * k.height * sizeof(uint16_t);
+
+	frame.index = m_FrameIndex;
+	frame.timestamp = m_FrameIndex / GetFrameRate();
+	frame.width = k.width;
+	frame.height = k.height;
+	frame.depth.resize((size_t)k.width * k.height);
+
+	if (!m_Stream.read((char*)frame.depth.data(), bytes)) {
+		// loop back to the first frame
+		m_Stream.clear();
+		m_Stream.seekg(0);
+		if (!m_Stream.read((char*)frame.depth.data(), bytes)) return false;
+	}
+
+	m_FrameIndex++;
+	return true;
+}
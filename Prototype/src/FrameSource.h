@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Pinhole model of the depth camera plus lens distortion
+struct CameraIntrinsics {
+	int width, height;
+	float fx, fy;						// focal length (pixels)
+	float cx, cy;						// principal point (pixels)
+	float depthScale;					// metres per raw depth unit
+	float k1, k2, k3;					// radial distortion (Brown-Conrady)
+	float p1, p2;						// tangential distortion
+
+	static CameraIntrinsics KinectV2();	// 512x424
+	static CameraIntrinsics KinectV1();	// 640x480
+};
+
+struct DepthFrame {
+	unsigned int index;
+	double timestamp;					// seconds since the source started
+	int width, height;
+	std::vector<uint16_t> depth;		// width * height raw depth values, 0 = no reading
+};
+
+// Anything that produces depth frames (sensor, replay, generator).
+// ReadFrame is called from the producer thread only.
+class FrameSource {
+public:
+	virtual ~FrameSource() {}
+
+	virtual bool ReadFrame(DepthFrame& frame) = 0;		// false once the source is exhausted
+	virtual const CameraIntrinsics& GetIntrinsics() const = 0;
+	virtual double GetFrameRate() const { return 30.0; }
+};
+
+// Stand-in for the Kinect: a wavy back wall with a sphere bobbing in front of it
+class SyntheticDepthSource : public FrameSource {
+private:
+	CameraIntrinsics m_Intrinsics;
+	unsigned int m_FrameIndex;
+public:
+	SyntheticDepthSource(const CameraIntrinsics& intrinsics);
+
+	bool ReadFrame(DepthFrame& frame) override;
+	inline const CameraIntrinsics& GetIntrinsics() const override { return m_Intrinsics; }
+};
+
+// Replays a raw dump of back to back width * height uint16 frames, looping at the end
+class FileReplaySource : public FrameSource {
+private:
+	std::string m_FilePath;
+	std::ifstream m_Stream;
+	CameraIntrinsics m_Intrinsics;
+	unsigned int m_FrameIndex;
+public:
+	FileReplaySource(const std::string& filepath, const CameraIntrinsics& intrinsics);
+
+	bool ReadFrame(DepthFrame& frame) override;
+	inline const CameraIntrinsics& GetIntrinsics() const override { return m_Intrinsics; }
+	inline bool IsOpen() const { return m_Stream.is_open(); }
+};
@@ -0,0 +1,115 @@
+#include "Framebuffer.h"
+
+#include <fstream>
+#include <iostream>
+
+#include "GLState.h"
+Framebuffer::Framebuffer(int width, int height)
+	:m_RendererID(0), m_ColorTexture(0), m_DepthRenderbuffer(0), m_Width(width), m_Height(height) {
+
+	GLCall(glGenTextures(1, &m_ColorTexture));
+	GLState::BindTexture(GL_TEXTURE_2D, m_ColorTexture);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+	GLCall(glGenRenderbuffers(1, &m_DepthRenderbuffer));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthRenderbuffer));
+	GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
+	GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+
+	GLCall(glGenFramebuffers(1, &m_RendererID));
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+	GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_ColorTexture, 0));
+	GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthRenderbuffer));
+
+	if (!IsComplete()) std::cout << "Warning: framebuffer " << width << "x" << height << " is incomplete" << std::endl;
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+Framebuffer::~Framebuffer() {
+	GLCall(glDeleteFramebuffers(1, &m_RendererID));
+	GLCall(glDeleteRenderbuffers(1, &m_DepthRenderbuffer));
+	GLState::DeleteTexture(m_ColorTexture);
+}
+
+void Framebuffer::Bind() const {
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+	GLCall(glViewport(0, 0, m_Width, m_Height));
+}
+
+void Framebuffer::Unbind() const {
+	GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+bool Framebuffer::IsComplete() const {
+	GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	return status == GL_FRAMEBUFFER_COMPLETE;
+}
+
+
+FramebufferReadback::FramebufferReadback(int width, int height)
+	:m_PixelBuffers(), m_Width(width), m_Height(height), m_Captured(0), m_Mapped(BufferCount) {
+
+	GLCall(glGenBuffers(BufferCount, m_PixelBuffers));
+	for (unsigned int i = 0; i < BufferCount; i++) {
+		GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[i]);
+		GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ));
+	}
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+FramebufferReadback::~FramebufferReadback() {
+	Unmap();
+	for (unsigned int i = 0; i < BufferCount; i++)
+		GLState::DeleteBuffer(m_PixelBuffers[i]);
+}
+
+void FramebufferReadback::Capture(const Framebuffer& framebuffer) {
+	Unmap();
+	framebuffer.Bind();
+
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[m_Captured % BufferCount]);
+	GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));		// returns immediately, the copy happens on the GPU
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_Captured++;
+}
+
+const unsigned char* FramebufferReadback::MapPrevious() {
+	if (m_Captured < 2) return nullptr;
+	Unmap();
+
+	m_Mapped = (m_Captured - 2) % BufferCount;
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[m_Mapped]);
+	GLCall(const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)m_Width * m_Height * 4, GL_MAP_READ_BIT));
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	return (const unsigned char*)pixels;
+}
+
+void FramebufferReadback::Unmap() {
+	if (m_Mapped == BufferCount) return;
+
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, m_PixelBuffers[m_Mapped]);
+	GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	GLState::BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	m_Mapped = BufferCount;
+}
+
+bool FramebufferReadback::WritePPM(const std::string& filepath, const unsigned char* rgba, int width, int height) {
+	std::ofstream stream(filepath, std::ios::binary);
+	if (!stream) return false;
+
+	stream << "P6\n" << width << " " << height << "\n255\n";
+	std::vector<unsigned char> row((size_t)width * 3);
+	for (int y = height - 1; y >= 0; y--) {								// GL rows are bottom-up
+		const unsigned char* src = rgba + (size_t)y * width * 4;
+		for (int x = 0; x < width; x++) {
+			row[x * 3 + 0] = src[x * 4 + 0];
+			row[x * 3 + 1] = src[x * 4 + 1];
+			row[x * 3 + 2] = src[x * 4 + 2];
+		}
+		stream.write((const char*)row.data(), row.size());
+	}
+	return (bool)stream;
+}
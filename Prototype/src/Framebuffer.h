@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Renderer.h"
+
+// Offscreen render target: RGBA8 colour texture + depth renderbuffer
+class Framebuffer {
+private:
+	unsigned int m_RendererID;
+	unsigned int m_ColorTexture;
+	unsigned int m_DepthRenderbuffer;
+	int m_Width, m_Height;
+public:
+	Framebuffer(int width, int height);
+	~Framebuffer();
+
+	void Bind() const;						// also sets the viewport
+	void Unbind() const;
+
+	bool IsComplete() const;
+	inline unsigned int GetColorTexture() const { return m_ColorTexture; }
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+};
+
+// Asynchronous colour readback through a pair of pixel pack buffers: frame k is
+// copied into one PBO while frame k-1 is mapped from the other, so glReadPixels
+// never waits for the GPU to finish the current frame.
+class FramebufferReadback {
+public:
+	static const unsigned int BufferCount = 2;
+private:
+	unsigned int m_PixelBuffers[BufferCount];
+	int m_Width, m_Height;
+	unsigned int m_Captured;				// frames captured so far
+	unsigned int m_Mapped;					// PBO currently mapped, BufferCount when none
+public:
+	FramebufferReadback(int width, int height);
+	~FramebufferReadback();
+
+	void Capture(const Framebuffer& framebuffer);		// queue a copy of the current contents
+	const unsigned char* MapPrevious();					// RGBA rows bottom-up from the previous Capture, nullptr before the second
+	void Unmap();
+
+	inline int GetWidth() const { return m_Width; }
+	inline int GetHeight() const { return m_Height; }
+
+	static bool WritePPM(const std::string& filepath, const unsigned char* rgba, int width, int height);
+};
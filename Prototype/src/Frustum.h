@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// The six clip planes of a view-projection matrix (Gribb / Hartmann), in whatever space
+// the matrix maps from: pass projection * view * model to cull in model space.
+struct Frustum {
+	glm::vec4 planes[6];		// xyz = inward normal, w = distance
+
+	Frustum(const glm::mat4& viewProjection) {
+		glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		planes[0] = row3 + row0;		// left
+		planes[1] = row3 - row0;		// right
+		planes[2] = row3 + row1;		// bottom
+		planes[3] = row3 - row1;		// top
+		planes[4] = row3 + row2;		// near
+		planes[5] = row3 - row2;		// far
+	}
+
+	// conservative: true when any part of the box may be visible
+	inline bool IntersectsBox(const glm::vec3& center, const glm::vec3& halfExtent) const {
+		for (const glm::vec4& plane : planes) {
+			glm::vec3 normal(plane);
+			float radius = glm::dot(halfExtent, glm::abs(normal));
+			if (glm::dot(normal, center) + plane.w < -radius) return false;
+		}
+		return true;
+	}
+};
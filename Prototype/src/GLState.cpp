@@ -0,0 +1,265 @@
+#include "GLState.h"
+
+#include <unordered_map>
+
+#include "Renderer.h"
+
+static const unsigned int s_Unknown = ~0u;
+
+static const GLenum s_BufferTargets[] = {
+	GL_ARRAY_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_TEXTURE_BUFFER,
+	GL_DRAW_INDIRECT_BUFFER, GL_UNIFORM_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER
+};
+static const GLenum s_TextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_BUFFER, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_CUBE_MAP };
+static const GLenum s_Capabilities[] = { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_PROGRAM_POINT_SIZE, GL_FRAMEBUFFER_SRGB };
+
+static const unsigned int s_BufferTargetCount = sizeof(s_BufferTargets) / sizeof(s_BufferTargets[0]);
+static const unsigned int s_TextureTargetCount = sizeof(s_TextureTargets) / sizeof(s_TextureTargets[0]);
+static const unsigned int s_CapabilityCount = sizeof(s_Capabilities) / sizeof(s_Capabilities[0]);
+
+static struct {
+	unsigned int program = s_Unknown;
+	unsigned int vertexArray = s_Unknown;
+	unsigned int buffers[s_BufferTargetCount];
+	std::unordered_map<unsigned int, unsigned int> elementBuffers;		// vertex array -> its element buffer
+	struct { unsigned int buffer; GLintptr offset; GLsizeiptr size; } uniformBindings[GLState::MaxUniformBindings];	// size 0: whole buffer
+	unsigned int activeUnit = s_Unknown;
+	unsigned int textures[GLState::MaxTextureUnits][s_TextureTargetCount];
+	unsigned int samplers[GLState::MaxTextureUnits];
+	unsigned char capabilities[s_CapabilityCount];						// 0 off, 1 on, 2 unknown
+
+	GLStateStats frame = {};
+	GLStateStats current = {};
+	GLStateStats total = {};
+	unsigned int frames = 0;
+	bool initialised = false;
+} s_State;
+
+template<size_t N>
+static int IndexOf(const GLenum (&list)[N], GLenum value) {
+	for (size_t i = 0; i < N; i++)
+		if (list[i] == value) return (int)i;
+	return -1;
+}
+
+// true when the driver call is needed; `cached` is updated either way
+static inline bool Change(unsigned int& cached, unsigned int value) {
+	if (cached == value) {
+		s_State.current.elided++;
+		return false;
+	}
+	cached = value;
+	s_State.current.issued++;
+	return true;
+}
+
+static void EnsureInitialised() {
+	if (!s_State.initialised) GLState::Invalidate();
+}
+
+void GLState::Invalidate() {
+	s_State.program = s_Unknown;
+	s_State.vertexArray = s_Unknown;
+	for (unsigned int& buffer : s_State.buffers) buffer = s_Unknown;
+	s_State.elementBuffers.clear();
+	for (auto& binding : s_State.uniformBindings) binding = { s_Unknown, 0, 0 };
+	s_State.activeUnit = s_Unknown;
+	for (auto& unit : s_State.textures)
+		for (unsigned int& texture : unit) texture = s_Unknown;
+	for (unsigned int& sampler : s_State.samplers) sampler = s_Unknown;
+	for (unsigned char& capability : s_State.capabilities) capability = 2;
+	s_State.initialised = true;
+}
+
+void GLState::UseProgram(unsigned int program) {
+	EnsureInitialised();
+	if (Change(s_State.program, program)) {
+		GLCall(glUseProgram(program));
+	}
+}
+
+void GLState::BindVertexArray(unsigned int vertexArray) {
+	EnsureInitialised();
+	if (Change(s_State.vertexArray, vertexArray)) {
+		GLCall(glBindVertexArray(vertexArray));
+	}
+}
+
+void GLState::BindBuffer(GLenum target, unsigned int buffer) {
+	EnsureInitialised();
+
+	if (target == GL_ELEMENT_ARRAY_BUFFER && s_State.vertexArray != s_Unknown) {
+		auto inserted = s_State.elementBuffers.emplace(s_State.vertexArray, s_Unknown);
+		if (Change(inserted.first->second, buffer)) {
+			GLCall(glBindBuffer(target, buffer));
+		}
+		return;
+	}
+
+	int slot = IndexOf(s_BufferTargets, target);
+	if (slot < 0) {
+		s_State.current.issued++;
+		GLCall(glBindBuffer(target, buffer));
+		return;
+	}
+	if (Change(s_State.buffers[slot], buffer)) {
+		GLCall(glBindBuffer(target, buffer));
+	}
+}
+
+void GLState::BindBufferBase(GLenum target, unsigned int index, unsigned int buffer) {
+	BindBufferRange(target, index, buffer, 0, 0);
+}
+
+void GLState::BindBufferRange(GLenum target, unsigned int index, unsigned int buffer, GLintptr offset, GLsizeiptr size) {
+	EnsureInitialised();
+
+	int slot = IndexOf(s_BufferTargets, target);
+	if (target == GL_UNIFORM_BUFFER && index < MaxUniformBindings) {
+		auto& binding = s_State.uniformBindings[index];
+		if (binding.buffer == buffer && binding.offset == offset && binding.size == size) {
+			s_State.current.elided++;
+			return;
+		}
+		binding = { buffer, offset, size };
+	}
+	if (slot >= 0) s_State.buffers[slot] = buffer;
+
+	s_State.current.issued++;
+	if (size == 0) {
+		GLCall(glBindBufferBase(target, index, buffer));
+	}
+	else {
+		GLCall(glBindBufferRange(target, index, buffer, offset, size));
+	}
+}
+
+void GLState::ActiveTexture(unsigned int unit) {
+	EnsureInitialised();
+	if (Change(s_State.activeUnit, unit)) {
+		GLCall(glActiveTexture(GL_TEXTURE0 + unit));
+	}
+}
+
+void GLState::BindTexture(GLenum target, unsigned int texture) {
+	EnsureInitialised();
+
+	int slot = IndexOf(s_TextureTargets, target);
+	if (slot < 0 || s_State.activeUnit >= MaxTextureUnits) {
+		if (slot >= 0)												// some unit changed, don't know which
+			for (auto& unit : s_State.textures) unit[slot] = s_Unknown;
+		s_State.current.issued++;
+		GLCall(glBindTexture(target, texture));
+		return;
+	}
+	if (Change(s_State.textures[s_State.activeUnit][slot], texture)) {
+		GLCall(glBindTexture(target, texture));
+	}
+}
+
+void GLState::BindTexture(unsigned int unit, GLenum target, unsigned int texture) {
+	EnsureInitialised();
+
+	// skip the unit switch too when the texture is already there
+	int slot = IndexOf(s_TextureTargets, target);
+	if (slot >= 0 && unit < MaxTextureUnits && s_State.textures[unit][slot] == texture) {
+		s_State.current.elided++;
+		return;
+	}
+	ActiveTexture(unit);
+	BindTexture(target, texture);
+}
+
+void GLState::BindSampler(unsigned int unit, unsigned int sampler) {
+	EnsureInitialised();
+
+	// sampler bindings name their unit, no glActiveTexture needed
+	if (unit >= MaxTextureUnits) {
+		s_State.current.issued++;
+		GLCall(glBindSampler(unit, sampler));
+		return;
+	}
+	if (Change(s_State.samplers[unit], sampler)) {
+		GLCall(glBindSampler(unit, sampler));
+	}
+}
+
+void GLState::Enable(GLenum capability) {
+	EnsureInitialised();
+
+	int slot = IndexOf(s_Capabilities, capability);
+	if (slot >= 0 && s_State.capabilities[slot] == 1) {
+		s_State.current.elided++;
+		return;
+	}
+	if (slot >= 0) s_State.capabilities[slot] = 1;
+	s_State.current.issued++;
+	GLCall(glEnable(capability));
+}
+
+void GLState::Disable(GLenum capability) {
+	EnsureInitialised();
+
+	int slot = IndexOf(s_Capabilities, capability);
+	if (slot >= 0 && s_State.capabilities[slot] == 0) {
+		s_State.current.elided++;
+		return;
+	}
+	if (slot >= 0) s_State.capabilities[slot] = 0;
+	s_State.current.issued++;
+	GLCall(glDisable(capability));
+}
+
+void GLState::DeleteProgram(unsigned int program) {
+	if (s_State.program == program) s_State.program = s_Unknown;		// stays in use until replaced
+	GLCall(glDeleteProgram(program));
+}
+
+void GLState::DeleteVertexArray(unsigned int vertexArray) {
+	if (s_State.vertexArray == vertexArray) s_State.vertexArray = 0;		// deleting the bound array reverts to 0
+	s_State.elementBuffers.erase(vertexArray);
+	GLCall(glDeleteVertexArrays(1, &vertexArray));
+}
+
+void GLState::DeleteBuffer(unsigned int buffer) {
+	for (unsigned int& bound : s_State.buffers)
+		if (bound == buffer) bound = 0;
+	for (auto& binding : s_State.uniformBindings)
+		if (binding.buffer == buffer) binding = { 0, 0, 0 };
+	for (auto& element : s_State.elementBuffers)
+		if (element.second == buffer) element.second = s_Unknown;		// unbound from the current array only, forget it everywhere
+	GLCall(glDeleteBuffers(1, &buffer));
+}
+
+void GLState::DeleteTexture(unsigned int texture) {
+	for (auto& unit : s_State.textures)
+		for (unsigned int& bound : unit)
+			if (bound == texture) bound = 0;
+	GLCall(glDeleteTextures(1, &texture));
+}
+
+void GLState::DeleteSampler(unsigned int sampler) {
+	for (unsigned int& bound : s_State.samplers)
+		if (bound == sampler) bound = 0;
+	GLCall(glDeleteSamplers(1, &sampler));
+}
+
+void GLState::EndFrame() {
+	s_State.frame = s_State.current;
+	s_State.total.issued += s_State.current.issued;
+	s_State.total.elided += s_State.current.elided;
+	s_State.current = {};
+	s_State.frames++;
+}
+
+const GLStateStats& GLState::GetFrameStats() {
+	return s_State.frame;
+}
+
+const GLStateStats& GLState::GetTotalStats() {
+	return s_State.total;
+}
+
+unsigned int GLState::GetFrameCount() {
+	return s_State.frames;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+
+struct GLStateStats {
+	unsigned long long issued;			// state changes that reached the driver
+	unsigned long long elided;			// skipped because the object was already bound / the flag already set
+};
+
+// Shadow copy of the GL bindings the renderer changes most: the current program, vertex
+// array, buffer per target (the element buffer per vertex array, since that is VAO state),
+// texture per unit and target, sampler object per unit, and enable flags. Bind calls go through here and only reach
+// the driver when the binding actually changes.
+//
+// Every bind of a tracked target has to go through GLState, or the shadow copy goes stale;
+// call Invalidate() after code that touches GL directly and whenever a new context is made
+// current. Render thread only, one context.
+class GLState {
+public:
+	static const unsigned int MaxTextureUnits = 32;
+	static const unsigned int MaxUniformBindings = 16;
+
+	static void UseProgram(unsigned int program);
+	static void BindVertexArray(unsigned int vertexArray);
+	static void BindBuffer(GLenum target, unsigned int buffer);
+	static void BindBufferBase(GLenum target, unsigned int index, unsigned int buffer);		// also the generic `target` binding
+	static void BindBufferRange(GLenum target, unsigned int index, unsigned int buffer, GLintptr offset, GLsizeiptr size);
+	static void ActiveTexture(unsigned int unit);						// unit index, not GL_TEXTUREi
+	static void BindTexture(GLenum target, unsigned int texture);		// on the active unit
+	static void BindTexture(unsigned int unit, GLenum target, unsigned int texture);
+	static void BindSampler(unsigned int unit, unsigned int sampler);	// 0: the texture's own parameters
+	static void Enable(GLenum capability);
+	static void Disable(GLenum capability);
+
+	// delete through here so a recycled name isn't mistaken for a live binding
+	static void DeleteProgram(unsigned int program);
+	static void DeleteVertexArray(unsigned int vertexArray);
+	static void DeleteBuffer(unsigned int buffer);
+	static void DeleteTexture(unsigned int texture);
+	static void DeleteSampler(unsigned int sampler);
+
+	static void Invalidate();							// forget everything, the next bind of each kind is issued
+	static void EndFrame();								// closes the per-frame counters
+
+	static const GLStateStats& GetFrameStats();		// the last finished frame
+	static const GLStateStats& GetTotalStats();
+	static unsigned int GetFrameCount();
+};
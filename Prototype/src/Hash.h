@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+// FNV-1a, usable in constant expressions
+namespace hash {
+
+	static constexpr uint32_t Fnv32Basis = 0x811c9dc5u;
+	static constexpr uint64_t Fnv64Basis = 0xcbf29ce484222325ull;
+
+	constexpr uint32_t Fnv1a32(std::string_view text, uint32_t hash = Fnv32Basis) {
+		for (char c : text) {
+			hash ^= (unsigned char)c;
+			hash *= 0x01000193u;
+		}
+		return hash;
+	}
+
+	constexpr uint64_t Fnv1a64(std::string_view text, uint64_t hash = Fnv64Basis) {
+		for (char c : text) {
+			hash ^= (unsigned char)c;
+			hash *= 0x100000001b3ull;
+		}
+		return hash;
+	}
+
+	inline uint64_t Fnv1a64(const void* data, size_t size, uint64_t hash = Fnv64Basis) {
+		return Fnv1a64(std::string_view((const char*)data, size), hash);
+	}
+
+}
@@ -0,0 +1,157 @@
+#include "ImageDecoder.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "vendor/std_image/stb_image.h"
+
+#ifdef USE_LIBJPEG_TURBO
+	#include <csetjmp>
+	#include <cstdio>						// jpeglib.h uses FILE and size_t without including them
+	#include <jpeglib.h>
+	#ifndef JCS_EXTENSIONS
+		#error USE_LIBJPEG_TURBO needs libjpeg-turbo, plain libjpeg has no RGBA output
+	#endif
+#endif
+
+ImageFormat DetectImageFormat(const unsigned char* data, size_t size) {
+	static const unsigned char s_Png[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	if (size >= 8 && std::memcmp(data, s_Png, 8) == 0) return ImageFormat::Png;
+	if (size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff) return ImageFormat::Jpeg;
+	return ImageFormat::Unknown;
+}
+
+const char* GetImageDecoderName(ImageDecoder decoder) {
+	switch (decoder) {
+		case ImageDecoder::Auto:			return "auto";
+		case ImageDecoder::Stb:				return "stb_image";
+		case ImageDecoder::LibjpegTurbo:	return "libjpeg-turbo";
+	}
+	return "?";
+}
+
+bool IsImageDecoderAvailable(ImageDecoder decoder, ImageFormat format) {
+	switch (decoder) {
+		case ImageDecoder::Auto:
+		case ImageDecoder::Stb:				return true;
+		case ImageDecoder::LibjpegTurbo:
+#ifdef USE_LIBJPEG_TURBO
+			return format == ImageFormat::Jpeg;
+#else
+			(void)format;
+			return false;
+#endif
+	}
+	return false;
+}
+
+ImageDecoder ChooseImageDecoder(ImageFormat format) {
+	if (IsImageDecoderAvailable(ImageDecoder::LibjpegTurbo, format)) return ImageDecoder::LibjpegTurbo;
+	return ImageDecoder::Stb;
+}
+
+static bool DecodeStb(const unsigned char* data, size_t size, DecodedImage& image, std::string* error) {
+	int width = 0, height = 0, channels = 0;
+	stbi_set_flip_vertically_on_load_thread(1);		// per thread, the global flag isn't safe to touch from a worker
+	unsigned char* pixels = stbi_load_from_memory(data, (int)size, &width, &height, &channels, 4);
+	if (!pixels) {
+		if (error) *error = stbi_failure_reason();
+		return false;
+	}
+	image.width = width;
+	image.height = height;
+	image.channels = channels;
+	image.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(pixels, stbi_image_free);
+	return true;
+}
+
+#ifdef USE_LIBJPEG_TURBO
+struct JpegFailure {
+	jpeg_error_mgr manager;					// first, libjpeg hands it back as the error manager
+	std::jmp_buf jump;
+	char message[JMSG_LENGTH_MAX];
+};
+
+// libjpeg's default exits the process, jump back into DecodeJpeg instead
+static void OnJpegError(j_common_ptr info) {
+	JpegFailure* failure = (JpegFailure*)info->err;
+	(*info->err->format_message)(info, failure->message);
+	std::longjmp(failure->jump, 1);
+}
+
+// warnings (e.g. a truncated file, decoded with grey filler) would go to stderr
+static void OnJpegMessage(j_common_ptr) {}
+
+// nothing with a destructor lives between the setjmp and a libjpeg call
+static bool DecodeJpeg(const unsigned char* data, size_t size, DecodedImage& image, std::string* error) {
+	jpeg_decompress_struct info;
+	JpegFailure failure;
+	unsigned char* volatile pixels = nullptr;
+
+	info.err = jpeg_std_error(&failure.manager);
+	failure.manager.error_exit = OnJpegError;
+	failure.manager.output_message = OnJpegMessage;
+	if (setjmp(failure.jump)) {
+		jpeg_destroy_decompress(&info);
+		std::free(pixels);
+		if (error) *error = failure.message;
+		return false;
+	}
+
+	jpeg_create_decompress(&info);
+	jpeg_mem_src(&info, (unsigned char*)data, (unsigned long)size);
+	jpeg_read_header(&info, TRUE);
+	info.out_color_space = JCS_EXT_RGBA;			// straight from YCbCr (or grey), no RGB pass in between
+	jpeg_start_decompress(&info);
+
+	size_t stride = (size_t)info.output_width * 4;
+	pixels = (unsigned char*)std::malloc(stride * info.output_height);
+	if (!pixels) {
+		jpeg_destroy_decompress(&info);
+		if (error) *error = "out of memory";
+		return false;
+	}
+
+	// rows land bottom-up as they are decoded, no flip afterwards
+	while (info.output_scanline < info.output_height) {
+		JSAMPROW rows[8];
+		JDIMENSION count = std::min<JDIMENSION>(8, info.output_height - info.output_scanline);
+		for (JDIMENSION i = 0; i < count; i++) rows[i] = pixels + (size_t)(info.output_height - 1 - info.output_scanline - i) * stride;
+		jpeg_read_scanlines(&info, rows, count);
+	}
+
+	image.width = (int)info.output_width;
+	image.height = (int)info.output_height;
+	image.channels = info.jpeg_color_space == JCS_GRAYSCALE ? 1 : 3;
+	jpeg_finish_decompress(&info);
+	jpeg_destroy_decompress(&info);
+	image.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(pixels, std::free);
+	return true;
+}
+#endif
+
+bool DecodeImage(const unsigned char* data, size_t size, DecodedImage& image, std::string* error, ImageDecoder decoder) {
+	image = DecodedImage();
+	if (size > INT_MAX) {
+		if (error) *error = "file too large";
+		return false;
+	}
+
+	ImageFormat format = DetectImageFormat(data, size);
+	bool automatic = decoder == ImageDecoder::Auto;
+	if (automatic) decoder = ChooseImageDecoder(format);
+	if (!IsImageDecoderAvailable(decoder, format)) {
+		if (error) *error = std::string(GetImageDecoderName(decoder)) + " can't decode this file";
+		return false;
+	}
+
+#ifdef USE_LIBJPEG_TURBO
+	if (decoder == ImageDecoder::LibjpegTurbo) {
+		if (DecodeJpeg(data, size, image, error)) return true;
+		if (!automatic) return false;
+		image = DecodedImage();							// e.g. CMYK, which has no RGBA conversion; stb_image gets a go
+	}
+#endif
+	return DecodeStb(data, size, image, error);
+}
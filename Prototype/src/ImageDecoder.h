@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+enum class ImageFormat {
+	Unknown,								// anything else stb_image reads: BMP, TGA, GIF, ...
+	Png,
+	Jpeg
+};
+
+enum class ImageDecoder {
+	Auto,									// the fastest one built in for the file's format
+	Stb,									// stb_image, always there
+	LibjpegTurbo							// JPEG only, needs USE_LIBJPEG_TURBO and jpeg(-static).lib
+};
+
+// RGBA8, bottom row first like the GL wants it
+struct DecodedImage {
+	int width = 0, height = 0;
+	int channels = 0;						// in the file: 1 grey, 2 grey + alpha, 3 RGB, 4 RGBA
+	std::unique_ptr<unsigned char, void (*)(void*)> pixels{ nullptr, std::free };
+};
+
+// Image file decoding for TextureCache, by format: JPEG goes to libjpeg-turbo when the build
+// has it (USE_LIBJPEG_TURBO; its SIMD IDCT, upsampling and colour conversion are well ahead
+// of stb_image's SSE2 ones, and rows are written bottom-up for free instead of flipped after),
+// everything else to stb_image. Safe on any thread.
+ImageFormat DetectImageFormat(const unsigned char* data, size_t size);		// from the signature
+const char* GetImageDecoderName(ImageDecoder decoder);
+bool IsImageDecoderAvailable(ImageDecoder decoder, ImageFormat format);
+ImageDecoder ChooseImageDecoder(ImageFormat format);
+
+bool DecodeImage(const unsigned char* data, size_t size, DecodedImage& image, std::string* error = nullptr,
+	ImageDecoder decoder = ImageDecoder::Auto);
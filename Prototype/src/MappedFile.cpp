@@ -0,0 +1,62 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filepath)
+	:m_FilePath(filepath), m_Data(nullptr), m_Size(0), m_File(INVALID_HANDLE_VALUE), m_Mapping(nullptr) {
+
+	m_File = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_File == INVALID_HANDLE_VALUE) return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) return;
+
+	m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_Mapping) return;
+
+	m_Data = (const unsigned char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_Data) m_Size = (size_t)size.QuadPart;
+}
+
+MappedFile::~MappedFile() {
+	if (m_Data) UnmapViewOfFile(m_Data);
+	if (m_Mapping) CloseHandle(m_Mapping);
+	if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filepath)
+	:m_FilePath(filepath), m_Data(nullptr), m_Size(0), m_File(-1) {
+
+	m_File = open(filepath.c_str(), O_RDONLY);
+	if (m_File < 0) return;
+
+	struct stat info;
+	if (fstat(m_File, &info) != 0 || info.st_size == 0) return;
+
+	void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_File, 0);
+	if (data == MAP_FAILED) return;
+
+	madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL);
+	m_Data = (const unsigned char*)data;
+	m_Size = (size_t)info.st_size;
+}
+
+MappedFile::~MappedFile() {
+	if (m_Data) munmap((void*)m_Data, m_Size);
+	if (m_File >= 0) close(m_File);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file (MapViewOfFile on Windows, mmap elsewhere)
+class MappedFile {
+private:
+	std::string m_FilePath;
+	const unsigned char* m_Data;
+	size_t m_Size;
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#else
+	int m_File;
+#endif
+public:
+	MappedFile(const std::string& filepath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	inline bool IsOpen() const { return m_Data != nullptr; }
+	inline const unsigned char* GetData() const { return m_Data; }
+	inline size_t GetSize() const { return m_Size; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+};
@@ -0,0 +1,65 @@
+#include "Mipmap.h"
+
+#include <algorithm>
+
+int GetMipLevelCount(int width, int height) {
+	int levels = 1;
+	for (int size = std::max(width, height); size > 1; size >>= 1) levels++;
+	return levels;
+}
+
+size_t GetMipChainSize(BlockFormat format, int width, int height, int levels) {
+	size_t size = 0;
+	for (int level = 0; level < levels; level++)
+		size += GetBlockCompressedSize(format, GetMipSize(width, level), GetMipSize(height, level));
+	return size;
+}
+
+static void DownsampleRow(const unsigned char* top, const unsigned char* bottom, int width, int from, int to, unsigned char* out) {
+	for (int x = from; x < to; x++) {
+		int left = 2 * x * 4, right = std::min(2 * x + 1, width - 1) * 4;
+		for (int c = 0; c < 4; c++)
+			out[x * 4 + c] = (unsigned char)((top[left + c] + top[right + c] + bottom[left + c] + bottom[right + c] + 2) >> 2);
+	}
+}
+
+#if SIMD_X86
+// four output texels from two rows of eight, same rounding as DownsampleRow
+SIMD_TARGET_SSE41 static inline __m128i AverageQuads(__m128i top, __m128i bottom) {
+	const __m128i zero = _mm_setzero_si128();
+	__m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));		// texels 0, 1
+	__m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));	// texels 2, 3
+	return _mm_add_epi16(_mm_unpacklo_epi64(low, high), _mm_unpackhi_epi64(low, high));			// 0 + 1, 2 + 3
+}
+
+SIMD_TARGET_SSE41 static int DownsampleRowSSE41(const unsigned char* top, const unsigned char* bottom, int outWidth, unsigned char* out) {
+	const __m128i two = _mm_set1_epi16(2);
+	int x = 0;
+	for (; x + 4 <= outWidth; x += 4) {
+		const unsigned char* t = top + x * 8;
+		const unsigned char* b = bottom + x * 8;
+		__m128i first = AverageQuads(_mm_loadu_si128((const __m128i*)t), _mm_loadu_si128((const __m128i*)b));
+		__m128i second = AverageQuads(_mm_loadu_si128((const __m128i*)(t + 16)), _mm_loadu_si128((const __m128i*)(b + 16)));
+		first = _mm_srli_epi16(_mm_add_epi16(first, two), 2);
+		second = _mm_srli_epi16(_mm_add_epi16(second, two), 2);
+		_mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(first, second));
+	}
+	return x;
+}
+#endif
+
+void DownsampleBox(const unsigned char* rgba, int width, int height, unsigned char* out, Simd::Level level) {
+	int outWidth = GetMipSize(width, 1), outHeight = GetMipSize(height, 1);
+
+	for (int y = 0; y < outHeight; y++) {
+		const unsigned char* top = rgba + (size_t)(2 * y) * width * 4;
+		const unsigned char* bottom = rgba + (size_t)std::min(2 * y + 1, height - 1) * width * 4;
+		unsigned char* row = out + (size_t)y * outWidth * 4;
+
+		int done = 0;
+#if SIMD_X86
+		if (width > 1 && Simd::Clamp(level) >= Simd::Level::SSE41) done = DownsampleRowSSE41(top, bottom, outWidth, row);
+#endif
+		DownsampleRow(top, bottom, width, done, outWidth, row);
+	}
+}
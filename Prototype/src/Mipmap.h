@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+#include "BlockCompression.h"
+#include "Simd.h"
+
+// CPU mip chains, for images that have to be built before upload: glGenerateMipmap can't make
+// block compressed levels, so TextureCache downsamples the RGBA8 source and compresses every
+// level. Each level is a 2x2 box average of the one above, rounded to nearest; an odd last row
+// or column is dropped, a single one is repeated.
+int GetMipLevelCount(int width, int height);					// down to 1x1
+inline int GetMipSize(int size, int level) { return size >> level > 0 ? size >> level : 1; }
+size_t GetMipChainSize(BlockFormat format, int width, int height, int levels);	// every level, tightly packed
+
+// RGBA8 `width` x `height` into the next level down, GetMipSize(width, 1) x GetMipSize(height, 1)
+void DownsampleBox(const unsigned char* rgba, int width, int height, unsigned char* out,
+	Simd::Level level = Simd::Detect());
@@ -0,0 +1,191 @@
+#include "PointOctree.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+#include "Frustum.h"
+#include "Profiler.h"
+#include "VertexBufferLayout.h"
+
+PointOctree::PointOctree(const glm::vec3& center, float halfSize, unsigned int maxPoints, const VertexBufferLayout& layout, unsigned int maxDepth)
+	:m_Layout(layout), m_MaxDepth(maxDepth), m_PageCount((maxPoints + PagePoints - 1) / PagePoints), m_NextPage(0),
+	m_PointCount(0), m_Rejected(0), m_VertexBuffer(m_PageCount * PagePoints * layout.GetStride(), BufferUsage::Dynamic) {
+
+	m_VertexArray.AddBuffer(m_VertexBuffer, layout);
+	m_VertexArray.Unbind();
+	CreateNode(center, halfSize, 0);
+}
+
+int PointOctree::CreateNode(const glm::vec3& center, float halfSize, int level) {
+	OctreeNode node;
+	node.center = center;
+	node.halfSize = halfSize;
+	node.level = level;
+	std::fill(node.children, node.children + 8, -1);
+	node.occupancy.assign(GridSize * GridSize * GridSize / 32, 0);
+	node.pointCount = 0;
+	node.uploaded = 0;
+
+	m_Nodes.push_back(std::move(node));
+	return (int)m_Nodes.size() - 1;
+}
+
+bool PointOctree::AddToNode(int index, const unsigned char* vertex) {
+	OctreeNode& node = m_Nodes[index];
+
+	if (node.pointCount % PagePoints == 0) {
+		if (m_NextPage == m_PageCount) return false;
+		node.pages.push_back(m_NextPage++);
+	}
+
+	if (node.pending.empty()) m_Dirty.push_back(index);
+	node.pending.insert(node.pending.end(), vertex, vertex + m_Layout.stride);
+	node.pointCount++;
+	return true;
+}
+
+unsigned int PointOctree::Insert(const void* vertices, unsigned int count) {
+	PROFILE_SCOPE("Octree Insert");
+
+	const unsigned char* vertex = (const unsigned char*)vertices;
+	unsigned int accepted = 0;
+
+	for (unsigned int i = 0; i < count; i++, vertex += m_Layout.stride) {
+		glm::vec3 p;
+		std::memcpy(&p, vertex + m_Layout.positionOffset, sizeof(p));
+		if (p.x == 0.0f && p.y == 0.0f && p.z == 0.0f) continue;		// no depth at this pixel
+
+		const OctreeNode& root = m_Nodes[0];
+		if (glm::any(glm::greaterThan(glm::abs(p - root.center), glm::vec3(root.halfSize)))) {
+			m_Rejected++;
+			continue;
+		}
+
+		// walk down until a node has this point's grid cell free
+		int index = 0;
+		for (;;) {
+			OctreeNode& node = m_Nodes[index];
+			glm::vec3 local = (p - node.center) / (2.0f * node.halfSize) + 0.5f;
+			glm::uvec3 cell = glm::min(glm::uvec3(glm::max(local, 0.0f) * (float)GridSize), glm::uvec3(GridSize - 1));
+			unsigned int bit = (cell.z * GridSize + cell.y) * GridSize + cell.x;
+
+			uint32_t& word = node.occupancy[bit / 32];
+			uint32_t mask = 1u << (bit % 32);
+			if (!(word & mask)) {
+				if (AddToNode(index, vertex)) {
+					m_Nodes[index].occupancy[bit / 32] |= mask;
+					accepted++;
+				}
+				else m_Rejected++;
+				break;
+			}
+
+			if ((unsigned int)node.level == m_MaxDepth) {
+				m_Rejected++;
+				break;
+			}
+
+			int octant = (p.x >= node.center.x ? 1 : 0) | (p.y >= node.center.y ? 2 : 0) | (p.z >= node.center.z ? 4 : 0);
+			int child = node.children[octant];
+			if (child < 0) {
+				float half = node.halfSize * 0.5f;
+				glm::vec3 offset((octant & 1) ? half : -half, (octant & 2) ? half : -half, (octant & 4) ? half : -half);
+				child = CreateNode(node.center + offset, half, node.level + 1);		// may reallocate m_Nodes
+				m_Nodes[index].children[octant] = child;
+			}
+			index = child;
+		}
+	}
+
+	m_PointCount += accepted;
+	return accepted;
+}
+
+unsigned int PointOctree::Upload(unsigned int maxPoints) {
+	PROFILE_SCOPE("Octree Upload");
+
+	unsigned int stride = m_Layout.stride;
+	unsigned int uploaded = 0;
+
+	// oldest first: the root and coarse levels, which Select() draws first, are dirtied first
+	while (!m_Dirty.empty() && uploaded < maxPoints) {
+		OctreeNode& node = m_Nodes[m_Dirty.front()];
+		unsigned int pending = node.pointCount - node.uploaded;
+		unsigned int count = std::min(pending, maxPoints - uploaded);
+		// pending holds every point from `first` on; uploaded ones stay until the node drains
+		unsigned int first = node.pointCount - (unsigned int)(node.pending.size() / stride);
+		const unsigned char* source = node.pending.data() + (size_t)(node.uploaded - first) * stride;
+
+		// one glBufferSubData per page touched
+		unsigned int done = 0;
+		while (done < count) {
+			unsigned int point = node.uploaded + done;
+			unsigned int inPage = point % PagePoints;
+			unsigned int run = std::min(count - done, PagePoints - inPage);
+			unsigned int offset = (node.pages[point / PagePoints] * PagePoints + inPage) * stride;
+			m_VertexBuffer.SetData(source + (size_t)done * stride, run * stride, offset);
+			done += run;
+		}
+
+		node.uploaded += count;
+		uploaded += count;
+		if (node.uploaded == node.pointCount) {
+			std::vector<unsigned char>().swap(node.pending);			// drained, free it in one go
+			m_Dirty.pop_front();
+		}
+	}
+	return uploaded;
+}
+
+void PointOctree::Select(const glm::mat4& projection, const glm::mat4& modelView, float viewportHeight, unsigned int pointBudget, OctreeSelection& selection) const {
+	PROFILE_SCOPE("Octree Select");
+
+	selection.firsts.clear();
+	selection.counts.clear();
+	selection.nodes = 0;
+	selection.culled = 0;
+	selection.points = 0;
+
+	Frustum frustum(projection * modelView);
+	glm::vec3 eye = glm::vec3(glm::inverse(modelView)[3]);						// camera position in octree space
+	float pixelsPerUnit = projection[1][1] * viewportHeight * 0.5f;		// at distance 1
+
+	// biggest on screen first: coarse nodes near the camera before fine ones far away
+	typedef std::pair<float, int> Candidate;
+	std::priority_queue<Candidate> queue;
+	queue.push(Candidate(1e30f, 0));
+
+	while (!queue.empty()) {
+		int index = queue.top().second;
+		queue.pop();
+
+		const OctreeNode& node = m_Nodes[index];
+		if (!frustum.IntersectsBox(node.center, glm::vec3(node.halfSize))) {
+			selection.culled++;
+			continue;
+		}
+		if (selection.points + node.uploaded > pointBudget) break;
+
+		for (unsigned int page = 0; page * PagePoints < node.uploaded; page++) {
+			int first = (int)(node.pages[page] * PagePoints);
+			int count = (int)std::min(PagePoints, node.uploaded - page * PagePoints);
+			if (!selection.firsts.empty() && selection.firsts.back() + selection.counts.back() == first)
+				selection.counts.back() += count;		// consecutive pages
+			else {
+				selection.firsts.push_back(first);
+				selection.counts.push_back(count);
+			}
+		}
+		selection.points += node.uploaded;
+		selection.nodes++;
+
+		for (int child : node.children) {
+			if (child < 0) continue;
+			const OctreeNode& c = m_Nodes[child];
+			float radius = c.halfSize * 1.7320508f;
+			float distance = std::max(glm::length(c.center - eye) - radius, 1e-3f);
+			queue.push(Candidate(radius / distance * pixelsPerUnit, child));
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BackProjector.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+class VertexBufferLayout;
+
+// Accumulating point cloud with level of detail, nested octree style: every node keeps
+// at most one point per cell of a GridSize^3 grid over its bounds and passes the rest
+// down to its children, so a node plus its ancestors is a uniform subsample of the cloud
+// at that node's resolution. Node points live in fixed-size pages of one big vertex
+// buffer; Select() culls against the frustum and picks nodes by projected size until a
+// point budget is spent, so drawing costs the same however large the cloud grows.
+struct OctreeNode {
+	glm::vec3 center;
+	float halfSize;
+	int level;
+	int children[8];						// -1 where no child exists yet
+	std::vector<unsigned char> pending;		// points accepted since the node last drained, in the vertex layout
+	std::vector<uint32_t> occupancy;		// one bit per grid cell
+	std::vector<unsigned int> pages;		// vertex buffer pages holding this node's points
+	unsigned int pointCount;
+	unsigned int uploaded;					// points already in the vertex buffer
+};
+
+// Draw ranges for glMultiDrawArrays
+struct OctreeSelection {
+	std::vector<int> firsts;
+	std::vector<int> counts;
+	unsigned int nodes;						// nodes drawn
+	unsigned int culled;					// nodes outside the frustum
+	unsigned int points;
+};
+
+class PointOctree {
+public:
+	static const unsigned int GridSize = 32;
+	static const unsigned int PagePoints = 4096;
+private:
+	PointLayout m_Layout;
+	unsigned int m_MaxDepth;
+	unsigned int m_PageCount;
+	unsigned int m_NextPage;
+	std::vector<OctreeNode> m_Nodes;
+	std::deque<int> m_Dirty;				// nodes with points not uploaded yet, oldest first
+	unsigned long long m_PointCount;
+	unsigned long long m_Rejected;			// duplicates at the finest level, out of bounds, or out of pages
+	VertexBuffer m_VertexBuffer;
+	VertexArray m_VertexArray;
+public:
+	PointOctree(const glm::vec3& center, float halfSize, unsigned int maxPoints, const VertexBufferLayout& layout, unsigned int maxDepth = 6);
+
+	// points in the layout, holes (all-zero positions) are skipped; returns the points accepted
+	unsigned int Insert(const void* vertices, unsigned int count);
+
+	// copies up to maxPoints of the newly inserted points to the GPU, nodes in the order they were dirtied
+	unsigned int Upload(unsigned int maxPoints);
+
+	// modelView / projection as drawn, viewportHeight in pixels
+	void Select(const glm::mat4& projection, const glm::mat4& modelView, float viewportHeight, unsigned int pointBudget, OctreeSelection& selection) const;
+
+	inline const VertexArray& GetVertexArray() const { return m_VertexArray; }
+	inline unsigned long long GetPointCount() const { return m_PointCount; }
+	inline unsigned long long GetRejectedCount() const { return m_Rejected; }
+	inline unsigned int GetNodeCount() const { return (unsigned int)m_Nodes.size(); }
+	inline unsigned int GetCapacity() const { return m_PageCount * PagePoints; }
+
+private:
+	int CreateNode(const glm::vec3& center, float halfSize, int level);
+	bool AddToNode(int node, const unsigned char* vertex);
+};
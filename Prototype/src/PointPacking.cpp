@@ -0,0 +1,223 @@
+#include "PointPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const char* GetPointFormatName(PointFormat format) {
+	switch (format) {
+		case PointFormat::Float32: return "float";
+		case PointFormat::Half: return "half";
+		case PointFormat::Snorm16: return "snorm16";
+	}
+	return "unknown";
+}
+
+bool ParsePointFormat(const std::string& name, PointFormat& format) {
+	if (name == "float") format = PointFormat::Float32;
+	else if (name == "half") format = PointFormat::Half;
+	else if (name == "snorm16") format = PointFormat::Snorm16;
+	else return false;
+	return true;
+}
+
+unsigned int GetPointStride(PointFormat format) {
+	switch (format) {
+		case PointFormat::Float32: return FloatPointVertex::Stride;
+		case PointFormat::Half: return HalfPointVertex::Stride;
+		case PointFormat::Snorm16: return Snorm16PointVertex::Stride;
+	}
+	return 0;
+}
+
+
+uint16_t FloatToHalf(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+	bits &= 0x7FFFFFFF;
+
+	if (bits >= 0x47800000)										// 65536 and up: inf, or nan kept quiet
+		return sign | (bits > 0x7F800000 ? 0x7E00 : 0x7C00);
+
+	if (bits < 0x38800000) {									// half denormal: let the fpu round the shift
+		float magic, shifted;
+		uint32_t magicBits = 0x3F000000, shiftedBits;
+		std::memcpy(&magic, &magicBits, sizeof(magic));
+		std::memcpy(&shifted, &bits, sizeof(shifted));
+		shifted += magic;
+		std::memcpy(&shiftedBits, &shifted, sizeof(shiftedBits));
+		return sign | (uint16_t)(shiftedBits - magicBits);
+	}
+
+	uint32_t odd = (bits >> 13) & 1;							// round to nearest even
+	bits += 0xC8000FFF + odd;									// rebias 127 -> 15, plus the rounding bias
+	return sign | (uint16_t)(bits >> 13);
+}
+
+float HalfToFloat(uint16_t value) {
+	uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x3FF;
+	float result;
+
+	if (exponent == 0) {										// zero and denormals
+		result = std::ldexp((float)mantissa, -24);
+		return sign ? -result : result;
+	}
+
+	uint32_t bits = sign | (exponent == 31 ? 0x7F800000 | (mantissa << 13) : ((exponent + 112) << 23) | (mantissa << 13));
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+
+void PackOctahedral(const float* normals, unsigned int count, int16_t* out) {
+	for (unsigned int i = 0; i < count; i++, normals += 3, out += 2) {
+		float x = normals[0], y = normals[1], z = normals[2];
+		float inverseL1 = 1.0f / std::max(std::fabs(x) + std::fabs(y) + std::fabs(z), 1e-20f);
+		x *= inverseL1; y *= inverseL1; z *= inverseL1;
+
+		if (z < 0.0f) {											// fold the lower half over the diagonals
+			float fx = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			float fy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+			x = fx; y = fy;
+		}
+
+		out[0] = (int16_t)std::lrint(std::min(std::max(x, -1.0f), 1.0f) * 32767.0f);
+		out[1] = (int16_t)std::lrint(std::min(std::max(y, -1.0f), 1.0f) * 32767.0f);
+	}
+}
+
+glm::vec3 UnpackOctahedral(int16_t x, int16_t y) {
+	glm::vec3 n(std::max(x / 32767.0f, -1.0f), std::max(y / 32767.0f, -1.0f), 0.0f);
+	n.z = 1.0f - std::fabs(n.x) - std::fabs(n.y);
+	float t = std::max(-n.z, 0.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+
+// Scalar reference, any layout. The SIMD kernels below produce the same bytes.
+static void PackScalar(PointFormat format, const PointLayout& layout, const unsigned char* in, unsigned int count,
+	const PointQuantization& quantization, unsigned char* out) {
+
+	unsigned int outStride = GetPointStride(format);
+	float invScale = 1.0f / quantization.scale;
+
+	for (unsigned int i = 0; i < count; i++, in += layout.stride, out += outStride) {
+		float p[3], c[3] = { 1.0f, 1.0f, 1.0f };
+		std::memcpy(p, in + layout.positionOffset, sizeof(p));
+		if (layout.colorOffset >= 0) std::memcpy(c, in + layout.colorOffset, sizeof(c));
+
+		if (format == PointFormat::Float32) {
+			std::memcpy(out, p, sizeof(p));
+			std::memcpy(out + sizeof(p), c, sizeof(c));
+			continue;
+		}
+
+		float w = p[2] == 0.0f ? 0.0f : 1.0f;					// no depth at this pixel
+		float q[4] = { (p[0] - quantization.origin.x) * invScale, (p[1] - quantization.origin.y) * invScale, (p[2] - quantization.origin.z) * invScale, w };
+
+		if (format == PointFormat::Half) {
+			uint16_t h[4];
+			for (int k = 0; k < 4; k++) h[k] = FloatToHalf(q[k]);
+			std::memcpy(out, h, sizeof(h));
+		}
+		else {
+			int16_t s[4];
+			for (int k = 0; k < 4; k++) s[k] = (int16_t)std::lrint(std::min(std::max(q[k], -1.0f), 1.0f) * 32767.0f);
+			std::memcpy(out, s, sizeof(s));
+		}
+
+		unsigned char rgba[4];
+		for (int k = 0; k < 3; k++) rgba[k] = (unsigned char)std::lrint(std::min(std::max(c[k], 0.0f), 1.0f) * 255.0f);
+		rgba[3] = 255;
+		std::memcpy(out + 8, rgba, sizeof(rgba));
+	}
+}
+
+static bool IsFloatPositionColor(const PointLayout& layout) {
+	return layout.stride == FloatPointVertex::Stride && layout.positionOffset == 0 && layout.colorOffset == (int)FloatPointVertex::Offset(1);
+}
+
+#if SIMD_X86
+// r g b x -> 4 bytes, alpha 255
+SIMD_TARGET_SSE41 static inline int PackColor(__m128 c) {
+	__m128 rgba = _mm_mul_ps(_mm_blend_ps(c, _mm_set1_ps(1.0f), 8), _mm_set1_ps(255.0f));
+	__m128i i = _mm_cvtps_epi32(rgba);
+	i = _mm_packs_epi32(i, i);
+	return _mm_cvtsi128_si32(_mm_packus_epi16(i, i));
+}
+
+// the colour load reads one float past the vertex, so the last point is left to the scalar loop
+SIMD_TARGET_SSE41 static unsigned int PackSnorm16SSE41(const float* in, unsigned int count, const PointQuantization& quantization, unsigned char* out) {
+	const __m128 origin = _mm_setr_ps(quantization.origin.x, quantization.origin.y, quantization.origin.z, 0.0f);
+	const __m128 invScale = _mm_set1_ps(1.0f / quantization.scale);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 minusOne = _mm_set1_ps(-1.0f);
+	const __m128 snormMax = _mm_set1_ps(32767.0f);
+
+	unsigned int i = 0;
+	for (; i + 1 < count; i++, in += 6, out += 12) {
+		__m128 v = _mm_loadu_ps(in);								// x y z r
+		__m128 hole = _mm_cmpeq_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), zero);
+		__m128 q = _mm_blend_ps(_mm_mul_ps(_mm_sub_ps(v, origin), invScale), _mm_andnot_ps(hole, one), 8);
+		q = _mm_mul_ps(_mm_min_ps(_mm_max_ps(q, minusOne), one), snormMax);
+
+		__m128i s = _mm_cvtps_epi32(q);
+		_mm_storel_epi64((__m128i*)out, _mm_packs_epi32(s, s));
+		int rgba = PackColor(_mm_loadu_ps(in + 3));
+		std::memcpy(out + 8, &rgba, sizeof(rgba));
+	}
+	return i;
+}
+
+// F16C converts with round to nearest even, matching FloatToHalf
+SIMD_TARGET_AVX2_F16C static unsigned int PackHalfF16C(const float* in, unsigned int count, const PointQuantization& quantization, unsigned char* out) {
+	const __m128 origin = _mm_setr_ps(quantization.origin.x, quantization.origin.y, quantization.origin.z, 0.0f);
+	const __m128 invScale = _mm_set1_ps(1.0f / quantization.scale);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	unsigned int i = 0;
+	for (; i + 1 < count; i++, in += 6, out += 12) {
+		__m128 v = _mm_loadu_ps(in);
+		__m128 hole = _mm_cmpeq_ps(_mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), zero);
+		__m128 q = _mm_blend_ps(_mm_mul_ps(_mm_sub_ps(v, origin), invScale), _mm_andnot_ps(hole, one), 8);
+
+		_mm_storel_epi64((__m128i*)out, _mm_cvtps_ph(q, _MM_FROUND_TO_NEAREST_INT));
+		int rgba = PackColor(_mm_loadu_ps(in + 3));
+		std::memcpy(out + 8, &rgba, sizeof(rgba));
+	}
+	return i;
+}
+#endif
+
+void PackPoints(PointFormat format, const PointLayout& layout, const void* points, unsigned int count,
+	const PointQuantization& quantization, void* out, Simd::Level level) {
+
+	const unsigned char* in = (const unsigned char*)points;
+	unsigned char* dst = (unsigned char*)out;
+	unsigned int done = 0;
+
+	if (format == PointFormat::Float32 && IsFloatPositionColor(layout)) {
+		std::memcpy(dst, in, (size_t)count * FloatPointVertex::Stride);
+		return;
+	}
+
+#if SIMD_X86
+	level = Simd::Clamp(level);
+	if (IsFloatPositionColor(layout)) {
+		if (format == PointFormat::Snorm16 && level >= Simd::Level::SSE41)
+			done = PackSnorm16SSE41((const float*)in, count, quantization, dst);
+		else if (format == PointFormat::Half && level >= Simd::Level::AVX2)
+			done = PackHalfF16C((const float*)in, count, quantization, dst);
+	}
+#endif
+
+	unsigned int outStride = GetPointStride(format);
+	PackScalar(format, layout, in + (size_t)done * layout.stride, count - done, quantization, dst + (size_t)done * outStride);
+}
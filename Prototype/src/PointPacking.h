@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glm/glm.hpp>
+
+#include "BackProjector.h"
+#include "Simd.h"
+#include "VertexBufferLayout.h"
+
+// Vertex formats the point cloud can be uploaded in. The back-projector, voxel filter and
+// octree all work on full floats; PackPoints() converts their output into a smaller
+// format right before it goes into the vertex buffer.
+//
+//   Float32   vec3f position + vec3f colour, 24 bytes
+//   Half      half4 position + rgba8 colour, 12 bytes
+//   Snorm16   snorm16x4 position + rgba8 colour, 12 bytes
+//
+// Packed positions are stored relative to a quantization box and rebuilt in the vertex
+// shader as origin + stored * scale; w is 1 for a point and 0 for a pixel without depth.
+enum class PointFormat {
+	Float32 = 0,
+	Half = 1,
+	Snorm16 = 2
+};
+
+using FloatPointVertex = Layout<attrib::vec3f, attrib::vec3f>;
+using HalfPointVertex = Layout<attrib::half4, attrib::rgba8>;
+using Snorm16PointVertex = Layout<attrib::snorm16x4, attrib::rgba8>;
+
+struct PointQuantization {
+	glm::vec3 origin;
+	float scale;					// metres per stored unit, snorm16 clamps to +-1
+
+	static PointQuantization None() { return { glm::vec3(0.0f), 1.0f }; }
+	static PointQuantization Box(const glm::vec3& center, float halfSize) { return { center, halfSize }; }
+};
+
+const char* GetPointFormatName(PointFormat format);
+bool ParsePointFormat(const std::string& name, PointFormat& format);		// float | half | snorm16
+unsigned int GetPointStride(PointFormat format);
+
+// `count` points in `layout` (float position, optional float colour) into `out` in `format`.
+// Float32 ignores the quantization.
+void PackPoints(PointFormat format, const PointLayout& layout, const void* points, unsigned int count,
+	const PointQuantization& quantization, void* out, Simd::Level level = Simd::Detect());
+
+// Unit normals as two snorm16 on the octahedron, 4 bytes instead of 12
+void PackOctahedral(const float* normals, unsigned int count, int16_t* out);
+glm::vec3 UnpackOctahedral(int16_t x, int16_t y);
+
+uint16_t FloatToHalf(float value);					// round to nearest even, same as F16C
+float HalfToFloat(uint16_t value);
@@ -0,0 +1,172 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+Profiler::Profiler()
+	:m_Epoch(std::chrono::steady_clock::now()), m_Queries(), m_Frame(0), m_FrameStartMs(0.0), m_FrameStage(0),
+	m_GpuActive(false), m_GpuInitialised(false), m_GpuSkipped(0), m_GpuUnavailable(0) {
+
+	m_FrameStage = RegisterStage("Frame", false);
+}
+
+Profiler& Profiler::Get() {
+	static Profiler profiler;
+	return profiler;
+}
+
+unsigned int Profiler::RegisterStage(const char* name, bool gpu) {
+	for (unsigned int i = 0; i < m_Stages.size(); i++)
+		if (m_Stages[i].gpu == gpu && m_Stages[i].name == name) return i;
+
+	m_Stages.push_back({ name, gpu, std::vector<float>(), 0, 0, 0.0 });
+	m_Stages.back().window.reserve(WindowSize);
+	return (unsigned int)m_Stages.size() - 1;
+}
+
+double Profiler::NowMs() const {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Epoch).count();
+}
+
+void Profiler::AddSample(unsigned int stage, double startMs, double durationMs) {
+	Record(stage, m_Frame, startMs, durationMs);
+}
+
+void Profiler::Record(unsigned int stage, unsigned int frame, double startMs, double durationMs) {
+	Stage& s = m_Stages[stage];
+	if (s.window.size() < WindowSize) s.window.push_back((float)durationMs);
+	else s.window[s.next] = (float)durationMs;
+	s.next = (s.next + 1) % WindowSize;
+	s.samples++;
+	s.total += durationMs;
+
+	if (m_Events.size() < MaxEvents)
+		m_Events.push_back({ stage, frame, startMs, (float)durationMs });
+}
+
+void Profiler::BeginFrame() {
+	m_Frame++;
+	m_FrameStartMs = NowMs();
+	if (!m_GpuInitialised) return;
+
+	// collect the queries issued FramesInFlight frames ago, then recycle the slot
+	FrameQueries& slot = m_Queries[m_Frame % FramesInFlight];
+	for (unsigned int i = 0; i < slot.used; i++) {
+		GLint available = 0;
+		glGetQueryObjectiv(slot.ids[i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			m_GpuUnavailable++;
+			continue;
+		}
+
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(slot.ids[i], GL_QUERY_RESULT, &ns);
+		Record(slot.pending[i].stage, slot.frame, slot.pending[i].cpuStartMs, ns / 1.0e6);
+	}
+	slot.used = 0;
+	slot.frame = m_Frame;
+}
+
+void Profiler::EndFrame() {
+	AddSample(m_FrameStage, m_FrameStartMs, NowMs() - m_FrameStartMs);
+}
+
+bool Profiler::BeginGpu(unsigned int stage) {
+	if (!m_GpuInitialised) {
+		for (FrameQueries& slot : m_Queries) {
+			glGenQueries(QueriesPerFrame, slot.ids);
+			slot.used = 0;
+			slot.frame = m_Frame;
+		}
+		m_GpuInitialised = true;
+	}
+
+	// GL_TIME_ELAPSED queries can't nest
+	FrameQueries& slot = m_Queries[m_Frame % FramesInFlight];
+	if (m_GpuActive || slot.used == QueriesPerFrame) {
+		m_GpuSkipped++;
+		return false;
+	}
+
+	slot.pending[slot.used] = { stage, NowMs() };
+	glBeginQuery(GL_TIME_ELAPSED, slot.ids[slot.used]);
+	slot.used++;
+	m_GpuActive = true;
+	return true;
+}
+
+void Profiler::EndGpu() {
+	glEndQuery(GL_TIME_ELAPSED);
+	m_GpuActive = false;
+}
+
+ProfileStats Profiler::GetStats(unsigned int stage) const {
+	const Stage& s = m_Stages[stage];
+	ProfileStats stats = { 0.0f, 0.0f, 0.0f, 0.0f, s.samples };
+	if (s.window.empty()) return stats;
+
+	std::vector<float> sorted(s.window);
+	std::sort(sorted.begin(), sorted.end());
+	auto at = [&](float p) { return sorted[std::min((size_t)(p * sorted.size()), sorted.size() - 1)]; };
+
+	stats.p50 = at(0.50f);
+	stats.p95 = at(0.95f);
+	stats.p99 = at(0.99f);
+	stats.mean = (float)(s.total / s.samples);
+	return stats;
+}
+
+void Profiler::Report(std::ostream& stream) const {
+	stream << std::left << std::setw(16) << "stage" << std::right
+		<< std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "mean ms" << std::setw(10) << "samples" << std::endl;
+
+	for (unsigned int i = 0; i < m_Stages.size(); i++) {
+		ProfileStats stats = GetStats(i);
+		stream << std::left << std::setw(16) << (m_Stages[i].name + (m_Stages[i].gpu ? " (gpu)" : "")) << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(10) << stats.p50 << std::setw(10) << stats.p95 << std::setw(10) << stats.p99 << std::setw(10) << stats.mean
+			<< std::setw(10) << stats.samples << std::endl;
+	}
+
+	if (m_GpuSkipped || m_GpuUnavailable)
+		stream << "gpu scopes skipped: " << m_GpuSkipped << ", results not ready in time: " << m_GpuUnavailable << std::endl;
+}
+
+bool Profiler::WriteCsv(const std::string& filepath) const {
+	std::ofstream stream(filepath);
+	if (!stream) return false;
+
+	stream << "frame,stage,timeline,start_ms,duration_ms\n";
+	for (const Event& e : m_Events) {
+		const Stage& s = m_Stages[e.stage];
+		stream << e.frame << ',' << s.name << ',' << (s.gpu ? "gpu" : "cpu") << ',' << e.startMs << ',' << e.durationMs << '\n';
+	}
+	return true;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& filepath) const {
+	std::ofstream stream(filepath);
+	if (!stream) return false;
+
+	// chrome://tracing / Perfetto "complete" events; GPU scopes sit on their own track at their CPU submit time
+	stream << "{\"traceEvents\":[\n";
+	for (size_t i = 0; i < m_Events.size(); i++) {
+		const Event& e = m_Events[i];
+		const Stage& s = m_Stages[e.stage];
+		stream << std::fixed << std::setprecision(3)
+			<< "{\"name\":\"" << s.name << "\",\"cat\":\"" << (s.gpu ? "gpu" : "cpu") << "\",\"ph\":\"X\""
+			<< ",\"ts\":" << e.startMs * 1000.0 << ",\"dur\":" << e.durationMs * 1000.0
+			<< ",\"pid\":0,\"tid\":" << (s.gpu ? 1 : 0) << ",\"args\":{\"frame\":" << e.frame << "}}"
+			<< (i + 1 < m_Events.size() ? ",\n" : "\n");
+	}
+	stream << "],\"displayTimeUnit\":\"ms\"}\n";
+	return true;
+}
+
+void Profiler::Shutdown() {
+	if (!m_GpuInitialised) return;
+	if (m_GpuActive) EndGpu();
+	for (FrameQueries& slot : m_Queries)
+		glDeleteQueries(QueriesPerFrame, slot.ids);
+	m_GpuInitialised = false;
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Set to 0 to compile every PROFILE_* macro out
+#ifndef PROFILING
+#define PROFILING 1
+#endif
+
+struct ProfileStats {
+	float p50, p95, p99;				// milliseconds over the rolling window
+	float mean;
+	unsigned long long samples;			// since start
+};
+
+// Frame profiler. CPU scopes are timed with steady_clock, GPU scopes with GL_TIME_ELAPSED
+// queries from a pool that is FramesInFlight frames deep, so results are read back
+// several frames late and never stall the pipeline. Render thread only.
+class Profiler {
+public:
+	static const unsigned int FramesInFlight = 4;
+	static const unsigned int QueriesPerFrame = 32;
+	static const unsigned int WindowSize = 512;			// samples kept per stage for percentiles
+	static const unsigned int MaxEvents = 1 << 18;		// trace events kept for the dump
+private:
+	struct Stage {
+		std::string name;
+		bool gpu;
+		std::vector<float> window;
+		unsigned int next;
+		unsigned long long samples;
+		double total;
+	};
+
+	struct Event {
+		unsigned int stage;
+		unsigned int frame;
+		double startMs;
+		float durationMs;
+	};
+
+	struct PendingQuery {
+		unsigned int stage;
+		double cpuStartMs;					// where the scope started on the CPU timeline, for the trace
+	};
+
+	struct FrameQueries {
+		unsigned int ids[QueriesPerFrame];
+		PendingQuery pending[QueriesPerFrame];
+		unsigned int used;
+		unsigned int frame;
+	};
+
+	std::chrono::steady_clock::time_point m_Epoch;
+	std::vector<Stage> m_Stages;
+	std::vector<Event> m_Events;
+	FrameQueries m_Queries[FramesInFlight];
+	unsigned int m_Frame;
+	double m_FrameStartMs;
+	unsigned int m_FrameStage;
+	bool m_GpuActive;
+	bool m_GpuInitialised;
+	unsigned int m_GpuSkipped;				// scopes dropped because one was already open or the pool ran out
+	unsigned int m_GpuUnavailable;			// results still not ready FramesInFlight frames later
+
+	Profiler();
+public:
+	static Profiler& Get();
+
+	unsigned int RegisterStage(const char* name, bool gpu);
+
+	void BeginFrame();
+	void EndFrame();
+
+	double NowMs() const;
+	void AddSample(unsigned int stage, double startMs, double durationMs);
+
+	bool BeginGpu(unsigned int stage);		// false when the scope could not get a query
+	void EndGpu();
+
+	ProfileStats GetStats(unsigned int stage) const;
+	void Report(std::ostream& stream) const;
+	bool WriteCsv(const std::string& filepath) const;
+	bool WriteChromeTrace(const std::string& filepath) const;
+
+	void Shutdown();						// releases the query pool, needs the GL context
+
+private:
+	void Record(unsigned int stage, unsigned int frame, double startMs, double durationMs);
+};
+
+class CpuProfileScope {
+private:
+	unsigned int m_Stage;
+	double m_Start;
+public:
+	CpuProfileScope(unsigned int stage)
+		:m_Stage(stage), m_Start(Profiler::Get().NowMs()) {}
+	~CpuProfileScope() {
+		Profiler& profiler = Profiler::Get();
+		profiler.AddSample(m_Stage, m_Start, profiler.NowMs() - m_Start);
+	}
+};
+
+class GpuProfileScope {
+private:
+	bool m_Active;
+public:
+	GpuProfileScope(unsigned int stage)
+		:m_Active(Profiler::Get().BeginGpu(stage)) {}
+	~GpuProfileScope() {
+		if (m_Active) Profiler::Get().EndGpu();
+	}
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if PROFILING
+#define PROFILE_SCOPE(name) \
+	static const unsigned int PROFILE_CONCAT(s_CpuStage, __LINE__) = Profiler::Get().RegisterStage(name, false);\
+	CpuProfileScope PROFILE_CONCAT(cpuScope, __LINE__)(PROFILE_CONCAT(s_CpuStage, __LINE__))
+#define PROFILE_GPU_SCOPE(name) \
+	static const unsigned int PROFILE_CONCAT(s_GpuStage, __LINE__) = Profiler::Get().RegisterStage(name, true);\
+	GpuProfileScope PROFILE_CONCAT(gpuScope, __LINE__)(PROFILE_CONCAT(s_GpuStage, __LINE__))
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#endif
@@ -0,0 +1,246 @@
+#include "Recording.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+static const char s_HeaderMagic[4] = { 'K', 'V', 'R', '1' };
+static const uint32_t s_ChunkMagic = 0x4652564B;		// "KVRF"
+static const uint32_t s_Version = 1;
+static const size_t s_Alignment = 64;
+
+static size_t AlignUp(size_t value) {
+	return (value + s_Alignment - 1) & ~(s_Alignment - 1);
+}
+
+static unsigned int ColorBytesPerPixel(ColorFormat format) {
+	return format == ColorFormat::None ? 0 : 4;
+}
+
+
+RecordingWriter::RecordingWriter(const std::string& filepath, const CameraIntrinsics& intrinsics, double frameRate, DepthCodec codec,
+	ColorFormat colorFormat, int colorWidth, int colorHeight)
+	:m_FilePath(filepath), m_Stream(filepath, std::ios::binary | std::ios::trunc), m_Header() {
+
+	if (!m_Stream.is_open()) {
+		std::cout << "Warning: could not create recording " << filepath << std::endl;
+		return;
+	}
+
+	std::memcpy(m_Header.magic, s_HeaderMagic, 4);
+	m_Header.version = s_Version;
+	m_Header.headerSize = sizeof(RecordingHeader);
+	m_Header.frameRate = frameRate;
+	m_Header.depthWidth = intrinsics.width;
+	m_Header.depthHeight = intrinsics.height;
+	m_Header.fx = intrinsics.fx;
+	m_Header.fy = intrinsics.fy;
+	m_Header.cx = intrinsics.cx;
+	m_Header.cy = intrinsics.cy;
+	m_Header.depthScale = intrinsics.depthScale;
+	m_Header.k1 = intrinsics.k1;
+	m_Header.k2 = intrinsics.k2;
+	m_Header.k3 = intrinsics.k3;
+	m_Header.p1 = intrinsics.p1;
+	m_Header.p2 = intrinsics.p2;
+	m_Header.depthCodec = (uint32_t)codec;
+	m_Header.colorFormat = (uint32_t)colorFormat;
+	m_Header.colorWidth = colorFormat == ColorFormat::None ? 0 : colorWidth;
+	m_Header.colorHeight = colorFormat == ColorFormat::None ? 0 : colorHeight;
+
+	if (codec != DepthCodec::Raw16) m_Encoded.resize(GetMaxEncodedSize(codec, intrinsics.width * intrinsics.height));
+
+	// placeholder until Close() knows the frame count and index position
+	m_Stream.write((const char*)&m_Header, sizeof(m_Header));
+	Pad();
+}
+
+RecordingWriter::~RecordingWriter() {
+	Close();
+}
+
+bool RecordingWriter::WriteFrame(double timestamp, const uint16_t* depth, const unsigned char* color) {
+	DepthCodec codec = (DepthCodec)m_Header.depthCodec;
+	unsigned int count = m_Header.depthWidth * m_Header.depthHeight;
+	if (codec == DepthCodec::Raw16) return WriteEncodedFrame(timestamp, codec, depth, count * sizeof(uint16_t), color);
+
+	size_t bytes = EncodeDepth(codec, depth, count, m_Encoded.data());
+	return WriteEncodedFrame(timestamp, codec, m_Encoded.data(), (unsigned int)bytes, color);
+}
+
+bool RecordingWriter::WriteEncodedFrame(double timestamp, DepthCodec codec, const void* depth, unsigned int depthBytes, const unsigned char* color) {
+	if (!m_Stream.is_open()) return false;
+
+	// one codec per file, fixed by the first frame
+	if (m_Index.empty()) m_Header.depthCodec = (uint32_t)codec;
+	else if (m_Header.depthCodec != (uint32_t)codec) return false;
+
+	RecordingChunk chunk = {};
+	chunk.magic = s_ChunkMagic;
+	chunk.frameIndex = (uint32_t)m_Index.size();
+	chunk.timestamp = timestamp;
+	chunk.depthBytes = depthBytes;
+	chunk.colorBytes = color ? m_Header.colorWidth * m_Header.colorHeight * ColorBytesPerPixel((ColorFormat)m_Header.colorFormat) : 0;
+
+	RecordingIndexEntry entry = { (uint64_t)m_Stream.tellp(), timestamp, chunk.depthBytes, chunk.colorBytes };
+
+	m_Stream.write((const char*)&chunk, sizeof(chunk));
+	m_Stream.write((const char*)depth, depthBytes);
+	Pad();
+	if (chunk.colorBytes) {
+		m_Stream.write((const char*)color, chunk.colorBytes);
+		Pad();
+	}
+
+	if (!m_Stream) return false;
+	m_Index.push_back(entry);
+	return true;
+}
+
+bool RecordingWriter::Close() {
+	if (!m_Stream.is_open()) return false;
+
+	m_Header.frameCount = (uint32_t)m_Index.size();
+	m_Header.indexOffset = (uint64_t)m_Stream.tellp();
+	m_Stream.write((const char*)m_Index.data(), m_Index.size() * sizeof(RecordingIndexEntry));
+
+	m_Stream.seekp(0);
+	m_Stream.write((const char*)&m_Header, sizeof(m_Header));
+
+	bool ok = (bool)m_Stream;
+	m_Stream.close();
+	return ok;
+}
+
+void RecordingWriter::Pad() {
+	static const char zeros[s_Alignment] = {};
+	size_t position = (size_t)m_Stream.tellp();
+	m_Stream.write(zeros, AlignUp(position) - position);
+}
+
+
+RecordingReader::RecordingReader(const std::string& filepath)
+	:m_File(filepath), m_Header(nullptr), m_Index(nullptr), m_Intrinsics() {
+
+	if (!m_File.IsOpen() || m_File.GetSize() < sizeof(RecordingHeader)) {
+		std::cout << "Warning: could not open recording " << filepath << std::endl;
+		return;
+	}
+
+	const RecordingHeader* header = (const RecordingHeader*)m_File.GetData();
+	size_t indexBytes = (size_t)header->frameCount * sizeof(RecordingIndexEntry);
+	if (std::memcmp(header->magic, s_HeaderMagic, 4) != 0 || header->version != s_Version || header->depthCodec > (uint32_t)DepthCodec::DeltaVByte
+		|| header->indexOffset == 0 || header->indexOffset + indexBytes > m_File.GetSize()) {
+		std::cout << "Warning: " << filepath << " is not a complete .kvr recording" << std::endl;
+		return;
+	}
+
+	// validate the index once so GetFrame can trust it
+	const RecordingIndexEntry* index = (const RecordingIndexEntry*)(m_File.GetData() + header->indexOffset);
+	DepthCodec codec = (DepthCodec)header->depthCodec;
+	unsigned int count = header->depthWidth * header->depthHeight;
+	for (uint32_t i = 0; i < header->frameCount; i++) {
+		uint64_t end = index[i].offset + sizeof(RecordingChunk) + AlignUp(index[i].depthBytes) + index[i].colorBytes;
+		bool sizeOk = codec == DepthCodec::Raw16 ? index[i].depthBytes == count * sizeof(uint16_t) : index[i].depthBytes <= GetMaxEncodedSize(codec, count);
+		if (index[i].offset % s_Alignment != 0 || end > header->indexOffset || !sizeOk) {
+			std::cout << "Warning: " << filepath << " has a corrupt index at frame " << i << std::endl;
+			return;
+		}
+	}
+
+	m_Header = header;
+	m_Index = index;
+	m_Intrinsics = { header->depthWidth, header->depthHeight, header->fx, header->fy, header->cx, header->cy,
+		header->depthScale, header->k1, header->k2, header->k3, header->p1, header->p2 };
+}
+
+RecordedFrame RecordingReader::GetFrame(unsigned int index) const {
+	const RecordingIndexEntry& entry = m_Index[index];
+	const unsigned char* chunk = m_File.GetData() + entry.offset;
+	const unsigned char* depth = chunk + sizeof(RecordingChunk);
+
+	RecordedFrame frame;
+	frame.index = index;
+	frame.timestamp = entry.timestamp;
+	frame.codec = (DepthCodec)m_Header->depthCodec;
+	frame.depth = depth;
+	frame.depthBytes = entry.depthBytes;
+	frame.color = entry.colorBytes ? depth + AlignUp(entry.depthBytes) : nullptr;
+	frame.colorBytes = entry.colorBytes;
+	return frame;
+}
+
+unsigned int RecordingReader::FindFrame(double timestamp) const {
+	const RecordingIndexEntry* end = m_Index + m_Header->frameCount;
+	const RecordingIndexEntry* it = std::upper_bound(m_Index, end, timestamp,
+		[](double t, const RecordingIndexEntry& entry) { return t < entry.timestamp; });
+	return it == m_Index ? 0 : (unsigned int)(it - m_Index - 1);
+}
+
+double RecordingReader::GetDuration() const {
+	if (GetFrameCount() == 0) return 0.0;
+	return m_Index[m_Header->frameCount - 1].timestamp - m_Index[0].timestamp + 1.0 / m_Header->frameRate;
+}
+
+
+RecordingPlayer::RecordingPlayer(const RecordingReader& reader, double speed, bool loop)
+	:m_Reader(reader), m_Speed(speed), m_Loop(loop), m_StartTime(0.0), m_Frame(0), m_Started(false), m_Finished(false) {}
+
+bool RecordingPlayer::Advance(double now, unsigned int& frame) {
+	unsigned int count = m_Reader.GetFrameCount();
+	if (count == 0 || m_Finished) return false;
+
+	if (!m_Started) {
+		Seek(0, now);
+		frame = m_Frame;
+		return true;
+	}
+
+	unsigned int next;
+	if (m_Speed <= 0.0) {
+		next = m_Frame + 1;
+		if (next == count) {
+			if (!m_Loop) { m_Finished = true; return false; }
+			next = 0;
+		}
+	}
+	else {
+		double duration = m_Reader.GetDuration();
+		double t = (now - m_StartTime) * m_Speed;
+		if (t >= duration) {
+			if (!m_Loop) { m_Finished = true; return false; }
+			t = std::fmod(t, duration);
+		}
+		next = m_Reader.FindFrame(m_Reader.GetFrame(0).timestamp + t);
+	}
+
+	if (next == m_Frame) return false;
+	m_Frame = next;
+	frame = next;
+	return true;
+}
+
+void RecordingPlayer::Seek(unsigned int frame, double now) {
+	m_Frame = std::min(frame, m_Reader.GetFrameCount() - 1);
+	double offset = m_Reader.GetFrame(m_Frame).timestamp - m_Reader.GetFrame(0).timestamp;
+	m_StartTime = now - (m_Speed > 0.0 ? offset / m_Speed : 0.0);
+	m_Started = true;
+	m_Finished = false;
+}
+
+
+RecordingTap::RecordingTap(FrameSource& source, const std::string& filepath, DepthCodec codec)
+	:m_Source(source) {
+
+	bool stream = filepath.size() >= 4 && filepath.compare(filepath.size() - 4, 4, ".kvd") == 0;
+	if (stream) m_Stream.reset(new DepthStreamWriter(filepath, source.GetIntrinsics(), source.GetFrameRate(), codec));
+	else m_Writer.reset(new RecordingWriter(filepath, source.GetIntrinsics(), source.GetFrameRate(), codec));
+}
+
+bool RecordingTap::ReadFrame(DepthFrame& frame) {
+	if (!m_Source.ReadFrame(frame)) return false;
+	if (m_Writer) m_Writer->WriteFrame(frame.timestamp, frame.depth.data());
+	else m_Stream->WriteFrame(frame.timestamp, frame.depth.data());
+	return true;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "DepthCodec.h"
+#include "FrameSource.h"
+#include "MappedFile.h"
+
+// .kvr session recordings
+//
+//   RecordingHeader                       128 bytes, intrinsics + stream description
+//   frame chunk * frameCount              RecordingChunk (64 bytes) + depth plane (DepthCodec) + colour plane,
+//                                         every plane starts on a 64 byte boundary
+//   RecordingIndexEntry * frameCount      at header.indexOffset, one entry per frame
+//
+// Little-endian throughout. The index makes seeking to any frame O(1), and because
+// planes are aligned inside a mapped file the reader can hand out pointers without copying.
+
+enum class ColorFormat : uint32_t {
+	None = 0,
+	RGBA8 = 1,
+	BGRA8 = 2
+};
+
+struct RecordingHeader {
+	char magic[4];					// "KVR1"
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t frameCount;
+	uint64_t indexOffset;			// 0 until the writer is closed
+	double frameRate;
+	int32_t depthWidth, depthHeight;
+	float fx, fy, cx, cy;
+	float depthScale;
+	float k1, k2, k3, p1, p2;
+	uint32_t depthCodec;			// DepthCodec, one per file
+	int32_t colorWidth, colorHeight;
+	uint32_t colorFormat;
+	uint8_t reserved[32];
+};
+
+struct RecordingChunk {
+	uint32_t magic;					// "KVRF"
+	uint32_t frameIndex;
+	double timestamp;				// seconds
+	uint32_t depthBytes;			// encoded size
+	uint32_t colorBytes;
+	uint8_t reserved[40];
+};
+
+struct RecordingIndexEntry {
+	uint64_t offset;				// of the RecordingChunk
+	double timestamp;
+	uint32_t depthBytes;
+	uint32_t colorBytes;
+};
+
+static_assert(sizeof(RecordingHeader) == 128, "RecordingHeader layout changed");
+static_assert(sizeof(RecordingChunk) == 64, "RecordingChunk layout changed");
+static_assert(sizeof(RecordingIndexEntry) == 24, "RecordingIndexEntry layout changed");
+
+// One frame, pointing straight into the mapped file
+struct RecordedFrame {
+	unsigned int index;
+	double timestamp;
+	DepthCodec codec;
+	const void* depth;
+	unsigned int depthBytes;
+	const unsigned char* color;		// nullptr when the recording has no colour
+	unsigned int colorBytes;
+
+	inline const uint16_t* GetDepth16() const { return codec == DepthCodec::Raw16 ? (const uint16_t*)depth : nullptr; }		// zero copy, raw recordings only
+	inline bool DecodeDepth(uint16_t* out, unsigned int count) const { return ::DecodeDepth(codec, depth, depthBytes, out, count); }
+};
+
+class RecordingWriter {
+private:
+	std::string m_FilePath;
+	std::ofstream m_Stream;
+	RecordingHeader m_Header;
+	std::vector<RecordingIndexEntry> m_Index;
+	std::vector<unsigned char> m_Encoded;
+public:
+	RecordingWriter(const std::string& filepath, const CameraIntrinsics& intrinsics, double frameRate, DepthCodec codec = DepthCodec::Raw16,
+		ColorFormat colorFormat = ColorFormat::None, int colorWidth = 0, int colorHeight = 0);
+	~RecordingWriter();
+
+	bool WriteFrame(double timestamp, const uint16_t* depth, const unsigned char* color = nullptr);		// encodes with the file's codec
+	bool WriteEncodedFrame(double timestamp, DepthCodec codec, const void* depth, unsigned int depthBytes, const unsigned char* color = nullptr);
+	bool Close();					// writes the index and patches the header
+
+	inline bool IsOpen() const { return m_Stream.is_open(); }
+	inline unsigned int GetFrameCount() const { return (unsigned int)m_Index.size(); }
+
+private:
+	void Pad();
+};
+
+class RecordingReader {
+private:
+	MappedFile m_File;
+	const RecordingHeader* m_Header;
+	const RecordingIndexEntry* m_Index;
+	CameraIntrinsics m_Intrinsics;
+public:
+	RecordingReader(const std::string& filepath);
+
+	inline bool IsOpen() const { return m_Header != nullptr; }
+	inline unsigned int GetFrameCount() const { return m_Header ? m_Header->frameCount : 0; }
+	inline double GetFrameRate() const { return m_Header->frameRate; }
+	inline const CameraIntrinsics& GetIntrinsics() const { return m_Intrinsics; }
+	inline const RecordingHeader& GetHeader() const { return *m_Header; }
+
+	RecordedFrame GetFrame(unsigned int index) const;		// O(1) through the index
+	unsigned int FindFrame(double timestamp) const;		// last frame at or before timestamp
+	double GetDuration() const;
+};
+
+// Decides which recorded frame to show. speed 1 is real time, 0 means "as fast as
+// possible": every call advances exactly one frame, for batch processing.
+class RecordingPlayer {
+private:
+	const RecordingReader& m_Reader;
+	double m_Speed;
+	bool m_Loop;
+	double m_StartTime;
+	unsigned int m_Frame;
+	bool m_Started;
+	bool m_Finished;
+public:
+	RecordingPlayer(const RecordingReader& reader, double speed = 1.0, bool loop = true);
+
+	bool Advance(double now, unsigned int& frame);			// false when the frame to show hasn't changed
+	void Seek(unsigned int frame, double now);
+
+	inline bool IsFinished() const { return m_Finished; }
+};
+
+// FrameSource that writes every frame of another source into a recording as it passes through.
+// A path ending in .kvd writes a sequential DepthStreamWriter stream instead of a .kvr.
+class RecordingTap : public FrameSource {
+private:
+	FrameSource& m_Source;
+	std::unique_ptr<RecordingWriter> m_Writer;
+	std::unique_ptr<DepthStreamWriter> m_Stream;
+public:
+	RecordingTap(FrameSource& source, const std::string& filepath, DepthCodec codec = DepthCodec::Raw16);
+
+	bool ReadFrame(DepthFrame& frame) override;
+	inline const CameraIntrinsics& GetIntrinsics() const override { return m_Source.GetIntrinsics(); }
+	inline double GetFrameRate() const override { return m_Source.GetFrameRate(); }
+	inline unsigned int GetFrameCount() const { return m_Writer ? m_Writer->GetFrameCount() : m_Stream->GetFrameCount(); }
+};
@@ -0,0 +1,127 @@
+#include "RenderQueue.h"
+
+#include <cstring>
+#include <utility>
+
+#include "IndexBuffer.h"
+#include "Renderer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "VertexArray.h"
+
+static const uint64_t s_IdMask = 0xfff;
+static const uint64_t s_DepthMask = 0xffffff;
+
+// positive floats order like their bit patterns; the top 24 of the 31 magnitude bits are
+// plenty to order draws, and no near/far range has to be known up front
+static uint64_t QuantizeDepth(float depth) {
+	if (!(depth > 0.0f)) return 0;							// behind the eye (or NaN): nearest, so first opaque, last transparent
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return (bits >> 7) & s_DepthMask;
+}
+
+RenderQueue::RenderQueue(unsigned int maxDraws)
+	:m_MaxDraws(maxDraws), m_Camera(sizeof(CameraBlock)), m_Objects(maxDraws * UniformRing::GetAlignedSize(sizeof(ObjectBlock))), m_View(1.0f), m_Projection(1.0f), m_Sorting(true), m_Stats() {
+}
+
+uint64_t RenderQueue::MakeKey(RenderLayer layer, unsigned int program, unsigned int vertexArray, unsigned int texture, float depth) {
+	uint64_t state = ((program & s_IdMask) << 24) | ((vertexArray & s_IdMask) << 12) | (texture & s_IdMask);
+	uint64_t z = QuantizeDepth(depth);
+	uint64_t key = (uint64_t)layer << 60;
+
+	if (layer == RenderLayer::Transparent)
+		return key | ((s_DepthMask - z) << 36) | state;
+	return key | (state << 24) | z;
+}
+
+void RenderQueue::Begin(const glm::mat4& view, const glm::mat4& projection) {
+	m_View = view;
+	m_Projection = projection;
+	m_Commands.clear();
+	m_Entries.clear();
+}
+
+bool RenderQueue::Submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const glm::mat4& model, Texture* texture, RenderLayer layer) {
+	if (m_Commands.size() >= m_MaxDraws) return false;
+
+	float depth = -(m_View * model[3]).z;					// view space distance of the model origin
+	uint64_t key = MakeKey(layer, shader.GetRendererID(), va.GetRendererID(), texture ? texture->GetRendererID() : 0, depth);
+
+	m_Entries.push_back({ key, (unsigned int)m_Commands.size() });
+	m_Commands.push_back({ &va, &ib, &shader, texture, model });
+	return true;
+}
+
+// LSD radix sort, 8 bits per pass, stable; passes where every key has the same byte are skipped,
+// which with a handful of programs / arrays is most of the state bits
+void RenderQueue::Sort() {
+	size_t count = m_Entries.size();
+	if (count < 2) return;
+	m_Scratch.resize(count);
+
+	SortEntry* src = m_Entries.data();
+	SortEntry* dst = m_Scratch.data();
+	for (unsigned int shift = 0; shift < 64; shift += 8) {
+		size_t histogram[256] = {};
+		for (size_t i = 0; i < count; i++) histogram[(src[i].key >> shift) & 0xff]++;
+		if (histogram[(src[0].key >> shift) & 0xff] == count) continue;
+
+		size_t offset = 0;
+		for (size_t& bucket : histogram) {
+			size_t n = bucket;
+			bucket = offset;
+			offset += n;
+		}
+		for (size_t i = 0; i < count; i++) dst[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+		std::swap(src, dst);
+	}
+	if (src != m_Entries.data()) m_Entries.swap(m_Scratch);
+}
+
+void RenderQueue::Execute() {
+	if (m_Sorting) Sort();
+	m_Stats = {};
+
+	GLint viewport[4];
+	GLCall(glGetIntegerv(GL_VIEWPORT, viewport));
+	CameraBlock camera = CameraBlock::From(m_View, m_Projection, glm::vec4(viewport[0], viewport[1], viewport[2], viewport[3]));
+	m_Camera.SetData(&camera, sizeof(camera));
+	m_Camera.Bind(UniformBinding::Camera);
+
+	// model matrices in draw order, one write for the frame
+	m_Objects.Begin();
+	m_Offsets.resize(m_Entries.size());
+	for (size_t i = 0; i < m_Entries.size(); i++)
+		m_Offsets[i] = m_Objects.Push(&m_Commands[m_Entries[i].command].model, sizeof(ObjectBlock));
+	m_Objects.Upload();
+
+	const Shader* shader = nullptr;
+	const VertexArray* va = nullptr;
+	const Texture* texture = nullptr;
+	for (size_t i = 0; i < m_Entries.size(); i++) {
+		const Command& command = m_Commands[m_Entries[i].command];
+
+		if (command.shader != shader) {
+			shader = command.shader;
+			shader->Bind();
+			m_Stats.programSwitches++;
+		}
+		if (command.va != va) {
+			va = command.va;
+			va->Bind();
+			m_Stats.vertexArraySwitches++;
+		}
+		if (command.texture && command.texture != texture) {
+			texture = command.texture;
+			command.texture->Bind(0);
+			m_Stats.textureSwitches++;
+		}
+
+		command.ib->Bind();
+		m_Objects.Bind(UniformBinding::Object, m_Offsets[i], sizeof(ObjectBlock));
+		GLCall(glDrawElements(GL_TRIANGLES, command.ib->GetCount(), GL_UNSIGNED_INT, nullptr));
+		m_Stats.draws++;
+	}
+	m_Objects.End();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "UniformBuffer.h"
+
+class VertexArray;
+class IndexBuffer;
+class Shader;
+class Texture;
+
+enum class RenderLayer : unsigned int {
+	Opaque = 0,								// state first, then front-to-back for early-Z
+	Transparent = 1							// back-to-front, then state; blending is up to the shader / caller
+};
+
+struct RenderQueueStats {
+	unsigned int draws;
+	unsigned int programSwitches;
+	unsigned int vertexArraySwitches;
+	unsigned int textureSwitches;
+};
+
+// Deferred draw list. Submit() records a draw with a 64-bit sort key, Renderer::Draw(queue)
+// radix-sorts the keys and executes, so draws sharing a program / vertex array / texture run
+// back to back and opaque geometry goes front-to-back. Key, high to low bits:
+//   Opaque       layer:4 | program:12 | vertex array:12 | texture:12 | depth:24
+//   Transparent  layer:4 | ~depth:24  | program:12 | vertex array:12 | texture:12
+// Ids are the GL names cut to 12 bits; a collision only costs ordering, never correctness.
+// The camera goes out once per Execute and each model matrix as an Object block range of a
+// UniformRing, so shaders take the Camera and Object blocks (res/shaders/Chunk.shader) and no
+// uniform is set per draw.
+class RenderQueue {
+private:
+	struct Command {
+		const VertexArray* va;
+		const IndexBuffer* ib;
+		const Shader* shader;
+		Texture* texture;					// optional, bound to unit 0
+		glm::mat4 model;
+	};
+	struct SortEntry {
+		uint64_t key;
+		unsigned int command;
+	};
+
+	std::vector<Command> m_Commands;
+	std::vector<SortEntry> m_Entries;
+	std::vector<SortEntry> m_Scratch;		// radix sort ping-pong
+	std::vector<unsigned int> m_Offsets;	// Object block of each entry in m_Objects
+	unsigned int m_MaxDraws;
+	UniformBuffer m_Camera;
+	UniformRing m_Objects;
+	glm::mat4 m_View;
+	glm::mat4 m_Projection;
+	bool m_Sorting;
+	RenderQueueStats m_Stats;
+public:
+	RenderQueue(unsigned int maxDraws = 16384);
+
+	void Begin(const glm::mat4& view, const glm::mat4& projection);		// clears the queue
+	bool Submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const glm::mat4& model,
+		Texture* texture = nullptr, RenderLayer layer = RenderLayer::Opaque);		// false once maxDraws are queued
+
+	// sorts (unless disabled) and issues every draw; call through Renderer::Draw(queue)
+	void Execute();
+
+	inline void SetSorting(bool sorting) { m_Sorting = sorting; }		// off: submission order, for comparison
+	inline unsigned int GetSize() const { return (unsigned int)m_Commands.size(); }
+	inline const RenderQueueStats& GetStats() const { return m_Stats; }	// the last Execute
+
+	static uint64_t MakeKey(RenderLayer layer, unsigned int program, unsigned int vertexArray, unsigned int texture, float depth);
+
+private:
+	void Sort();
+};
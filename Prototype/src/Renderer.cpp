@@ -1,12 +1,22 @@
 ﻿#include "Renderer.h"
 
+#include <cstring>
 #include <iostream>
 
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "DrawBatch.h"
+#include "RenderQueue.h"
+#include "Profiler.h"
 
 
+#if GL_ERROR_CHECKING
+GLErrorMode g_GLErrorMode = GLErrorMode::PerCall;
+#else
+GLErrorMode g_GLErrorMode = GLErrorMode::FrameSweep;
+#endif
+
 void GLClearError() {
     // Clear all errors
     while (glGetError() != GL_NO_ERROR) {}
@@ -14,19 +24,122 @@ void GLClearError() {
 
 bool GLLogCall(const char* function, const char* file, int line) {
     while (GLenum error = glGetError()) {
-        std::cout << "[OpenGL Error] (" << function << " , " << file << " , " << line << std::endl;
+        std::cout << "[OpenGL Error] (0x" << std::hex << error << std::dec << ") " << function << " , " << file << " , " << line << std::endl;
         return false;
     }
     return true;
 }
 
+static void GLAPIENTRY GLDebugMessage(GLenum /*source*/, GLenum type, GLuint id, GLenum severity, GLsizei /*length*/, const GLchar* message, const void* /*userParam*/) {
+    if (severity == GL_DEBUG_SEVERITY_NOTIFICATION) return;
+    std::cout << "[OpenGL Debug] (" << (type == GL_DEBUG_TYPE_ERROR ? "error" : "message") << " 0x" << std::hex << id << std::dec << ") " << message << std::endl;
+}
+
+bool GLSetErrorMode(GLErrorMode mode) {
+    bool debugOutput = GLEW_KHR_debug || GLEW_VERSION_4_3;
+
+    if ((mode == GLErrorMode::PerCall && !GL_ERROR_CHECKING) || (mode == GLErrorMode::DebugCallback && !debugOutput)) {
+        std::cout << "Warning: GL error mode " << GLGetErrorModeName(mode) << " unavailable, using frame sweep" << std::endl;
+        GLSetErrorMode(GLErrorMode::FrameSweep);
+        return false;
+    }
+
+    if (debugOutput) {
+        if (mode == GLErrorMode::DebugCallback) {
+            glDebugMessageCallback(GLDebugMessage, nullptr);
+            glEnable(GL_DEBUG_OUTPUT);                  // left asynchronous, no GL_DEBUG_OUTPUT_SYNCHRONOUS
+        }
+        else {
+            glDisable(GL_DEBUG_OUTPUT);
+            glDebugMessageCallback(nullptr, nullptr);
+        }
+    }
+
+    GLClearError();
+    g_GLErrorMode = mode;
+    return true;
+}
+
+bool GLParseErrorMode(const char* name, GLErrorMode& mode) {
+    if (std::strcmp(name, "off") == 0) mode = GLErrorMode::Off;
+    else if (std::strcmp(name, "call") == 0) mode = GLErrorMode::PerCall;
+    else if (std::strcmp(name, "callback") == 0) mode = GLErrorMode::DebugCallback;
+    else if (std::strcmp(name, "frame") == 0) mode = GLErrorMode::FrameSweep;
+    else return false;
+    return true;
+}
+
+const char* GLGetErrorModeName(GLErrorMode mode) {
+    switch (mode) {
+        case GLErrorMode::Off:              return "off";
+        case GLErrorMode::PerCall:          return "call";
+        case GLErrorMode::DebugCallback:    return "callback";
+        case GLErrorMode::FrameSweep:       return "frame";
+    }
+    return "unknown";
+}
+
+unsigned int GLFrameErrorSweep() {
+    if (g_GLErrorMode != GLErrorMode::FrameSweep) return 0;
+
+    unsigned int count = 0;
+    while (GLenum error = glGetError()) {
+        if (count++ == 0) std::cout << "[OpenGL Error] (0x" << std::hex << error << std::dec << ") during the last frame";
+        if (count > 64) break;                          // context lost keeps returning errors
+    }
+    if (count) std::cout << " (" << count << " errors)" << std::endl;
+    return count;
+}
+
 void Renderer::Clear() const {
+    PROFILE_SCOPE("Clear");
+    PROFILE_GPU_SCOPE("Clear");
     GLCall(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 }
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const {
+    PROFILE_SCOPE("Draw");
+    PROFILE_GPU_SCOPE("Draw");
     shader.Bind();
     va.Bind();
     ib.Bind();
     GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+}
+
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const DrawBatch& batch) const {
+    PROFILE_SCOPE("Draw");
+    PROFILE_GPU_SCOPE("Draw");
+    ASSERT(&va == &batch.GetVertexArray());                 // only that one has the batch's draw id attribute
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+    batch.Submit();
+}
+
+void Renderer::Draw(RenderQueue& queue) const {
+    PROFILE_SCOPE("Draw");
+    PROFILE_GPU_SCOPE("Draw");
+    queue.Execute();
+}
+
+void Renderer::DrawPoints(const VertexArray& va, const Shader& shader, unsigned int first, unsigned int count) const {
+    PROFILE_SCOPE("DrawPoints");
+    PROFILE_GPU_SCOPE("DrawPoints");
+    shader.Bind();
+    va.Bind();
+    GLCall(glDrawArrays(GL_POINTS, first, count));
+}
+
+void Renderer::DrawPointRanges(const VertexArray& va, const Shader& shader, const int* firsts, const int* counts, unsigned int rangeCount) const {
+    PROFILE_SCOPE("DrawPoints");
+    PROFILE_GPU_SCOPE("DrawPoints");
+    shader.Bind();
+    va.Bind();
+    GLCall(glMultiDrawArrays(GL_POINTS, firsts, counts, rangeCount));
+}
+
+void Renderer::DrawQuad(const VertexArray& va, const Shader& shader) const {
+    shader.Bind();
+    va.Bind();
+    GLCall(glDrawArrays(GL_TRIANGLE_STRIP, 0, 4));
 }
\ No newline at end of file
@@ -6,20 +6,63 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #define ASSERT(x) if (!(x)) __debugbreak();
-#define GLCall(x) GLClearError();\
+
+// GL error checking
+//   PerCall        glGetError around every GLCall, breaks on the offending line (forces a driver sync)
+//   DebugCallback  GL_KHR_debug messages delivered asynchronously by the driver
+//   FrameSweep     one glGetError drain per frame from GLFrameErrorSweep()
+// Per-call checking only exists when GL_ERROR_CHECKING is 1 (debug builds by default);
+// otherwise GLCall(x) is exactly x and the other two modes remain selectable at run time.
+#ifndef GL_ERROR_CHECKING
+    #ifdef NDEBUG
+        #define GL_ERROR_CHECKING 0
+    #else
+        #define GL_ERROR_CHECKING 1
+    #endif
+#endif
+
+enum class GLErrorMode {
+    Off,
+    PerCall,
+    DebugCallback,
+    FrameSweep
+};
+
+extern GLErrorMode g_GLErrorMode;
+
+#if GL_ERROR_CHECKING
+#define GLCall(x) GLCheckBegin();\
     x;\
-    ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+    ASSERT(GLCheckEnd(#x, __FILE__, __LINE__))
+#else
+#define GLCall(x) x
+#endif
 
 void GLClearError();
 bool GLLogCall(const char* function, const char* file, int line);
 
+inline void GLCheckBegin() { if (g_GLErrorMode == GLErrorMode::PerCall) GLClearError(); }
+inline bool GLCheckEnd(const char* function, const char* file, int line) { return g_GLErrorMode != GLErrorMode::PerCall || GLLogCall(function, file, line); }
+
+bool GLSetErrorMode(GLErrorMode mode);                  // false (and FrameSweep instead) when the mode isn't available
+bool GLParseErrorMode(const char* name, GLErrorMode& mode);
+const char* GLGetErrorModeName(GLErrorMode mode);
+unsigned int GLFrameErrorSweep();                       // once per frame, returns the errors found in FrameSweep mode
+
 class VertexArray;
 class IndexBuffer;
 class Shader;
+class DrawBatch;
+class RenderQueue;
 
 class Renderer {
 public:
     // To draw - vertex array, index buffer (index count), valid shader
     void Clear() const;
     void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+    void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const DrawBatch& batch) const;             // every batched draw in one multi-draw-indirect (instanced on GL 3.3), va as given to the batch
+    void Draw(RenderQueue& queue) const;                                                                                      // sorts the queued draws by state / depth and issues them
+    void DrawPoints(const VertexArray& va, const Shader& shader, unsigned int first, unsigned int count) const;
+    void DrawPointRanges(const VertexArray& va, const Shader& shader, const int* firsts, const int* counts, unsigned int rangeCount) const;   // one glMultiDrawArrays
+    void DrawQuad(const VertexArray& va, const Shader& shader) const;                                                          // 4 vertex strip, the shader places it from gl_VertexID; va may be empty
 };
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include "Sampler.h"
+
+#include <algorithm>
+
+#include "GLState.h"
+#include "Renderer.h"
+
+const char* GetTextureFilterName(TextureFilter filter) {
+	switch (filter) {
+		case TextureFilter::Nearest:	return "nearest";
+		case TextureFilter::Linear:		return "linear";
+		case TextureFilter::Bilinear:	return "bilinear";
+		case TextureFilter::Trilinear:	return "trilinear";
+	}
+	return "?";
+}
+
+struct SamplerParameters {
+	GLint minFilter, magFilter, wrap;
+	GLfloat anisotropy;						// 0 when the extension is missing
+};
+
+static SamplerParameters GetParameters(const SamplerSettings& settings) {
+	SamplerParameters parameters = { GL_LINEAR, GL_LINEAR, GL_CLAMP_TO_EDGE, 0.0f };
+	switch (settings.filter) {
+		case TextureFilter::Nearest:	parameters.minFilter = GL_NEAREST; parameters.magFilter = GL_NEAREST; break;
+		case TextureFilter::Linear:		parameters.minFilter = GL_LINEAR; break;
+		case TextureFilter::Bilinear:	parameters.minFilter = GL_LINEAR_MIPMAP_NEAREST; break;
+		case TextureFilter::Trilinear:	parameters.minFilter = GL_LINEAR_MIPMAP_LINEAR; break;
+	}
+	switch (settings.wrap) {
+		case TextureWrap::ClampToEdge:		parameters.wrap = GL_CLAMP_TO_EDGE; break;
+		case TextureWrap::Repeat:			parameters.wrap = GL_REPEAT; break;
+		case TextureWrap::MirroredRepeat:	parameters.wrap = GL_MIRRORED_REPEAT; break;
+	}
+	float maximum = Sampler::GetMaxAnisotropy();
+	if (maximum > 1.0f) parameters.anisotropy = std::min(std::max(settings.anisotropy, 1.0f), maximum);
+	return parameters;
+}
+
+Sampler::Sampler(const SamplerSettings& settings)
+	:m_RendererID(0), m_Settings(settings) {
+
+	GLCall(glGenSamplers(1, &m_RendererID));
+	SetSettings(settings);
+}
+
+Sampler::~Sampler() {
+	GLState::DeleteSampler(m_RendererID);
+}
+
+void Sampler::Bind(unsigned int slot) const {
+	GLState::BindSampler(slot, m_RendererID);
+}
+
+void Sampler::Unbind(unsigned int slot) {
+	GLState::BindSampler(slot, 0);
+}
+
+void Sampler::SetSettings(const SamplerSettings& settings) {
+	m_Settings = settings;
+
+	SamplerParameters parameters = GetParameters(settings);
+	GLCall(glSamplerParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, parameters.minFilter));
+	GLCall(glSamplerParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, parameters.magFilter));
+	GLCall(glSamplerParameteri(m_RendererID, GL_TEXTURE_WRAP_S, parameters.wrap));
+	GLCall(glSamplerParameteri(m_RendererID, GL_TEXTURE_WRAP_T, parameters.wrap));
+	if (parameters.anisotropy > 0.0f) {
+		GLCall(glSamplerParameterf(m_RendererID, GL_TEXTURE_MAX_ANISOTROPY_EXT, parameters.anisotropy));
+	}
+}
+
+float Sampler::GetMaxAnisotropy() {
+	if (!GLEW_EXT_texture_filter_anisotropic && !GLEW_ARB_texture_filter_anisotropic) return 1.0f;
+	GLfloat maximum = 1.0f;
+	GLCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maximum));		// same enum as the ARB / GL 4.6 name
+	return maximum;
+}
+
+void Sampler::SetTextureParameters(GLenum target, const SamplerSettings& settings) {
+	SamplerParameters parameters = GetParameters(settings);
+	GLCall(glTexParameteri(target, GL_TEXTURE_MIN_FILTER, parameters.minFilter));
+	GLCall(glTexParameteri(target, GL_TEXTURE_MAG_FILTER, parameters.magFilter));
+	GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_S, parameters.wrap));
+	GLCall(glTexParameteri(target, GL_TEXTURE_WRAP_T, parameters.wrap));
+	if (parameters.anisotropy > 0.0f) {
+		GLCall(glTexParameterf(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, parameters.anisotropy));
+	}
+}
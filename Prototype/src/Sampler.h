@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+enum class TextureFilter {
+	Nearest,
+	Linear,									// no mip levels used, aliases when minified
+	Bilinear,								// linear within the nearest mip level
+	Trilinear								// linear within and between mip levels
+};
+
+enum class TextureWrap {
+	ClampToEdge,
+	Repeat,
+	MirroredRepeat
+};
+
+const char* GetTextureFilterName(TextureFilter filter);
+
+struct SamplerSettings {
+	TextureFilter filter = TextureFilter::Linear;
+	TextureWrap wrap = TextureWrap::ClampToEdge;
+	float anisotropy = 1.0f;				// 1 is off, clamped to GetMaxAnisotropy()
+};
+
+// How a texture is read, as a GL sampler object. Bound to a unit it overrides the parameters of
+// whatever texture is on that unit, so one Sampler can serve every texture drawn the same way
+// and a texture can be drawn two ways without touching its own state. Texture::SetSampler()
+// sets the same settings on the texture itself, for units without a sampler bound.
+class Sampler {
+private:
+	unsigned int m_RendererID;
+	SamplerSettings m_Settings;
+public:
+	Sampler(const SamplerSettings& settings = SamplerSettings());
+	~Sampler();
+
+	Sampler(const Sampler&) = delete;
+	Sampler& operator=(const Sampler&) = delete;
+
+	void Bind(unsigned int slot = 0) const;
+	static void Unbind(unsigned int slot = 0);
+
+	void SetSettings(const SamplerSettings& settings);
+	inline const SamplerSettings& GetSettings() const { return m_Settings; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+
+	static float GetMaxAnisotropy();		// 1 without EXT / ARB_texture_filter_anisotropic
+	static void SetTextureParameters(GLenum target, const SamplerSettings& settings);	// on the bound texture
+};
@@ -8,8 +8,14 @@
 #include <string>               // for string operations
 #include <fstream>              // file stream that deal with reading files
 #include <sstream>              // string stream to contain long strings that hold shaders
+#include <chrono>               // construction time for the shader cache stats
+#include <algorithm>            // std::find over the #include stack
+#include <filesystem>           // #include paths relative to the including file
 
 #include "Renderer.h"
+#include "GLState.h"
+#include "ShaderCache.h"
+#include "UniformBuffer.h"
 
 // 1. Supply Shader File
 // 2. Compile Shader
@@ -17,19 +23,41 @@
 
 
 
-ShaderProgramSource Shader::ParseShader(const std::string& filepath) {
-    std::ifstream stream(filepath);
+enum class ShaderType {
+    NONE = -1,
+    VERTEX = 0,
+    FRAGMENT = 1
+};
 
-    enum class ShaderType {
-        NONE = -1,
-        VERTEX = 0,
-        FRAGMENT = 1
-    };
+// `#include "file"` with the path relative to the including file; the text of the file itself
+static bool ParseInclude(const std::string& line, std::string& path) {
+    size_t hash = line.find_first_not_of(" \t");
+    if (hash == std::string::npos || line.compare(hash, 8, "#include") != 0) return false;
+    size_t open = line.find('"', hash + 8);
+    size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+    if (close == std::string::npos) return false;
+    path = line.substr(open + 1, close - open - 1);
+    return true;
+}
 
-    std::string line;
-    std::stringstream ss[2];
-    ShaderType type = ShaderType::NONE;
+static void AppendShaderFile(const std::filesystem::path& filepath, std::stringstream (&ss)[2], ShaderType& type,
+    std::vector<std::string>& files, std::vector<std::string>& stack) {
+
+    std::string name = filepath.lexically_normal().generic_string();
+    if (std::find(stack.begin(), stack.end(), name) != stack.end()) {
+        std::cout << "Failed to include: " << name << " includes itself" << std::endl;
+        return;
+    }
+    if (std::find(files.begin(), files.end(), name) == files.end()) files.push_back(name);
+
+    std::ifstream stream(filepath);
+    if (!stream) {
+        std::cout << "Failed to open: " << name << (stack.empty() ? "" : " (included from " + stack.back() + ")") << std::endl;
+        return;
+    }
+    stack.push_back(name);
 
+    std::string line, include;
     while (getline(stream, line)) {
         if (line.find("#shader") != std::string::npos) {
             if (line.find("vertex") != std::string::npos)
@@ -37,11 +65,23 @@ ShaderProgramSource Shader::ParseShader(const std::string& filepath) {
             else if (line.find("fragment") != std::string::npos) // Fixed the typo here
                 type = ShaderType::FRAGMENT;
         }
-        else {
+        else if (ParseInclude(line, include)) {
+            AppendShaderFile(filepath.parent_path() / include, ss, type, files, stack);
+        }
+        else if (type != ShaderType::NONE) {
             ss[static_cast<int>(type)] << line << '\n';
         }
     }
+    stack.pop_back();
+}
+
+ShaderProgramSource Shader::ParseShader(const std::string& filepath, std::vector<std::string>* dependencies) {
+    std::stringstream ss[2];
+    ShaderType type = ShaderType::NONE;
+    std::vector<std::string> files, stack;
+    AppendShaderFile(filepath, ss, type, files, stack);
 
+    if (dependencies) dependencies->swap(files);
     return { ss[0].str(), ss[1].str() };
 }
 
@@ -51,8 +91,11 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
     unsigned int id = glCreateShader(type);
     const char* src = source.c_str();
     glShaderSource(id, 1, &src, nullptr);
-    glCompileShader(id);
+    glCompileShader(id);                                                                                        // status is checked in Finish(), asking now would wait for the compiler
+    return id;
+}
 
+bool Shader::CheckShader(unsigned int id, unsigned int type) const {
     int result;
     glGetShaderiv(id, GL_COMPILE_STATUS, &result);
     if (result == GL_FALSE) {
@@ -60,72 +103,234 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
         glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
         char* message = new char[length]; // Allocate memory dynamically
         glGetShaderInfoLog(id, length, &length, message);
-        std::cout << "Failed to compile: " << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << " SHADER" << std::endl;
+        std::cout << "Failed to compile: " << (type == GL_VERTEX_SHADER ? "VERTEX" : "FRAGMENT") << " SHADER (" << m_FilePath << ")" << std::endl;
         std::cout << message << std::endl;
         delete[] message; // Deallocate memory
-        glDeleteShader(id);
-        return 0;
+        return false;
     }
-
-    return id;
+    return true;
 }
 
 unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader) {
     unsigned int program = glCreateProgram();
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    m_VertexShader = CompileShader(GL_VERTEX_SHADER, vertexShader);
+    m_FragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
 
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
+    glAttachShader(program, m_VertexShader);
+    glAttachShader(program, m_FragmentShader);
+    if (ShaderCache::IsEnabled())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);             // before linking, or there may be no binary to fetch
     glLinkProgram(program);
-    glValidateProgram(program);
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
 
     return program;
 }
 
-Shader::Shader(const std::string& filepath)
-    :m_FilePath(filepath), m_RendererID(0) {
+Shader::Shader(const std::string& filepath, ShaderCompile compile)
+    :m_FilePath(filepath), m_RendererID(0), m_VertexShader(0), m_FragmentShader(0), m_CacheKey(0), m_Uniforms(16, { 0, -1 }), m_UniformCount(0), m_Linked(false) {
+
+    Create(ParseShader(filepath, &m_Dependencies), compile);                                                   // Loading Shaders
+}
+
+Shader::Shader(const std::string& filepath, const ShaderProgramSource& source, const std::vector<std::string>& dependencies, ShaderCompile compile)
+    :m_FilePath(filepath), m_RendererID(0), m_VertexShader(0), m_FragmentShader(0), m_CacheKey(0), m_Uniforms(16, { 0, -1 }), m_UniformCount(0), m_Linked(false),
+    m_Dependencies(dependencies) {
+
+    Create(source, compile);
+}
+
+void Shader::Create(const ShaderProgramSource& source, ShaderCompile compile) {
+    auto start = std::chrono::steady_clock::now();
+
+    if (ShaderCache::IsEnabled()) {
+        m_CacheKey = ShaderCache::MakeKey(source.VertexSource, source.FragmentSource);
+        m_RendererID = ShaderCache::Load(m_CacheKey);                                                           // linked binary from an earlier run
+        if (m_RendererID) {
+            m_Linked = true;
+            BindUniformBlocks();
+            BuildUniformTable();
+        }
+    }
+    bool compiled = !m_RendererID;
+    if (compiled)
+        m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);                             // Creating Shaders, submitted only
+    ShaderCache::AddShader(compiled, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    if (compile == ShaderCompile::Blocking) Finish();
+}
+
+bool Shader::IsReady() const {
+    if (!m_VertexShader) return true;
+    if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile) return false;                  // no way to ask without waiting
 
-    ShaderProgramSource source = ParseShader(filepath);                                                         // Loading Shaders
-    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);                                 // Creating Shaders
+    int done = GL_FALSE;
+    glGetProgramiv(m_RendererID, GL_COMPLETION_STATUS_KHR, &done);
+    return done == GL_TRUE;
+}
+
+void Shader::InsertUniform(uint32_t hash, int location) const {
+    if ((m_UniformCount + 1) * 2 > m_Uniforms.size()) {                                                         // keep the load under 1/2, probes stay short
+        std::vector<UniformSlot> old(m_Uniforms.size() * 2, { 0, -1 });
+        old.swap(m_Uniforms);
+        m_UniformCount = 0;
+        for (const UniformSlot& slot : old)
+            if (slot.hash) InsertUniform(slot.hash, slot.location);
+    }
+
+    size_t mask = m_Uniforms.size() - 1;
+    size_t i = hash & mask;
+    for (; m_Uniforms[i].hash; i = (i + 1) & mask)
+        if (m_Uniforms[i].hash == hash) break;
+    if (m_Uniforms[i].hash == hash && m_Uniforms[i].location != location)
+        std::cout << "Warning: two uniforms of " << m_FilePath << " share a name hash, rename one" << std::endl;
+    if (!m_Uniforms[i].hash) m_UniformCount++;
+    m_Uniforms[i] = { hash, location };
+}
+
+// every active uniform outside a block; arrays answer to "name" and "name[0]"
+void Shader::BuildUniformTable() const {
+    m_Uniforms.assign(16, { 0, -1 });
+    m_UniformCount = 0;
+
+    int count = 0, maxLength = 0;
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORMS, &count));
+    GLCall(glGetProgramiv(m_RendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength));
+    std::string name(maxLength + 1, '\0');
+    for (int i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        GLCall(glGetActiveUniform(m_RendererID, i, maxLength + 1, &length, &size, &type, &name[0]));
+        GLCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
+        if (location < 0) continue;                                                                             // block member
+
+        std::string_view view(name.data(), length);
+        InsertUniform(UniformName::Hash(view), location);
+        if (view.size() > 3 && view.substr(view.size() - 3) == "[0]")
+            InsertUniform(UniformName::Hash(view.substr(0, view.size() - 3)), location);
+    }
+}
 
+// GLSL 330 has no layout(binding = N), so blocks are tied to their UniformBinding by name
+void Shader::BindUniformBlocks() const {
+    for (unsigned int binding = 0; binding < UniformBindingCount; binding++) {
+        GLCall(unsigned int index = glGetUniformBlockIndex(m_RendererID, GetUniformBlockName((UniformBinding)binding)));
+        if (index != GL_INVALID_INDEX) {
+            GLCall(glUniformBlockBinding(m_RendererID, index, binding));
+        }
+    }
+}
+
+void Shader::Finish() const {
+    if (!m_VertexShader) return;
+
+    auto start = std::chrono::steady_clock::now();
+    bool compiled = CheckShader(m_VertexShader, GL_VERTEX_SHADER) & CheckShader(m_FragmentShader, GL_FRAGMENT_SHADER);
+
+    int linked;
+    glGetProgramiv(m_RendererID, GL_LINK_STATUS, &linked);
+    if (compiled && linked == GL_FALSE) {
+        int length;
+        glGetProgramiv(m_RendererID, GL_INFO_LOG_LENGTH, &length);
+        std::string message(length, '\0');
+        glGetProgramInfoLog(m_RendererID, length, &length, &message[0]);
+        std::cout << "Failed to link: " << m_FilePath << std::endl << message << std::endl;
+    }
+    else if (linked == GL_TRUE) {
+        m_Linked = true;
+        BindUniformBlocks();
+        BuildUniformTable();
+        if (ShaderCache::IsEnabled()) ShaderCache::Store(m_CacheKey, m_RendererID);
+    }
+
+    glDetachShader(m_RendererID, m_VertexShader);
+    glDetachShader(m_RendererID, m_FragmentShader);
+    glDeleteShader(m_VertexShader);
+    glDeleteShader(m_FragmentShader);
+    m_VertexShader = m_FragmentShader = 0;
+    ShaderCache::AddSeconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+bool Shader::IsLinked() const {
+    Finish();
+    return m_Linked;
+}
+
+void Shader::Swap(Shader& other) {
+    std::swap(m_FilePath, other.m_FilePath);
+    std::swap(m_RendererID, other.m_RendererID);
+    std::swap(m_VertexShader, other.m_VertexShader);
+    std::swap(m_FragmentShader, other.m_FragmentShader);
+    std::swap(m_CacheKey, other.m_CacheKey);
+    std::swap(m_Uniforms, other.m_Uniforms);
+    std::swap(m_UniformCount, other.m_UniformCount);
+    std::swap(m_Linked, other.m_Linked);
+    std::swap(m_Dependencies, other.m_Dependencies);
 }
 
 Shader::~Shader() {
-    GLCall(glDeleteProgram(m_RendererID));
+    if (m_VertexShader) {                                                                                       // never used, nothing to report
+        glDeleteShader(m_VertexShader);
+        glDeleteShader(m_FragmentShader);
+    }
+    GLState::DeleteProgram(m_RendererID);
 }
 
-unsigned int Shader::GetUniformLocation(const std::string& name) {
+int Shader::GetUniformLocation(const UniformName& name) const {
+    Finish();
+
+    size_t mask = m_Uniforms.size() - 1;
+    for (size_t i = name.hash & mask; m_Uniforms[i].hash; i = (i + 1) & mask)
+        if (m_Uniforms[i].hash == name.hash) return m_Uniforms[i].location;
 
-    if (m_UniformLocationCache.find(name) != m_UniformLocationCache.end()) return m_UniformLocationCache[name];
-    GLCall(unsigned int location = glGetUniformLocation(m_RendererID, name.c_str()));
-    if (location == -1) std::cout << "Warning: uniform " << name << " doesn't exists!" << std::endl;
-    
-    m_UniformLocationCache[name] = location;
-    return location;
+    std::cout << "Warning: uniform " << name.name << " doesn't exists!" << std::endl;
+    InsertUniform(name.hash, -1);                                                                               // warn once
+    return -1;
 }
 
 void Shader::Bind() const {
-    GLCall(glUseProgram(m_RendererID));
+    Finish();
+    GLState::UseProgram(m_RendererID);
 }
 
 void Shader::Unbind() const {
-    GLCall(glUseProgram(0));
+    GLState::UseProgram(0);
 }
 
-void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3) {
+void Shader::SetUniform(const UniformName& name, bool value) { GLCall(glUniform1i(GetUniformLocation(name), value)); }
+void Shader::SetUniform(const UniformName& name, int value) { GLCall(glUniform1i(GetUniformLocation(name), value)); }
+void Shader::SetUniform(const UniformName& name, unsigned int value) { GLCall(glUniform1ui(GetUniformLocation(name), value)); }
+void Shader::SetUniform(const UniformName& name, float value) { GLCall(glUniform1f(GetUniformLocation(name), value)); }
+void Shader::SetUniform(const UniformName& name, const glm::vec2& value) { GLCall(glUniform2fv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::vec3& value) { GLCall(glUniform3fv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::vec4& value) { GLCall(glUniform4fv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::ivec2& value) { GLCall(glUniform2iv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::ivec3& value) { GLCall(glUniform3iv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::ivec4& value) { GLCall(glUniform4iv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::uvec2& value) { GLCall(glUniform2uiv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::uvec3& value) { GLCall(glUniform3uiv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::uvec4& value) { GLCall(glUniform4uiv(GetUniformLocation(name), 1, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::mat2& value) { GLCall(glUniformMatrix2fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::mat3& value) { GLCall(glUniformMatrix3fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const glm::mat4& value) { GLCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, glm::value_ptr(value))); }
+void Shader::SetUniform(const UniformName& name, const float* values, unsigned int count) { GLCall(glUniform1fv(GetUniformLocation(name), count, values)); }
+
+void Shader::SetUniform(const UniformName& name, const glm::mat4* values, unsigned int count) {
+    if (count == 0) return;                 // values may be null then
+    GLCall(glUniformMatrix4fv(GetUniformLocation(name), count, GL_FALSE, glm::value_ptr(values[0])));
+}
+
+void Shader::SetUniform4f(const UniformName& name, float v0, float v1, float v2, float v3) {
     GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
 }
 
-void Shader::SetUniformMVP(glm::mat4 model, glm::mat4 view, glm::mat4 projection)
+void Shader::SetUniformMat4f(const UniformName& name, const glm::mat4& matrix) {
+    SetUniform(name, matrix);
+}
+
+void Shader::SetUniformMVP(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection)
 {
-    unsigned int model_loc = GetUniformLocation("model");
-    unsigned int view_loc = GetUniformLocation("view");
-    unsigned int projection_loc = GetUniformLocation("projection");
-    glUniformMatrix4fv(model_loc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(view_loc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projection_loc, 1, GL_FALSE, glm::value_ptr(projection));
+    static constexpr UniformName s_Model("model"), s_View("view"), s_Projection("projection");
+    SetUniform(s_Model, model);
+    SetUniform(s_View, view);
+    SetUniform(s_Projection, projection);
 }
@@ -1,11 +1,37 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
+#include "Hash.h"
 #include "Renderer.h"
 
 
+enum class ShaderCompile {
+	Blocking,								// compiled, linked and checked when the constructor returns
+	Deferred								// submitted only; checked on first Bind / uniform lookup or Finish()
+};
+
+// A uniform name and its FNV-1a hash. Literals hash at compile time where the compiler folds
+// the constructor, always for `constexpr UniformName name("...")`; std::string names hash at
+// run time. Passing either to the setters allocates nothing.
+struct UniformName {
+	uint32_t hash;							// never 0, that marks an empty table slot
+	const char* name;						// for warnings only
+
+	template<size_t N>
+	constexpr UniformName(const char (&literal)[N])
+		:hash(Hash(std::string_view(literal, N - 1))), name(literal) {}
+	UniformName(const std::string& text)
+		:hash(Hash(text)), name(text.c_str()) {}
+
+	static constexpr uint32_t Hash(std::string_view text) {
+		uint32_t value = hash::Fnv1a32(text);
+		return value ? value : 1;
+	}
+};
+
 struct ShaderProgramSource {
 	std::string VertexSource;
 	std::string FragmentSource;
@@ -15,21 +41,77 @@ class Shader {
 private:
 	std::string m_FilePath;
 	unsigned int m_RendererID;
-	std::unordered_map<std::string, unsigned int> m_UniformLocationCache;
+	mutable unsigned int m_VertexShader;	// stages of a program still compiling, 0 once finished
+	mutable unsigned int m_FragmentShader;
+	uint64_t m_CacheKey;
+
+	// open addressed name hash -> location, filled from GL_ACTIVE_UNIFORMS at link time
+	struct UniformSlot {
+		uint32_t hash;
+		int location;						// -1 for names looked up but not in the program
+	};
+	mutable std::vector<UniformSlot> m_Uniforms;
+	mutable unsigned int m_UniformCount;
+	mutable bool m_Linked;
+	std::vector<std::string> m_Dependencies;	// the file and everything it #includes
 
 public:
-	Shader(const std::string& filepath);
+	Shader(const std::string& filepath, ShaderCompile compile = ShaderCompile::Blocking);
+	Shader(const std::string& filepath, const ShaderProgramSource& source, const std::vector<std::string>& dependencies,
+		ShaderCompile compile = ShaderCompile::Blocking);		// sources parsed beforehand, e.g. off the render thread
 	~Shader();
 
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+
+	bool IsReady() const;					// Finish() won't block; without KHR_parallel_shader_compile only once finished
+	void Finish() const;					// waits for the driver, reports compile / link errors
+	bool IsLinked() const;					// finishes first
+	void Swap(Shader& other);				// trades programs, so whoever holds this Shader draws with other's
+
 	void Bind() const;
 	void Unbind() const;
 
-	void SetUniform4f(const std::string& location, float v0, float v1, float v2, float v3);
-	void SetUniformMVP(glm::mat4 model, glm::mat4 view, glm::mat4 projection);
+	int GetUniformLocation(const UniformName& name) const;		// -1 when the program has no such uniform
+
+	// the program must be bound
+	void SetUniform(const UniformName& name, bool value);
+	void SetUniform(const UniformName& name, int value);			// also samplers
+	void SetUniform(const UniformName& name, unsigned int value);
+	void SetUniform(const UniformName& name, float value);
+	void SetUniform(const UniformName& name, const glm::vec2& value);
+	void SetUniform(const UniformName& name, const glm::vec3& value);
+	void SetUniform(const UniformName& name, const glm::vec4& value);
+	void SetUniform(const UniformName& name, const glm::ivec2& value);
+	void SetUniform(const UniformName& name, const glm::ivec3& value);
+	void SetUniform(const UniformName& name, const glm::ivec4& value);
+	void SetUniform(const UniformName& name, const glm::uvec2& value);
+	void SetUniform(const UniformName& name, const glm::uvec3& value);
+	void SetUniform(const UniformName& name, const glm::uvec4& value);
+	void SetUniform(const UniformName& name, const glm::mat2& value);
+	void SetUniform(const UniformName& name, const glm::mat3& value);
+	void SetUniform(const UniformName& name, const glm::mat4& value);
+	void SetUniform(const UniformName& name, const float* values, unsigned int count);		// float[count]
+	void SetUniform(const UniformName& name, const glm::mat4* values, unsigned int count);	// mat4[count]
+
+	void SetUniform4f(const UniformName& name, float v0, float v1, float v2, float v3);
+	void SetUniformMat4f(const UniformName& name, const glm::mat4& matrix);
+	void SetUniformMVP(const glm::mat4& model, const glm::mat4& view, const glm::mat4& projection);
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline const std::vector<std::string>& GetDependencies() const { return m_Dependencies; }
+
+	// splits a .shader file into its stages; `#include "file"` pulls in a file relative to the
+	// including one. Touches no GL, so it can run on any thread.
+	static ShaderProgramSource ParseShader(const std::string& filepath, std::vector<std::string>* dependencies = nullptr);
 
 private:
-	ShaderProgramSource ParseShader(const std::string& filepath);
+	void Create(const ShaderProgramSource& source, ShaderCompile compile);
 	unsigned int CompileShader(unsigned int type, const std::string& source);
+	bool CheckShader(unsigned int id, unsigned int type) const;
+	void BindUniformBlocks() const;
+	void BuildUniformTable() const;
+	void InsertUniform(uint32_t hash, int location) const;
 	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
-	unsigned int GetUniformLocation(const std::string& name);
 };
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "Hash.h"
+#include "Renderer.h"
+
+static const char s_Magic[4] = { 'K', 'V', 'P', 'B' };
+static const uint32_t s_Version = 1;
+
+struct ProgramBinaryHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;							// repeated so a renamed / truncated file can't pass as another entry
+	uint32_t format;
+	uint32_t length;
+};
+
+static struct {
+	std::string directory;
+	int supported = -1;						// -1 not queried yet (needs a context)
+	std::vector<GLint> formats;
+	ShaderCacheStats stats = {};
+} s_Cache;
+
+// a field and its terminator, so "ab" + "c" and "a" + "bc" differ
+static uint64_t HashField(uint64_t value, const char* text) {
+	return hash::Fnv1a64(text ? text : "", (text ? std::char_traits<char>::length(text) : 0) + 1, value);
+}
+
+static std::string EntryPath(uint64_t key) {
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return (std::filesystem::path(s_Cache.directory) / name).string();
+}
+
+void ShaderCache::SetDirectory(const std::string& directory) {
+	s_Cache.directory = directory;
+	if (directory.empty()) return;
+
+	std::error_code error;
+	std::filesystem::create_directories(directory, error);
+	if (error) {
+		std::cout << "Warning: shader cache disabled, cannot create " << directory << ": " << error.message() << std::endl;
+		s_Cache.directory.clear();
+	}
+}
+
+bool ShaderCache::IsEnabled() {
+	if (s_Cache.directory.empty()) return false;
+
+	if (s_Cache.supported < 0) {
+		GLint count = 0;
+		if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) {
+			GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+		}
+		s_Cache.formats.resize(count);
+		if (count > 0) {
+			GLCall(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, s_Cache.formats.data()));
+		}
+		s_Cache.supported = count > 0;
+		if (!s_Cache.supported) std::cout << "Warning: shader cache disabled, the driver exposes no program binary formats" << std::endl;
+	}
+	return s_Cache.supported == 1;
+}
+
+uint64_t ShaderCache::MakeKey(const std::string& vertexSource, const std::string& fragmentSource) {
+	uint64_t key = hash::Fnv1a64(&s_Version, sizeof(s_Version));
+	key = HashField(key, vertexSource.c_str());
+	key = HashField(key, fragmentSource.c_str());
+	key = HashField(key, (const char*)glGetString(GL_VENDOR));
+	key = HashField(key, (const char*)glGetString(GL_RENDERER));
+	key = HashField(key, (const char*)glGetString(GL_VERSION));
+	return key;
+}
+
+unsigned int ShaderCache::Load(uint64_t key) {
+	if (!IsEnabled()) return 0;
+
+	std::string path = EntryPath(key);
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream) return 0;
+
+	ProgramBinaryHeader header;
+	std::vector<char> binary;
+	bool valid = (bool)stream.read((char*)&header, sizeof(header))
+		&& std::equal(s_Magic, s_Magic + 4, header.magic) && header.version == s_Version && header.key == key
+		&& std::find(s_Cache.formats.begin(), s_Cache.formats.end(), (GLint)header.format) != s_Cache.formats.end();
+	if (valid) {
+		// bound the length by what the file holds before allocating, a corrupt header could ask for 4 GiB
+		std::streamoff start = stream.tellg();
+		stream.seekg(0, std::ios::end);
+		std::streamoff left = stream.tellg() - start;
+		stream.seekg(start);
+		valid = header.length > 0 && (std::streamoff)header.length <= left;
+	}
+	if (valid) {
+		binary.resize(header.length);
+		valid = (bool)stream.read(binary.data(), header.length);
+	}
+	stream.close();
+
+	unsigned int program = 0;
+	if (valid) {
+		program = glCreateProgram();
+		GLCall(glProgramBinary(program, header.format, binary.data(), (GLsizei)header.length));
+		GLint linked = GL_FALSE;
+		GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+		if (!linked) {
+			GLCall(glDeleteProgram(program));
+			program = 0;
+		}
+	}
+
+	if (!program) {
+		std::remove(path.c_str());			// stale or corrupt, Store() writes a fresh one after the compile
+		s_Cache.stats.rejected++;
+		return 0;
+	}
+	s_Cache.stats.hits++;
+	return program;
+}
+
+void ShaderCache::Store(uint64_t key, unsigned int program) {
+	if (!IsEnabled() || !program) return;
+
+	GLint linked = GL_FALSE, length = 0;
+	GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+	GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+	if (!linked || length <= 0) return;
+
+	ProgramBinaryHeader header = { { s_Magic[0], s_Magic[1], s_Magic[2], s_Magic[3] }, s_Version, key, 0, 0 };
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	GLsizei written = 0;
+	GLCall(glGetProgramBinary(program, length, &written, &format, binary.data()));
+	header.format = format;
+	header.length = (uint32_t)written;
+
+	// write aside and rename, another instance starting at the same time never reads half a file
+	std::string path = EntryPath(key);
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		stream.write((const char*)&header, sizeof(header));
+		stream.write(binary.data(), written);
+		if (!stream) return;
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error) {
+		std::remove(temporary.c_str());
+		return;
+	}
+	s_Cache.stats.stored++;
+}
+
+void ShaderCache::AddShader(bool compiled, double seconds) {
+	if (compiled) s_Cache.stats.compiled++;
+	s_Cache.stats.seconds += seconds;
+}
+
+void ShaderCache::AddSeconds(double seconds) {
+	s_Cache.stats.seconds += seconds;
+}
+
+const ShaderCacheStats& ShaderCache::GetStats() {
+	return s_Cache.stats;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct ShaderCacheStats {
+	unsigned int hits;
+	unsigned int compiled;
+	unsigned int rejected;					// found but refused by the driver (or corrupt), recompiled
+	unsigned int stored;
+	double seconds;							// spent in Shader construction, cache lookups + compiles
+};
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary, GL 4.1 or
+// ARB_get_program_binary). Entries are keyed by a hash of the preprocessed stage sources and
+// the GL vendor, renderer and version strings, so a driver update or a different GPU misses
+// instead of loading a binary it would reject. A binary the driver still refuses is deleted
+// and the program compiled again. Used by Shader; off until SetDirectory() is called.
+class ShaderCache {
+public:
+	static void SetDirectory(const std::string& directory);	// "" turns the cache off
+	static bool IsEnabled();								// a directory is set and the driver has binary formats
+
+	static uint64_t MakeKey(const std::string& vertexSource, const std::string& fragmentSource);
+
+	static unsigned int Load(uint64_t key);					// linked program, 0 on a miss
+	static void Store(uint64_t key, unsigned int program);	// link with GL_PROGRAM_BINARY_RETRIEVABLE_HINT first
+
+	static void AddShader(bool compiled, double seconds);	// Shader reports each construction
+	static void AddSeconds(double seconds);					// and the wait in Finish()
+	static const ShaderCacheStats& GetStats();
+};
@@ -0,0 +1,140 @@
+#include "ShaderLibrary.h"
+
+#include <algorithm>
+#include <iostream>
+
+ShaderLibrary::ShaderLibrary() {
+	if (GLEW_KHR_parallel_shader_compile) {
+		GLCall(glMaxShaderCompilerThreadsKHR(0xffffffff));			// "implementation-specific maximum"
+	}
+	else if (GLEW_ARB_parallel_shader_compile) {
+		GLCall(glMaxShaderCompilerThreadsARB(0xffffffff));
+	}
+}
+
+ShaderLibrary::~ShaderLibrary() {
+	m_Watcher.reset();												// joins the watcher thread before the rest goes
+}
+
+bool ShaderLibrary::IsParallelSupported() {
+	return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+Shader& ShaderLibrary::Load(const std::string& name, const std::string& filepath) {
+	std::unique_ptr<Shader>& shader = m_Shaders[name];
+	shader.reset(new Shader(filepath, ShaderCompile::Deferred));
+	m_Compiling.erase(name);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto source = std::find_if(m_Sources.begin(), m_Sources.end(), [&](const Source& s) { return s.name == name; });
+		if (source == m_Sources.end()) source = m_Sources.insert(m_Sources.end(), Source{ name, {}, {} });
+		source->filepath = filepath;
+		source->dependencies = shader->GetDependencies();
+	}
+	if (m_Watcher) Rewatch();
+	return *shader;
+}
+
+Shader& ShaderLibrary::Get(const std::string& name) {
+	ASSERT(Exists(name));
+	return *m_Shaders[name];
+}
+
+unsigned int ShaderLibrary::GetPendingCount() const {
+	unsigned int pending = 0;
+	for (const auto& shader : m_Shaders)
+		if (!shader.second->IsReady()) pending++;
+	return pending;
+}
+
+void ShaderLibrary::FinishAll() {
+	for (auto& shader : m_Shaders) shader.second->Finish();
+}
+
+bool ShaderLibrary::Watch() {
+	Rewatch();
+	return IsWatching();
+}
+
+// every file any shader reads, the watcher is rebuilt when that set changes
+void ShaderLibrary::Rewatch() {
+	std::vector<std::string> files;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (const Source& source : m_Sources)
+			for (const std::string& file : source.dependencies)
+				if (std::find(files.begin(), files.end(), file) == files.end()) files.push_back(file);
+	}
+	if (m_Watcher && m_Watcher->GetFiles() == files) return;
+
+	m_Watcher.reset();
+	m_Watcher.reset(new FileWatcher(files, [this](const std::vector<std::string>& changed) { OnFilesChanged(changed); }));
+}
+
+// parsing (file reads, #includes) stays off the render thread; compiling needs its context
+void ShaderLibrary::OnFilesChanged(const std::vector<std::string>& changed) {
+	std::vector<Source> sources;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		for (const Source& source : m_Sources)
+			for (const std::string& file : changed)
+				if (std::find(source.dependencies.begin(), source.dependencies.end(), file) != source.dependencies.end()) {
+					sources.push_back(source);
+					break;
+				}
+	}
+
+	for (const Source& source : sources) {
+		Parsed parsed = { source.name, {}, {} };
+		parsed.source = Shader::ParseShader(source.filepath, &parsed.dependencies);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		auto pending = std::find_if(m_Parsed.begin(), m_Parsed.end(), [&](const Parsed& p) { return p.name == source.name; });
+		if (pending != m_Parsed.end()) *pending = std::move(parsed);		// an older save never submitted
+		else m_Parsed.push_back(std::move(parsed));
+	}
+}
+
+unsigned int ShaderLibrary::Update() {
+	std::vector<Parsed> parsed;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		parsed.swap(m_Parsed);
+	}
+	for (Parsed& p : parsed) {
+		auto shader = m_Shaders.find(p.name);
+		if (shader == m_Shaders.end()) continue;
+		m_Compiling[p.name].reset(new Shader(shader->second->GetFilePath(), p.source, p.dependencies, ShaderCompile::Deferred));		// replaces a reload still compiling
+	}
+
+	// without KHR_parallel_shader_compile there is no asking, the frame after submitting waits for the link
+	unsigned int swapped = 0;
+	bool rewatch = false;
+	for (auto candidate = m_Compiling.begin(); candidate != m_Compiling.end();) {
+		if (!candidate->second->IsReady() && IsParallelSupported()) {
+			++candidate;
+			continue;
+		}
+
+		Shader& shader = *m_Shaders[candidate->first];
+		if (candidate->second->IsLinked()) {
+			shader.Swap(*candidate->second);							// the old program goes with the candidate
+			swapped++;
+			std::cout << "Reloaded " << shader.GetFilePath() << std::endl;
+
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (Source& source : m_Sources)
+				if (source.name == candidate->first && source.dependencies != shader.GetDependencies()) {
+					source.dependencies = shader.GetDependencies();
+					rewatch = true;
+				}
+		}
+		else {
+			std::cout << "Keeping the previous " << shader.GetFilePath() << std::endl;
+		}
+		candidate = m_Compiling.erase(candidate);
+	}
+
+	if (rewatch) Rewatch();
+	return swapped;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FileWatcher.h"
+#include "Shader.h"
+
+// Named shaders loaded up front with ShaderCompile::Deferred: Load() only submits the sources,
+// so every program compiles at once on drivers with KHR_parallel_shader_compile (the library
+// asks for as many compiler threads as the driver will use) and the CPU carries on with other
+// startup work. A program's status is first queried when it is bound or its uniforms are
+// looked up, which is the only place a slow compile still blocks.
+//
+// Watch() reloads shaders while the app runs: a FileWatcher thread notices a saved .shader or
+// #included file and parses the sources right there, Update() on the render thread submits
+// them and, once the driver reports the new program done, swaps it into the existing Shader
+// if it linked. A broken edit leaves the old program drawing.
+class ShaderLibrary {
+private:
+	struct Source {							// what the watcher thread needs to reparse a shader
+		std::string name;
+		std::string filepath;
+		std::vector<std::string> dependencies;
+	};
+	struct Parsed {
+		std::string name;
+		ShaderProgramSource source;
+		std::vector<std::string> dependencies;
+	};
+
+	std::unordered_map<std::string, std::unique_ptr<Shader>> m_Shaders;
+	std::unordered_map<std::string, std::unique_ptr<Shader>> m_Compiling;	// reloads waiting on the driver
+	std::unique_ptr<FileWatcher> m_Watcher;
+	std::mutex m_Mutex;						// guards the two below, shared with the watcher thread
+	std::vector<Source> m_Sources;
+	std::vector<Parsed> m_Parsed;
+public:
+	ShaderLibrary();
+	~ShaderLibrary();
+
+	ShaderLibrary(const ShaderLibrary&) = delete;
+	ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+	Shader& Load(const std::string& name, const std::string& filepath);	// replaces an existing `name`
+	Shader& Get(const std::string& name);
+	inline bool Exists(const std::string& name) const { return m_Shaders.find(name) != m_Shaders.end(); }
+
+	unsigned int GetPendingCount() const;		// programs the driver is still compiling, never blocks
+	void FinishAll();
+
+	bool Watch();								// false if the files can't be watched
+	inline bool IsWatching() const { return m_Watcher && m_Watcher->IsWatching(); }
+	unsigned int Update();						// render thread, once a frame: how many programs were swapped
+
+	static bool IsParallelSupported();
+
+private:
+	void Rewatch();
+	void OnFilesChanged(const std::vector<std::string>& changed);		// watcher thread
+};
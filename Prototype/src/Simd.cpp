@@ -0,0 +1,77 @@
+#include "Simd.h"
+
+#if SIMD_X86 && defined(_MSC_VER)
+	#include <intrin.h>
+#elif SIMD_X86
+	#include <cpuid.h>
+#endif
+
+namespace Simd {
+
+#if SIMD_X86
+	static void CpuId(int leaf, int sub, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+		int r[4];
+		__cpuidex(r, leaf, sub);
+		for (int i = 0; i < 4; i++) regs[i] = (unsigned int)r[i];
+#else
+		__cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	static unsigned long long XGetBV() {
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int lo, hi;
+		__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+		return ((unsigned long long)hi << 32) | lo;
+#endif
+	}
+
+	static Level DetectUncached() {
+		unsigned int regs[4];
+		CpuId(0, 0, regs);
+		unsigned int maxLeaf = regs[0];
+
+		CpuId(1, 0, regs);
+		bool sse41 = (regs[2] & (1u << 19)) != 0;
+		bool fma = (regs[2] & (1u << 12)) != 0;
+		bool osxsave = (regs[2] & (1u << 27)) != 0;
+		bool avx = (regs[2] & (1u << 28)) != 0;
+		bool f16c = (regs[2] & (1u << 29)) != 0;
+
+		bool avx2 = false;
+		if (maxLeaf >= 7) {
+			CpuId(7, 0, regs);
+			avx2 = (regs[1] & (1u << 5)) != 0;
+		}
+
+		// the OS has to save the ymm registers too
+		bool ymmEnabled = osxsave && (XGetBV() & 6) == 6;
+
+		if (avx && avx2 && fma && f16c && ymmEnabled) return Level::AVX2;
+		if (sse41) return Level::SSE41;
+		return Level::Scalar;
+	}
+#else
+	static Level DetectUncached() {
+		return Level::Scalar;
+	}
+#endif
+
+	Level Detect() {
+		static const Level level = DetectUncached();
+		return level;
+	}
+
+	const char* GetName(Level level) {
+		switch (level) {
+			case Level::Scalar:	return "scalar";
+			case Level::SSE41:	return "sse4.1";
+			case Level::AVX2:	return "avx2";
+		}
+		return "unknown";
+	}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// Runtime dispatch helpers for the SIMD kernels. Kernels are compiled per instruction
+// set with the SIMD_TARGET_* attributes and picked once at startup with Simd::Detect().
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define SIMD_X86 1
+	#include <immintrin.h>
+#else
+	#define SIMD_X86 0
+#endif
+
+#if defined(_MSC_VER)
+	// MSVC emits any intrinsic regardless of /arch
+	#define SIMD_TARGET_SSE41
+	#define SIMD_TARGET_AVX2
+	#define SIMD_TARGET_AVX2_F16C
+#else
+	#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+	#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+	#define SIMD_TARGET_AVX2_F16C __attribute__((target("avx2,fma,f16c")))
+#endif
+
+namespace Simd {
+
+	enum class Level {
+		Scalar = 0,
+		SSE41 = 1,
+		AVX2 = 2				// implies FMA and F16C
+	};
+
+	Level Detect();				// best level supported by this CPU + OS, cached
+	const char* GetName(Level level);
+
+	// the lower of the requested level and what the machine supports
+	inline Level Clamp(Level requested) {
+		Level best = Detect();
+		return (int)requested < (int)best ? requested : best;
+	}
+
+}
@@ -1,37 +1,268 @@
 #include "Texture.h"
 
-#include "vendor/std_image/stb_image.h"
+#include "GLState.h"
+#include "Mipmap.h"
+#include "TextureCache.h"
+
+#include <chrono>
+#include <iostream>
+#include <cstring>
+
+static double Now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct PixelTransfer {
+	GLenum internalFormat, format, type;
+};
+
+static PixelTransfer GetPixelTransfer(TextureFormat format) {
+	switch (format) {
+		case TextureFormat::RGBA8:	return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+		case TextureFormat::BGRA8:	return { GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE };
+		case TextureFormat::R8:		return { GL_R8, GL_RED, GL_UNSIGNED_BYTE };
+		case TextureFormat::R16UI:	return { GL_R16UI, GL_RED_INTEGER, GL_UNSIGNED_SHORT };
+	}
+	return { GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE };
+}
+
+// BC4 holds one channel, sampled as (r, r, r, 1) it reads like the greyscale image it came from
+static void SetGreySwizzle(bool grey) {
+	static const GLint s_Grey[4] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+	static const GLint s_Identity[4] = { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA };
+	GLCall(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, grey ? s_Grey : s_Identity));
+}
+
+unsigned int Texture::GetBytesPerPixel(TextureFormat format) {
+	switch (format) {
+		case TextureFormat::RGBA8:
+		case TextureFormat::BGRA8:	return 4;
+		case TextureFormat::R8:		return 1;
+		case TextureFormat::R16UI:	return 2;
+	}
+	return 4;
+}
 
 Texture::Texture(const std::string& path)
-	:m_RendererID(0), m_FilePath(path), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0) {
+	:m_RendererID(0), m_FilePath(path), m_Width(0), m_Height(0), m_BPP(4), m_Levels(1), m_Compression(BlockFormat::None), m_Sampler(),
+	m_Format(TextureFormat::RGBA8), m_PixelBuffer(0), m_RegionSize(0), m_RegionCount(0), m_Region(0), m_Persistent(false), m_Mapped(nullptr), m_Fences(), m_UpdateStart(0.0), m_Stats() {
+
+	TextureImage image;
+	std::string error;
+	if (!TextureCache::Load(path, image, &error))					// stb_image decode, or blocks from the cache
+		std::cout << "Failed to load texture " << path << ": " << error << std::endl;
+
+	CreateImage();
+	SetImage(image);
+}
+
+Texture::Texture(const std::string& path, int width, int height, const unsigned char* rgba)
+	:m_RendererID(0), m_FilePath(path), m_Width(width), m_Height(height), m_BPP(4), m_Levels(1), m_Compression(BlockFormat::None), m_Sampler(),
+	m_Format(TextureFormat::RGBA8), m_PixelBuffer(0), m_RegionSize(0), m_RegionCount(0), m_Region(0), m_Persistent(false), m_Mapped(nullptr), m_Fences(), m_UpdateStart(0.0), m_Stats() {
+
+	CreateImage();
+	SetImage(width, height, rgba);
+}
+
+void Texture::CreateImage() {
+	GLCall(glGenTextures(1, &m_RendererID));
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	Sampler::SetTextureParameters(GL_TEXTURE_2D, m_Sampler);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Texture::SetImage(int width, int height, const unsigned char* rgba) {
+	SetLevels(BlockFormat::None, width, height, 1, rgba);
+}
+
+void Texture::SetImage(const TextureImage& image) {
+	SetLevels(image.format, image.width, image.height, image.levels, image.data.empty() ? nullptr : image.data.data());
+}
+
+void Texture::SetLevels(BlockFormat format, int width, int height, int levels, const unsigned char* data) {
+	ASSERT(!IsStreaming());
+
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	GLenum internalFormat = format == BlockFormat::BC1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RED_RGTC1;
+	for (int level = 0; level < levels; level++) {
+		int levelWidth = GetMipSize(width, level), levelHeight = GetMipSize(height, level);
+		size_t size = GetBlockCompressedSize(format, levelWidth, levelHeight);
+		if (format == BlockFormat::None) {
+			GLCall(glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, levelWidth, levelHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, data));
+		}
+		else {
+			GLCall(glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, levelWidth, levelHeight, 0, (GLsizei)size, data));
+		}
+		if (data) data += size;
+	}
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1));		// levels left from a bigger image stay out of sampling
+	if ((format == BlockFormat::BC4) != (m_Compression == BlockFormat::BC4)) SetGreySwizzle(format == BlockFormat::BC4);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
 
-	stbi_set_flip_vertically_on_load(1);
-	m_LocalBuffer = stbi_load(path.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+	m_Width = width;
+	m_Height = height;
+	m_Levels = levels;
+	m_Compression = format;
+}
+
+bool Texture::GenerateMipmaps() {
+	ASSERT(!IsStreaming());
+	if (m_Compression != BlockFormat::None) return false;			// the GL can't encode blocks, TextureCache::SetMipmaps() can
+
+	m_Levels = GetMipLevelCount(m_Width, m_Height);
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1));
+	GLCall(glGenerateMipmap(GL_TEXTURE_2D));
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+	return true;
+}
+
+void Texture::SetSampler(const SamplerSettings& settings) {
+	m_Sampler = settings;
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	Sampler::SetTextureParameters(GL_TEXTURE_2D, settings);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+}
+
+size_t Texture::GetMemorySize() const {
+	if (IsStreaming()) return (size_t)m_Width * m_Height * m_BPP;
+	return GetMipChainSize(m_Compression, m_Width, m_Height, m_Levels);
+}
+
+Texture::Texture(int width, int height, TextureFormat format, unsigned int regionCount)
+	:m_RendererID(0), m_Width(width), m_Height(height), m_BPP((int)GetBytesPerPixel(format)), m_Levels(1), m_Compression(BlockFormat::None), m_Sampler(),
+	m_Format(format), m_PixelBuffer(0), m_RegionSize(0), m_RegionCount(1), m_Region(0), m_Persistent(false), m_Mapped(nullptr), m_Fences(), m_UpdateStart(0.0), m_Stats() {
+
+	PixelTransfer transfer = GetPixelTransfer(format);
+	if (format == TextureFormat::R16UI) m_Sampler.filter = TextureFilter::Nearest;		// integer textures can't be filtered
 
 	GLCall(glGenTextures(1, &m_RendererID));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	Sampler::SetTextureParameters(GL_TEXTURE_2D, m_Sampler);
 
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP));
-	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP));
+	// immutable storage, so the driver never has to check for a redefinition on upload
+	if (GLEW_ARB_texture_storage) {
+		GLCall(glTexStorage2D(GL_TEXTURE_2D, 1, transfer.internalFormat, width, height));
+	}
+	else {
+		GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+		GLCall(glTexImage2D(GL_TEXTURE_2D, 0, transfer.internalFormat, width, height, 0, transfer.format, transfer.type, nullptr));
+	}
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	m_RegionSize = (unsigned int)width * height * m_BPP;
+	GLCall(glGenBuffers(1, &m_PixelBuffer));
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
 
-	if (m_LocalBuffer) stbi_image_free(m_LocalBuffer);
+	if (GLEW_ARB_buffer_storage) {
+		m_RegionCount = regionCount < 1 ? 1 : (regionCount > MaxRegions ? MaxRegions : regionCount);
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLCall(glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)m_RegionSize * m_RegionCount, nullptr, flags));
+		GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)m_RegionSize * m_RegionCount, flags));
+		m_Persistent = m_Mapped != nullptr;
+	}
 
+	if (!m_Persistent) {
+		// one buffer, orphaned on every update so the driver hands out fresh memory
+		m_RegionCount = 1;
+		GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_RegionSize, nullptr, GL_STREAM_DRAW));
+	}
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);		// a bound unpack buffer would swallow client pointer uploads
 }
 
 Texture::~Texture() {
-	GLCall(glDeleteTextures(1, &m_RendererID));
+	for (GLsync& fence : m_Fences)
+		if (fence) glDeleteSync(fence);
+
+	if (m_Mapped) {
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
+		GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	if (m_PixelBuffer) GLState::DeleteBuffer(m_PixelBuffer);
+	GLState::DeleteTexture(m_RendererID);
+}
+
+void* Texture::BeginUpdate() {
+	ASSERT(IsStreaming());
+
+	if (!m_Persistent) {
+		double start = Now();
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
+		GLCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_RegionSize, nullptr, GL_STREAM_DRAW));		// orphan
+		GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_RegionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		m_UpdateStart = Now();
+		m_Stats.uploadSeconds += m_UpdateStart - start;
+		return m_Mapped;											// null if the map failed, the frame is skipped
+	}
+
+	m_Region = (m_Region + 1) % m_RegionCount;
+
+	// wait until the GPU has copied the last update out of this region
+	if (GLsync fence = m_Fences[m_Region]) {
+		GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (status == GL_TIMEOUT_EXPIRED) {
+			double stallStart = Now();
+			m_Stats.stalls++;
+			do {
+				status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);	// 1 ms
+			} while (status == GL_TIMEOUT_EXPIRED);
+			m_Stats.stallSeconds += Now() - stallStart;
+		}
+		glDeleteSync(fence);
+		m_Fences[m_Region] = nullptr;
+	}
+
+	m_UpdateStart = Now();
+	return m_Mapped + (size_t)m_Region * m_RegionSize;
+}
+
+void Texture::EndUpdate() {
+	if (!m_Persistent && !m_Mapped) return;							// BeginUpdate() couldn't map
+
+	double written = Now();
+	m_Stats.writeSeconds += written - m_UpdateStart;
+	PixelTransfer transfer = GetPixelTransfer(m_Format);
+	bool aligned = (m_Width * m_BPP) % 4 == 0;
+
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffer);
+	if (!m_Persistent) {
+		GLCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+		m_Mapped = nullptr;
+	}
+	GLState::BindTexture(GL_TEXTURE_2D, m_RendererID);
+	if (!aligned) {
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	}
+	GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, m_Width, m_Height, transfer.format, transfer.type,
+		(const void*)((size_t)m_Region * m_RegionSize)));									// an offset into the bound unpack buffer
+	if (!aligned) {
+		GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	}
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	if (m_Persistent) {
+		GLsync& fence = m_Fences[m_Region];							// the copy is the only reader, fence right behind it
+		if (fence) glDeleteSync(fence);
+		fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	m_Stats.uploadSeconds += Now() - written;
+	m_Stats.bytesUploaded += m_RegionSize;
+	m_Stats.uploads++;
+}
+
+void Texture::Update(const void* pixels) {
+	void* mapped = BeginUpdate();
+	if (mapped) std::memcpy(mapped, pixels, m_RegionSize);
+	EndUpdate();
 }
 
 void Texture::Bind(unsigned int slot) {
-	GLCall(glActiveTexture(GL_TEXTURE0 + slot));
-	GLCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GLState::BindTexture(slot, GL_TEXTURE_2D, m_RendererID);
 }
 
 void Texture::Unbind() {
-	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
 }
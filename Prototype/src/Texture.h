@@ -1,22 +1,84 @@
 #pragma once
 
 #include <string>
+#include "BlockCompression.h"
 #include "Renderer.h"
+#include "Sampler.h"
+#include "VertexBuffer.h"
+
+struct TextureImage;
+
+enum class TextureFormat {
+	RGBA8,									// what file textures hold
+	BGRA8,									// Kinect v2 colour as delivered, swizzled by the upload
+	R8,										// infrared / greyscale
+	R16UI									// depth in millimetres: usampler2D, nearest filtering only
+};
 
 class Texture {
+public:
+	static const unsigned int MaxRegions = 4;
 private:
 	unsigned int m_RendererID;
 	std::string m_FilePath;
-	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+	int m_Levels;							// mip levels in use, 1 until GenerateMipmaps() or a chain from TextureCache
+	BlockFormat m_Compression;				// file textures only
+	SamplerSettings m_Sampler;				// the texture's own parameters, a bound Sampler overrides them
+
+	// streaming: the CPU fills pixel unpack buffer region k+1 while the GPU copies region k
+	TextureFormat m_Format;
+	unsigned int m_PixelBuffer;
+	unsigned int m_RegionSize;
+	unsigned int m_RegionCount;
+	unsigned int m_Region;					// region of the last BeginUpdate
+	bool m_Persistent;						// ARB_buffer_storage mapping, else orphan + map per update
+	unsigned char* m_Mapped;
+	GLsync m_Fences[MaxRegions];
+	double m_UpdateStart;
+	StreamStats m_Stats;
 public:
-	Texture(const std::string& path);
+	Texture(const std::string& path);		// decoded (or read from TextureCache) and uploaded before returning
+	Texture(const std::string& path, int width, int height, const unsigned char* rgba);	// pixels at hand, e.g. TextureLoader's placeholder for `path`
+	Texture(int width, int height, TextureFormat format, unsigned int regionCount = 3);	// streaming, contents undefined until the first update
 	~Texture();
 
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+
 	void Bind(unsigned int slot = 0);
 	void Unbind();
 
+	void SetImage(int width, int height, const unsigned char* rgba);	// new RGBA8 contents and size, not for streaming textures
+	void SetImage(const TextureImage& image);							// RGBA8 or block compressed, every mip level it holds
+
+	bool GenerateMipmaps();					// on the GPU, RGBA8 only: false for compressed textures
+	void SetSampler(const SamplerSettings& settings);
+	inline const SamplerSettings& GetSampler() const { return m_Sampler; }
+
+	// streaming: write GetWidth() x GetHeight() tightly packed pixels, bottom row first, into the
+	// returned pointer, then EndUpdate() queues the copy into the texture and returns at once.
+	// Null when the unpack buffer can't be mapped: write nothing, EndUpdate() then skips the frame
+	void* BeginUpdate();
+	void EndUpdate();
+	void Update(const void* pixels);		// copy in + EndUpdate
+
+	inline const std::string& GetFilePath() const { return m_FilePath; }
 	inline int GetWidth() const { return m_Width; }
 	inline int GetHeight() const { return m_Height; }
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline TextureFormat GetFormat() const { return m_Format; }
+	inline BlockFormat GetCompression() const { return m_Compression; }
+	inline int GetLevelCount() const { return m_Levels; }
+	size_t GetMemorySize() const;			// every mip level in video memory, as allocated
+	inline bool IsStreaming() const { return m_PixelBuffer != 0; }
+	inline bool IsPersistent() const { return m_Persistent; }
+	inline const StreamStats& GetStats() const { return m_Stats; }
+
+	static unsigned int GetBytesPerPixel(TextureFormat format);
+
+private:
+	void CreateImage();
+	void SetLevels(BlockFormat format, int width, int height, int levels, const unsigned char* data);
 
 };
\ No newline at end of file
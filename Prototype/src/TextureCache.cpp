@@ -0,0 +1,234 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#include "Hash.h"
+#include "ImageDecoder.h"
+#include "MappedFile.h"
+#include "Mipmap.h"
+#include "Renderer.h"
+
+static const char s_Magic[4] = { 'K', 'V', 'T', 'C' };
+static const uint32_t s_Version = 2;		// bump with any change to the encoder's output
+
+struct TextureCacheHeader {
+	char magic[4];
+	uint32_t version;
+	uint64_t key;							// repeated so a renamed / truncated file can't pass as another entry
+	uint32_t format;
+	int32_t width;
+	int32_t height;
+	int32_t levels;
+	uint64_t length;						// 64 bit, so the header has no padding
+};
+
+static struct {
+	std::mutex mutex;						// guards everything here
+	bool compressing = false;
+	bool mipmaps = false;
+	bool bc1 = false;						// EXT_texture_compression_s3tc; BC4 is core
+	std::string directory;
+	TextureCacheStats stats = {};
+} s_Cache;
+
+static double Now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string EntryPath(const std::string& directory, uint64_t key) {
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016llx.tex", (unsigned long long)key);
+	return (std::filesystem::path(directory) / name).string();
+}
+
+void TextureCache::SetCompression(bool enabled) {
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	s_Cache.compressing = enabled;
+	s_Cache.bc1 = GLEW_EXT_texture_compression_s3tc != 0;
+	if (enabled && !s_Cache.bc1) std::cout << "Warning: no S3TC, colour textures stay uncompressed" << std::endl;
+}
+
+void TextureCache::SetDirectory(const std::string& directory) {
+	std::error_code error;
+	if (!directory.empty()) std::filesystem::create_directories(directory, error);
+
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	s_Cache.directory = error ? std::string() : directory;
+	if (error) std::cout << "Warning: texture cache disabled, cannot create " << directory << ": " << error.message() << std::endl;
+}
+
+bool TextureCache::IsCompressing() {
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	return s_Cache.compressing;
+}
+
+bool TextureCache::IsEnabled() {
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	return s_Cache.compressing && !s_Cache.directory.empty();
+}
+
+void TextureCache::SetMipmaps(bool enabled) {
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	s_Cache.mipmaps = enabled;
+}
+
+bool TextureCache::IsMipmapping() {
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	return s_Cache.mipmaps;
+}
+
+BlockFormat TextureCache::ChooseFormat(const unsigned char* rgba, int width, int height, int channels) {
+	if (channels == 1) return BlockFormat::BC4;
+	if (channels == 2) return BlockFormat::None;				// grey + alpha
+
+	bool bc1;
+	{
+		std::lock_guard<std::mutex> lock(s_Cache.mutex);
+		bc1 = s_Cache.bc1;
+	}
+	if (!bc1) return BlockFormat::None;
+	if (channels == 4)
+		for (size_t i = 3; i < (size_t)width * height * 4; i += 4)
+			if (rgba[i] != 255) return BlockFormat::None;
+	return BlockFormat::BC1;
+}
+
+static bool ReadEntry(const std::string& path, uint64_t key, TextureImage& image) {
+	std::ifstream stream(path, std::ios::binary);
+	if (!stream) return false;
+
+	TextureCacheHeader header;
+	bool valid = (bool)stream.read((char*)&header, sizeof(header))
+		&& std::equal(s_Magic, s_Magic + 4, header.magic) && header.version == s_Version && header.key == key
+		&& (header.format == (uint32_t)BlockFormat::BC1 || header.format == (uint32_t)BlockFormat::BC4)
+		&& header.width > 0 && header.height > 0 && header.levels >= 1 && header.levels <= GetMipLevelCount(header.width, header.height)
+		&& header.length == GetMipChainSize((BlockFormat)header.format, header.width, header.height, header.levels);
+	if (!valid) return false;
+
+	image.format = (BlockFormat)header.format;
+	image.width = header.width;
+	image.height = header.height;
+	image.levels = header.levels;
+	image.data.resize(header.length);
+	return (bool)stream.read((char*)image.data.data(), header.length);
+}
+
+// write aside and rename, another instance starting at the same time never reads half a file
+static bool WriteEntry(const std::string& path, uint64_t key, const TextureImage& image) {
+	TextureCacheHeader header = { { s_Magic[0], s_Magic[1], s_Magic[2], s_Magic[3] }, s_Version, key,
+		(uint32_t)image.format, image.width, image.height, image.levels, (uint64_t)image.data.size() };
+
+	std::string temporary = path + ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		stream.write((const char*)&header, sizeof(header));
+		stream.write((const char*)image.data.data(), image.data.size());
+		if (!stream) return false;
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, path, error);
+	if (error) std::remove(temporary.c_str());
+	return !error;
+}
+
+bool TextureCache::Load(const std::string& path, TextureImage& image, std::string* error) {
+	image = { BlockFormat::None, 0, 0, 1, {} };
+
+	bool compressing, mipmaps, bc1;
+	std::string directory;
+	{
+		std::lock_guard<std::mutex> lock(s_Cache.mutex);
+		compressing = s_Cache.compressing;
+		mipmaps = s_Cache.mipmaps;
+		bc1 = s_Cache.bc1;
+		directory = s_Cache.directory;
+	}
+
+	MappedFile file(path);
+	if (!file.IsOpen()) {
+		if (error) *error = "cannot open file";
+		return false;
+	}
+
+	double start = Now();
+	uint64_t key = 0;
+	std::string entry;
+	bool rejected = false;
+	if (compressing && !directory.empty()) {
+		// the same directory may be shared with a machine without S3TC, whose entries must not be BC1
+		const uint32_t variant[3] = { s_Version, mipmaps, bc1 };
+		key = hash::Fnv1a64(file.GetData(), file.GetSize(), hash::Fnv1a64(variant, sizeof(variant)));
+		entry = EntryPath(directory, key);
+		if (ReadEntry(entry, key, image)) {
+			std::lock_guard<std::mutex> lock(s_Cache.mutex);
+			s_Cache.stats.loaded++;
+			s_Cache.stats.hits++;
+			s_Cache.stats.rgbaBytes += GetMipChainSize(BlockFormat::None, image.width, image.height, image.levels);
+			s_Cache.stats.uploadBytes += image.data.size();
+			s_Cache.stats.readSeconds += Now() - start;
+			return true;
+		}
+		rejected = std::filesystem::exists(entry);
+		if (rejected) std::remove(entry.c_str());
+	}
+
+	double decodeStart = Now();
+	DecodedImage decoded;
+	if (!DecodeImage(file.GetData(), file.GetSize(), decoded, error)) return false;
+	double decodeSeconds = Now() - decodeStart;
+
+	double encodeStart = Now();
+	int width = decoded.width, height = decoded.height;
+	BlockFormat format = compressing ? ChooseFormat(decoded.pixels.get(), width, height, decoded.channels) : BlockFormat::None;
+	Encode(decoded.pixels.get(), width, height, format, mipmaps, image);
+	decoded.pixels.reset();
+	double encodeSeconds = format == BlockFormat::None && !mipmaps ? 0.0 : Now() - encodeStart;
+
+	bool stored = format != BlockFormat::None && !entry.empty() && WriteEntry(entry, key, image);
+
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	s_Cache.stats.loaded++;
+	if (format != BlockFormat::None) s_Cache.stats.encoded++;
+	if (rejected) s_Cache.stats.rejected++;
+	if (stored) s_Cache.stats.stored++;
+	s_Cache.stats.rgbaBytes += GetMipChainSize(BlockFormat::None, width, height, image.levels);
+	s_Cache.stats.uploadBytes += image.data.size();
+	s_Cache.stats.decodeSeconds += decodeSeconds;
+	s_Cache.stats.encodeSeconds += encodeSeconds;
+	return true;
+}
+
+void TextureCache::Encode(const unsigned char* rgba, int width, int height, BlockFormat format, bool mipmaps, TextureImage& image) {
+	image.format = format;
+	image.width = width;
+	image.height = height;
+	image.levels = mipmaps ? GetMipLevelCount(width, height) : 1;
+	image.data.resize(GetMipChainSize(format, width, height, image.levels));
+
+	// each level is filtered from the uncompressed one above it, never from decoded blocks
+	std::vector<unsigned char> above, below;
+	const unsigned char* source = rgba;
+	unsigned char* out = image.data.data();
+	for (int level = 0; level < image.levels; level++) {
+		int levelWidth = GetMipSize(width, level), levelHeight = GetMipSize(height, level);
+		if (level > 0) {
+			below.resize((size_t)levelWidth * levelHeight * 4);
+			DownsampleBox(source, GetMipSize(width, level - 1), GetMipSize(height, level - 1), below.data());
+			above.swap(below);
+			source = above.data();
+		}
+		CompressBlocks(format, source, levelWidth, levelHeight, out);
+		out += GetBlockCompressedSize(format, levelWidth, levelHeight);
+	}
+}
+
+TextureCacheStats TextureCache::GetStats() {
+	std::lock_guard<std::mutex> lock(s_Cache.mutex);
+	return s_Cache.stats;
+}
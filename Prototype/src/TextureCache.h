@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+
+// What a Texture uploads: RGBA8 texels or compressed blocks, bottom row first, level 0 then
+// each smaller mip level packed after it
+struct TextureImage {
+	BlockFormat format = BlockFormat::None;
+	int width = 0, height = 0;
+	int levels = 1;
+	std::vector<unsigned char> data;
+};
+
+struct TextureCacheStats {
+	unsigned int loaded;
+	unsigned int hits;
+	unsigned int encoded;
+	unsigned int rejected;					// corrupt or from another encoder version, encoded again
+	unsigned int stored;
+	unsigned long long rgbaBytes;			// the loaded images as RGBA8
+	unsigned long long uploadBytes;			// as they go to the GPU
+	double decodeSeconds;					// DecodeImage(), summed over threads
+	double encodeSeconds;
+	double readSeconds;						// cache hits: hash + read
+};
+
+// Decodes image files for Texture and TextureLoader (ImageDecoder.h), optionally into GPU
+// block compression: greyscale images become BC4, opaque colour BC1, anything with alpha stays
+// RGBA8 (BC1's one bit alpha would band). Compressed images go to an on-disk cache keyed by a hash of the
+// source file's bytes and the encoder version, so later launches skip both the PNG / JPEG
+// decode and the encode and hand the blocks straight to glCompressedTexImage2D.
+// Compression is off until SetCompression(true), caching until SetDirectory(). SetMipmaps(true)
+// builds the full mip chain on the CPU (Mipmap.h) and compresses every level, which is the only
+// way compressed textures get mips; the cache keeps chains and single levels, and entries made
+// with and without S3TC, apart. Load() is safe on any thread.
+class TextureCache {
+public:
+	static void SetCompression(bool enabled);				// needs a context, to ask for S3TC
+	static void SetDirectory(const std::string& directory);	// "" turns the cache off
+	static bool IsCompressing();
+	static bool IsEnabled();								// compressing and a directory is set
+	static void SetMipmaps(bool enabled);
+	static bool IsMipmapping();
+
+	static bool Load(const std::string& path, TextureImage& image, std::string* error = nullptr);		// false if unreadable / undecodable
+	static BlockFormat ChooseFormat(const unsigned char* rgba, int width, int height, int channels);
+	static void Encode(const unsigned char* rgba, int width, int height, BlockFormat format, bool mipmaps, TextureImage& image);
+
+	static TextureCacheStats GetStats();
+};
@@ -0,0 +1,110 @@
+#include "TextureLoader.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "ThreadPool.h"
+
+// grey / magenta checker, bottom row first like stbi output
+static const unsigned char s_Placeholder[2 * 2 * 4] = {
+	128, 128, 128, 255,   255, 0, 255, 255,
+	255, 0, 255, 255,   128, 128, 128, 255
+};
+
+static double Now() {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TextureLoader::TextureLoader(ThreadPool& pool, double budgetMilliseconds)
+	:m_Pool(pool), m_BudgetSeconds(budgetMilliseconds / 1000.0), m_InFlight(0), m_DecodeNanoseconds(0), m_Stats() {
+}
+
+TextureLoader::~TextureLoader() {
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Idle.wait(lock, [this] { return m_InFlight == 0; });
+}
+
+std::shared_ptr<Texture> TextureLoader::Load(const std::string& path) {
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>(path, 2, 2, s_Placeholder);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_InFlight++;
+	}
+	m_Stats.requested++;
+
+	std::weak_ptr<Texture> weak = texture;
+	m_Pool.Submit([this, path, weak]() { Decode(path, weak); });
+	return texture;
+}
+
+void TextureLoader::Decode(const std::string& path, std::weak_ptr<Texture> texture) {
+	Decoded decoded = { texture, {}, false, {} };
+
+	if (!texture.expired()) {
+		double start = Now();
+		decoded.loaded = TextureCache::Load(path, decoded.image, &decoded.error);
+		m_DecodeNanoseconds += (long long)((Now() - start) * 1e9);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Decoded.push_back(std::move(decoded));
+		m_InFlight--;
+		m_Idle.notify_all();			// under the lock: once it's released the destructor may return
+	}
+}
+
+unsigned int TextureLoader::Upload(double budgetSeconds) {
+	double start = Now();
+	unsigned int uploaded = 0;
+
+	for (;;) {
+		Decoded decoded;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Decoded.empty()) break;
+			decoded = std::move(m_Decoded.front());
+			m_Decoded.pop_front();
+		}
+
+		std::shared_ptr<Texture> texture = decoded.texture.lock();
+		if (texture && decoded.loaded) {
+			texture->SetImage(decoded.image);
+			m_Stats.uploaded++;
+			uploaded++;
+		}
+		else if (texture) {
+			std::cout << "Failed to load texture " << texture->GetFilePath() << ": " << decoded.error << std::endl;
+			m_Stats.failed++;
+		}
+
+		if (Now() - start >= budgetSeconds) break;				// checked after the upload, so every frame makes progress
+	}
+
+	double seconds = Now() - start;
+	m_Stats.uploadSeconds += seconds;
+	if (seconds > m_Stats.worstFrameSeconds) m_Stats.worstFrameSeconds = seconds;
+	return uploaded;
+}
+
+unsigned int TextureLoader::Update() {
+	return Upload(m_BudgetSeconds);
+}
+
+void TextureLoader::Flush() {
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Idle.wait(lock, [this] { return m_InFlight == 0; });
+	}
+	Upload(1e30);
+}
+
+unsigned int TextureLoader::GetPendingCount() {
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_InFlight + (unsigned int)m_Decoded.size();
+}
+
+const TextureLoaderStats& TextureLoader::GetStats() {
+	m_Stats.decodeSeconds = m_DecodeNanoseconds * 1e-9;
+	return m_Stats;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "Texture.h"
+#include "TextureCache.h"
+
+class ThreadPool;
+
+struct TextureLoaderStats {
+	unsigned int requested;
+	unsigned int uploaded;
+	unsigned int failed;					// unreadable or undecodable, the placeholder stays
+	double decodeSeconds;					// summed over the workers
+	double uploadSeconds;					// render thread
+	double worstFrameSeconds;				// longest Update()
+};
+
+// Loads image files without stalling the render thread. Load() hands back a Texture that shows
+// a small placeholder straight away; a ThreadPool worker decodes the file through TextureCache
+// (or reads its compressed blocks from there), and Update(), once a frame on the render thread,
+// uploads finished images until the frame's budget is spent. The Texture object and its GL name stay the same,
+// only its contents and size change, so it can be bound and queued while still loading.
+class TextureLoader {
+private:
+	struct Decoded {
+		std::weak_ptr<Texture> texture;		// dropped textures aren't uploaded
+		TextureImage image;
+		bool loaded;
+		std::string error;
+	};
+
+	ThreadPool& m_Pool;
+	double m_BudgetSeconds;
+	std::mutex m_Mutex;
+	std::condition_variable m_Idle;
+	std::deque<Decoded> m_Decoded;
+	unsigned int m_InFlight;				// submitted, not yet decoded
+	std::atomic<long long> m_DecodeNanoseconds;
+	TextureLoaderStats m_Stats;
+public:
+	TextureLoader(ThreadPool& pool, double budgetMilliseconds = 2.0);
+	~TextureLoader();						// waits for decodes in flight, drops what wasn't uploaded
+
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+
+	std::shared_ptr<Texture> Load(const std::string& path);
+	unsigned int Update();					// render thread: uploads within the budget, at least one image; returns how many
+	void Flush();							// waits for every decode and uploads it all, ignoring the budget
+
+	unsigned int GetPendingCount();			// still decoding or waiting for upload
+	inline void SetBudget(double milliseconds) { m_BudgetSeconds = milliseconds / 1000.0; }
+	const TextureLoaderStats& GetStats();
+
+private:
+	void Decode(const std::string& path, std::weak_ptr<Texture> texture);		// worker thread
+	unsigned int Upload(double budgetSeconds);
+};
@@ -0,0 +1,103 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+	:m_Busy(0), m_Stopping(false) {
+
+	if (threadCount == 0) {
+		unsigned int hardware = std::thread::hardware_concurrency();
+		threadCount = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_Threads.emplace_back(&ThreadPool::Run, this);
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stopping = true;
+	}
+	m_WorkReady.notify_all();
+	for (std::thread& thread : m_Threads) thread.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Queue.push_back(std::move(task));
+	}
+	m_WorkReady.notify_one();
+}
+
+void ThreadPool::Wait() {
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Idle.wait(lock, [this] { return m_Queue.empty() && m_Busy == 0; });
+}
+
+void ThreadPool::ParallelFor(unsigned int taskCount, const std::function<void(unsigned int)>& task) {
+	if (taskCount == 0) return;
+	if (taskCount == 1) {
+		task(0);
+		return;
+	}
+
+	// workers and the caller pull task indices from a shared counter until it runs out
+	struct Job {
+		std::atomic<unsigned int> next;
+		std::atomic<unsigned int> helpersLeft;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	auto job = std::make_shared<Job>();
+	job->next = 0;
+
+	unsigned int helpers = std::min(taskCount - 1, GetThreadCount());
+	job->helpersLeft = helpers;
+
+	auto drain = [job, taskCount, &task] {
+		for (unsigned int i = job->next++; i < taskCount; i = job->next++)
+			task(i);
+	};
+
+	for (unsigned int h = 0; h < helpers; h++) {
+		Submit([job, drain] {
+			drain();
+			if (--job->helpersLeft == 0) {
+				std::lock_guard<std::mutex> lock(job->mutex);
+				job->done.notify_one();
+			}
+		});
+	}
+
+	drain();
+
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->done.wait(lock, [&job] { return job->helpersLeft == 0; });
+}
+
+void ThreadPool::Run() {
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkReady.wait(lock, [this] { return m_Stopping || !m_Queue.empty(); });
+			if (m_Queue.empty()) return;			// stopping and drained
+
+			task = std::move(m_Queue.front());
+			m_Queue.pop_front();
+			m_Busy++;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Busy--;
+			if (m_Queue.empty() && m_Busy == 0) m_Idle.notify_all();
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads. Submit() queues fire-and-forget work; ParallelFor()
+// splits a job into tasks, runs them on the workers plus the calling thread and
+// returns once every task has finished.
+class ThreadPool {
+private:
+	std::vector<std::thread> m_Threads;
+	std::deque<std::function<void()>> m_Queue;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkReady;
+	std::condition_variable m_Idle;
+	unsigned int m_Busy;						// tasks taken off the queue and still running
+	bool m_Stopping;
+public:
+	ThreadPool(unsigned int threadCount = 0);	// 0 = one per hardware thread, minus the caller's
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void Submit(std::function<void()> task);
+	void Wait();								// until the queue is empty and nothing is running
+
+	// task(i) for i in [0, taskCount), blocking; don't call it from inside a pool task
+	void ParallelFor(unsigned int taskCount, const std::function<void(unsigned int)>& task);
+
+	inline unsigned int GetThreadCount() const { return (unsigned int)m_Threads.size(); }
+	inline unsigned int GetConcurrency() const { return GetThreadCount() + 1; }		// workers + the caller in ParallelFor
+
+private:
+	void Run();
+};
@@ -0,0 +1,124 @@
+#include "UniformBuffer.h"
+
+#include <cstring>
+
+#include "GLState.h"
+
+const char* GetUniformBlockName(UniformBinding binding) {
+	switch (binding) {
+		case UniformBinding::Camera:	return "Camera";
+		case UniformBinding::Object:	return "Object";
+	}
+	return "";
+}
+
+CameraBlock CameraBlock::From(const glm::mat4& view, const glm::mat4& projection, const glm::vec4& viewport) {
+	return { view, projection, projection * view, glm::inverse(view), glm::inverse(projection), viewport };
+}
+
+UniformBuffer::UniformBuffer(unsigned int size)
+	:m_RendererID(0), m_Size(size) {
+
+	GLCall(glGenBuffers(1, &m_RendererID));
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+	GLCall(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+}
+
+UniformBuffer::~UniformBuffer() {
+	GLState::DeleteBuffer(m_RendererID);
+}
+
+void UniformBuffer::SetData(const void* data, unsigned int size, unsigned int offset) {
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+	GLCall(glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data));
+}
+
+void UniformBuffer::Bind(UniformBinding binding) const {
+	GLState::BindBufferBase(GL_UNIFORM_BUFFER, (unsigned int)binding, m_RendererID);
+}
+
+static unsigned int OffsetAlignment() {
+	GLint alignment = 0;
+	GLCall(glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment));
+	return alignment > 0 ? alignment : 256;
+}
+
+unsigned int UniformRing::GetAlignedSize(unsigned int size) {
+	unsigned int alignment = OffsetAlignment();
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+UniformRing::UniformRing(unsigned int regionSize, unsigned int regionCount)
+	:m_RendererID(0), m_RegionSize(0), m_RegionCount(1), m_Region(0), m_Alignment(OffsetAlignment()), m_Head(0), m_Persistent(false), m_Mapped(nullptr), m_Fences() {
+
+	m_RegionSize = (regionSize + m_Alignment - 1) / m_Alignment * m_Alignment;		// keeps every region start aligned
+
+	GLCall(glGenBuffers(1, &m_RendererID));
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+
+	if (GLEW_ARB_buffer_storage) {
+		m_RegionCount = regionCount < 1 ? 1 : (regionCount > MaxRegions ? MaxRegions : regionCount);
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		GLCall(glBufferStorage(GL_UNIFORM_BUFFER, (GLsizeiptr)m_RegionSize * m_RegionCount, nullptr, flags));
+		GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)m_RegionSize * m_RegionCount, flags));
+		m_Persistent = m_Mapped != nullptr;
+	}
+
+	if (!m_Persistent) {
+		m_RegionCount = 1;
+		m_Staging.resize(m_RegionSize);
+		GLCall(glBufferData(GL_UNIFORM_BUFFER, m_RegionSize, nullptr, GL_STREAM_DRAW));
+	}
+}
+
+UniformRing::~UniformRing() {
+	for (GLsync& fence : m_Fences)
+		if (fence) glDeleteSync(fence);
+
+	if (m_Mapped) {
+		GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+		GLCall(glUnmapBuffer(GL_UNIFORM_BUFFER));
+	}
+	GLState::DeleteBuffer(m_RendererID);
+}
+
+void UniformRing::Begin() {
+	m_Head = 0;
+	if (!m_Persistent) return;
+
+	m_Region = (m_Region + 1) % m_RegionCount;
+	if (GLsync fence = m_Fences[m_Region]) {
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+		glDeleteSync(fence);
+		m_Fences[m_Region] = nullptr;
+	}
+}
+
+unsigned int UniformRing::Push(const void* data, unsigned int size) {
+	if (m_Head + size > m_RegionSize) return ~0u;
+
+	unsigned int offset = m_Head;
+	std::memcpy((m_Persistent ? m_Mapped + m_Region * m_RegionSize : m_Staging.data()) + offset, data, size);
+	m_Head = (offset + size + m_Alignment - 1) / m_Alignment * m_Alignment;
+	return m_Region * m_RegionSize + offset;
+}
+
+void UniformRing::Upload() {
+	if (m_Persistent || m_Head == 0) return;			// coherent mapping, the writes are already visible
+
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, m_RendererID);
+	GLCall(glBufferData(GL_UNIFORM_BUFFER, m_RegionSize, nullptr, GL_STREAM_DRAW));		// orphan
+	GLCall(glBufferSubData(GL_UNIFORM_BUFFER, 0, m_Head, m_Staging.data()));
+}
+
+void UniformRing::End() {
+	if (!m_Persistent) return;
+
+	GLsync& fence = m_Fences[m_Region];
+	if (fence) glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void UniformRing::Bind(UniformBinding binding, unsigned int offset, unsigned int size) const {
+	GLState::BindBufferRange(GL_UNIFORM_BUFFER, (unsigned int)binding, m_RendererID, offset, size);
+}
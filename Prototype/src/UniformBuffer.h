@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Renderer.h"
+
+// Uniform block binding points. Shader binds every block it finds with one of these names
+// to its point at link time, so a buffer bound to a point once reaches all programs.
+enum class UniformBinding : unsigned int {
+	Camera = 0,								// CameraBlock, once per frame
+	Object = 1								// ObjectBlock, a UniformRing range per draw
+};
+
+const char* GetUniformBlockName(UniformBinding binding);
+static const unsigned int UniformBindingCount = 2;
+
+// std140 mirror of `layout(std140) uniform Camera` (res/shaders/Points.shader, Chunk.shader)
+struct CameraBlock {
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::mat4 viewProjection;
+	glm::mat4 inverseView;
+	glm::mat4 inverseProjection;
+	glm::vec4 viewport;						// x, y, width, height in pixels
+
+	static CameraBlock From(const glm::mat4& view, const glm::mat4& projection, const glm::vec4& viewport);
+};
+static_assert(sizeof(CameraBlock) == 336, "CameraBlock must match the std140 layout");
+
+// std140 mirror of `layout(std140) uniform Object`
+struct ObjectBlock {
+	glm::mat4 model;
+};
+static_assert(sizeof(ObjectBlock) == 64, "ObjectBlock must match the std140 layout");
+
+// A uniform block's worth of data, e.g. the camera, rewritten whole
+class UniformBuffer {
+private:
+	unsigned int m_RendererID;
+	unsigned int m_Size;
+public:
+	UniformBuffer(unsigned int size);
+	~UniformBuffer();
+
+	UniformBuffer(const UniformBuffer&) = delete;
+	UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+	void Bind(UniformBinding binding) const;
+
+	inline unsigned int GetSize() const { return m_Size; }
+};
+
+// Per-draw uniform blocks packed into one buffer and bound by range. Push() copies a block at
+// the next GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT boundary and returns its offset; Upload() sends
+// the frame in one write and Bind() points a binding at one block. Like a streaming
+// VertexBuffer the buffer holds several frames' regions, mapped persistently and fenced where
+// ARB_buffer_storage exists, else a single region orphaned on every upload.
+class UniformRing {
+public:
+	static const unsigned int MaxRegions = 4;
+private:
+	unsigned int m_RendererID;
+	unsigned int m_RegionSize;
+	unsigned int m_RegionCount;
+	unsigned int m_Region;
+	unsigned int m_Alignment;
+	unsigned int m_Head;					// bytes used in the current region
+	bool m_Persistent;
+	unsigned char* m_Mapped;
+	std::vector<unsigned char> m_Staging;
+	GLsync m_Fences[MaxRegions];
+public:
+	UniformRing(unsigned int regionSize, unsigned int regionCount = 3);
+	~UniformRing();
+
+	UniformRing(const UniformRing&) = delete;
+	UniformRing& operator=(const UniformRing&) = delete;
+
+	void Begin();							// next region, waits if the GPU still reads it
+	unsigned int Push(const void* data, unsigned int size);		// offset for Bind(), ~0u once the region is full
+	void Upload();							// after the last Push, before the draws
+	void End();								// after the draws that read this region
+	void Bind(UniformBinding binding, unsigned int offset, unsigned int size) const;
+
+	inline unsigned int GetAlignment() const { return m_Alignment; }
+	static unsigned int GetAlignedSize(unsigned int size);	// what Push() takes up for a block of `size`
+	inline bool IsPersistent() const { return m_Persistent; }
+};
@@ -2,37 +2,55 @@
 #include "VertexBufferLayout.h"
 #include "VertexBuffer.h"	
 #include "Renderer.h"
+#include "GLState.h"
+
+#include <cstdint>
 
 VertexArray::VertexArray() {
 	GLCall(glGenVertexArrays(1, &m_RendererID));
 }
 
 VertexArray::~VertexArray() {
-	GLCall(glDeleteVertexArrays(1, &m_RendererID));
+	GLState::DeleteVertexArray(m_RendererID);
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout) {
-	Bind();
-	vb.Bind();								// Bind Vertex Buffer 
+	BindBuffer(vb);
 	
 	const auto& elements = layout.GetElements();
 	unsigned int offset = 0;
 
 	for (unsigned int i = 0; i < elements.size(); i++) {
 		const auto& element = elements[i];
-		
-		GLCall(glEnableVertexAttribArray(i));
-		GLCall(glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*) offset));
+		SetAttribute(i, element, layout.GetStride(), offset);
 		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
 	}
 
 	
 }
 
+void VertexArray::BindBuffer(const VertexBuffer& vb) const {
+	Bind();
+	vb.Bind();								// Bind Vertex Buffer 
+}
+
+void VertexArray::SetAttribute(unsigned int index, const VertexBufferElement& element, unsigned int stride, unsigned int offset, unsigned int divisor) const {
+	GLCall(glEnableVertexAttribArray(index));
+	if (element.integer) {
+		GLCall(glVertexAttribIPointer(index, element.count, element.type, stride, (const void*)(uintptr_t)offset));
+	}
+	else {
+		GLCall(glVertexAttribPointer(index, element.count, element.type, element.normalized, stride, (const void*)(uintptr_t)offset));
+	}
+	if (divisor) {
+		GLCall(glVertexAttribDivisor(index, divisor));
+	}
+}
+
 void VertexArray::Bind() const{
-	GLCall(glBindVertexArray(m_RendererID));
+	GLState::BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const {
-	GLCall(glBindVertexArray(0));
+	GLState::BindVertexArray(0);
 }
@@ -2,8 +2,8 @@
 
 
 #include "Renderer.h"
+#include "VertexBufferLayout.h"
 
-class VertexBufferLayout;
 class VertexBuffer;
 
 class VertexArray {
@@ -17,7 +17,30 @@ public:
 
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
 
+	template<typename... Attributes>
+	void AddBuffer(const VertexBuffer& vb, Layout<Attributes...>) {
+		using L = Layout<Attributes...>;
+		BindBuffer(vb);
+		for (unsigned int i = 0; i < L::Count; i++)
+			SetAttribute(i, L::Elements[i], L::Stride, L::Offset(i));
+	}
+
+	// per-instance attributes starting at `firstIndex`, advancing once every `divisor` instances
+	template<typename... Attributes>
+	void AddInstanceBuffer(const VertexBuffer& vb, Layout<Attributes...>, unsigned int firstIndex, unsigned int divisor = 1) {
+		using L = Layout<Attributes...>;
+		BindBuffer(vb);
+		for (unsigned int i = 0; i < L::Count; i++)
+			SetAttribute(firstIndex + i, L::Elements[i], L::Stride, L::Offset(i), divisor);
+	}
+
 	void Bind() const;
 	void Unbind() const;
 
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+
+private:
+	void BindBuffer(const VertexBuffer& vb) const;
+	void SetAttribute(unsigned int index, const VertexBufferElement& element, unsigned int stride, unsigned int offset, unsigned int divisor = 0) const;
+
 };
\ No newline at end of file
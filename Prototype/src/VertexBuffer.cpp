@@ -1,21 +1,121 @@
 #include "VertexBuffer.h"
 
 #include "Renderer.h"
+#include "GLState.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size) {
+#include <chrono>
+
+static double Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+    : m_Usage(BufferUsage::Static), m_RegionSize(size), m_RegionCount(1), m_Region(0), m_Persistent(false), m_Mapped(nullptr), m_Fences(), m_WriteStart(0.0), m_Stats() {
     glGenBuffers(1, &m_RendererID);                             // create buffer
-    glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);                // select buffer
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);         // select buffer
     glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);  // add data
 }
 
+VertexBuffer::VertexBuffer(unsigned int size, BufferUsage usage, unsigned int regionCount)
+    : m_Usage(usage), m_RegionSize(size), m_RegionCount(1), m_Region(0), m_Persistent(false), m_Mapped(nullptr), m_Fences(), m_WriteStart(0.0), m_Stats() {
+    glGenBuffers(1, &m_RendererID);                             // create buffer
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);         // select buffer
+
+    if (usage != BufferUsage::Streaming) {
+        glBufferData(GL_ARRAY_BUFFER, size, nullptr, usage == BufferUsage::Static ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);  // reserve storage only
+        return;
+    }
+
+    if (GLEW_ARB_buffer_storage) {
+        // one immutable allocation mapped for the lifetime of the buffer
+        m_RegionCount = regionCount < 1 ? 1 : (regionCount > MaxRegions ? MaxRegions : regionCount);
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLCall(glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)size * m_RegionCount, nullptr, flags));
+        GLCall(m_Mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)size * m_RegionCount, flags));
+        m_Persistent = m_Mapped != nullptr;
+    }
+
+    if (!m_Persistent) {
+        // no buffer storage: a single region, orphaned on every write so the driver renames it
+        m_RegionCount = 1;
+        m_Staging.resize(size);
+        glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+}
+
 VertexBuffer::~VertexBuffer() {
-    glDeleteBuffers(1, &m_RendererID);                          // delete buffer
+    for (GLsync& fence : m_Fences)
+        if (fence) glDeleteSync(fence);
+
+    if (m_Mapped) {
+        GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    GLState::DeleteBuffer(m_RendererID);                        // delete buffer
 }
 
 void VertexBuffer::Bind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, m_RendererID);                // select buffer
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);         // select buffer
 }
 
 void VertexBuffer::Unbind() const {
-    glBindBuffer(GL_ARRAY_BUFFER, 0);                           // unselect buffer
+    GLState::BindBuffer(GL_ARRAY_BUFFER, 0);                    // unselect buffer
+}
+
+void VertexBuffer::SetData(const void* data, unsigned int size, unsigned int offset) {
+    GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);         // select buffer
+    glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);       // replace data
+}
+
+void* VertexBuffer::BeginWrite() {
+    ASSERT(m_Usage == BufferUsage::Streaming);
+
+    if (!m_Persistent) {
+        m_WriteStart = Now();
+        return m_Staging.data();
+    }
+
+    m_Region = (m_Region + 1) % m_RegionCount;
+
+    // wait until the GPU has finished the draws that last read this region
+    if (GLsync fence = m_Fences[m_Region]) {
+        GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            double stallStart = Now();
+            m_Stats.stalls++;
+            do {
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);  // 1 ms
+            } while (status == GL_TIMEOUT_EXPIRED);
+            m_Stats.stallSeconds += Now() - stallStart;
+        }
+        glDeleteSync(fence);
+        m_Fences[m_Region] = nullptr;
+    }
+
+    m_WriteStart = Now();
+    return m_Mapped + GetRegionOffset();
+}
+
+void VertexBuffer::EndWrite(unsigned int size) {
+    ASSERT(size <= m_RegionSize);
+
+    double written = Now();
+    m_Stats.writeSeconds += written - m_WriteStart;
+    if (!m_Persistent) {
+        GLState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);                             // select buffer
+        glBufferData(GL_ARRAY_BUFFER, m_RegionSize, nullptr, GL_STREAM_DRAW);           // orphan
+        glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_Staging.data());                    // upload
+    }
+
+    m_Stats.uploadSeconds += Now() - written;
+    m_Stats.bytesUploaded += size;
+    m_Stats.uploads++;
+}
+
+void VertexBuffer::FenceRegion() {
+    if (!m_Persistent) return;                                  // orphaning needs no fences
+
+    GLsync& fence = m_Fences[m_Region];
+    if (fence) glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
@@ -1,13 +1,61 @@
 #pragma once
 #include "Renderer.h"
 
+#include <vector>
+
+enum class BufferUsage {
+	Static,			// uploaded once
+	Dynamic,		// replaced occasionally through SetData
+	Streaming		// rewritten every frame through BeginWrite / EndWrite
+};
+
+struct StreamStats {
+	unsigned long long bytesUploaded;
+	double writeSeconds;				// the caller filling the region, BeginWrite returning to EndWrite
+	double uploadSeconds;				// the GL calls moving it: map / orphan / copy / unmap, none when persistent
+	unsigned int uploads;
+	unsigned int stalls;				// BeginWrite found the GPU still reading the next region
+	double stallSeconds;
+
+	inline double GetWriteMBps() const { return writeSeconds > 0.0 ? bytesUploaded / writeSeconds / (1024.0 * 1024.0) : 0.0; }
+	inline double GetWriteMilliseconds() const { return uploads ? writeSeconds * 1000.0 / uploads : 0.0; }	// per upload
+	inline double GetUploadMilliseconds() const { return uploads ? uploadSeconds * 1000.0 / uploads : 0.0; }
+};
+
 class VertexBuffer {
+public:
+	static const unsigned int MaxRegions = 4;
 private:
 	unsigned int m_RendererID;
+	BufferUsage m_Usage;
+
+	// streaming ring: the CPU fills region k+1 while the GPU draws from region k
+	unsigned int m_RegionSize;
+	unsigned int m_RegionCount;
+	unsigned int m_Region;							// region of the last BeginWrite
+	bool m_Persistent;								// ARB_buffer_storage mapping, else orphan + glBufferSubData
+	unsigned char* m_Mapped;
+	std::vector<unsigned char> m_Staging;
+	GLsync m_Fences[MaxRegions];
+	double m_WriteStart;
+	StreamStats m_Stats;
 public:
 	VertexBuffer(const void* data, unsigned int size);
+	VertexBuffer(unsigned int size, BufferUsage usage = BufferUsage::Dynamic, unsigned int regionCount = 3);	// size is per region when streaming
 	~VertexBuffer();
 
 	void Bind() const ;
 	void Unbind() const ;
-};
\ No newline at end of file
+
+	void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
+	// streaming: write up to GetRegionSize() bytes into the returned pointer, then EndWrite
+	void* BeginWrite();
+	void EndWrite(unsigned int size);
+	void FenceRegion();								// after the draws that read the current region
+
+	inline unsigned int GetRegionOffset() const { return m_Region * m_RegionSize; }
+	inline unsigned int GetRegionSize() const { return m_RegionSize; }
+	inline bool IsPersistent() const { return m_Persistent; }
+	inline const StreamStats& GetStats() const { return m_Stats; }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <iterator>
 #include <vector>
 #include "Renderer.h"
 
@@ -8,12 +9,18 @@ struct VertexBufferElement {
 	unsigned int type;
 	unsigned int count;
 	unsigned char normalized;
+	unsigned char integer;		// GL_TRUE: read as ivec/uvec through glVertexAttribIPointer
 
-	static unsigned int GetSizeOfType(unsigned int type) {
+	static constexpr unsigned int GetSizeOfType(unsigned int type) {
 		switch (type) {
 			case GL_FLOAT:			return 4;
 			case GL_UNSIGNED_INT:	return 4;
 			case GL_UNSIGNED_BYTE:	return 1;
+			case GL_BYTE:			return 1;
+			case GL_INT:			return 4;
+			case GL_HALF_FLOAT:		return 2;
+			case GL_SHORT:			return 2;
+			case GL_UNSIGNED_SHORT:	return 2;
 		}
 		ASSERT(false);
 		return 0;
@@ -21,41 +28,107 @@ struct VertexBufferElement {
 
 };
 
+// Attribute formats for the compile-time Layout below
+namespace attrib {
+
+	template<unsigned int GLType, unsigned int Count, bool Normalized = false, bool Integer = false>
+	struct Format {
+		static constexpr unsigned int type = GLType;
+		static constexpr unsigned int count = Count;
+		static constexpr unsigned char normalized = Normalized ? GL_TRUE : GL_FALSE;
+		static constexpr unsigned char integer = Integer ? GL_TRUE : GL_FALSE;
+		static constexpr unsigned int size = VertexBufferElement::GetSizeOfType(GLType) * Count;
+		static_assert(size != 0, "attribute type has no known size");
+		static_assert(!(Normalized && Integer), "integer attributes can't be normalized");
+	};
+
+	using vec2f = Format<GL_FLOAT, 2>;
+	using vec3f = Format<GL_FLOAT, 3>;
+	using vec4f = Format<GL_FLOAT, 4>;
+	using half2 = Format<GL_HALF_FLOAT, 2>;
+	using half4 = Format<GL_HALF_FLOAT, 4>;
+	using rgb8 = Format<GL_UNSIGNED_BYTE, 3, true>;
+	using rgba8 = Format<GL_UNSIGNED_BYTE, 4, true>;
+	using snorm16x2 = Format<GL_SHORT, 2, true>;			// e.g. octahedral normals
+	using snorm16x4 = Format<GL_SHORT, 4, true>;			// quantized positions, w free for a flag
+	using uint1 = Format<GL_UNSIGNED_INT, 1, false, true>;
+	using ushort2 = Format<GL_UNSIGNED_SHORT, 2, false, true>;
+
+}
+
+// Vertex format fixed at compile time: Layout<attrib::vec3f, attrib::rgba8> has its stride,
+// offsets and GL types as constants, and VertexArray::AddBuffer sets it up without allocating.
+template<typename... Attributes>
+struct Layout {
+	static_assert(sizeof...(Attributes) > 0, "empty vertex layout");
+
+	static constexpr unsigned int Count = sizeof...(Attributes);
+	static constexpr unsigned int Stride = (Attributes::size + ...);
+	static constexpr VertexBufferElement Elements[] = { { Attributes::type, Attributes::count, Attributes::normalized, Attributes::integer }... };
+
+	static constexpr unsigned int Offset(unsigned int index) {
+		constexpr unsigned int sizes[] = { Attributes::size... };
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < index; i++) offset += sizes[i];
+		return offset;
+	}
+};
+
+// Vertex format built at run time
 class VertexBufferLayout {
 private:
 	std::vector<VertexBufferElement> m_Elements;
 	unsigned int m_Stride;
-	 
+
 public:
-	
+
 	VertexBufferLayout()
 		:m_Stride(0) {}
 
+	template<typename... Attributes>
+	VertexBufferLayout(Layout<Attributes...>)
+		:m_Elements(std::begin(Layout<Attributes...>::Elements), std::end(Layout<Attributes...>::Elements)), m_Stride(Layout<Attributes...>::Stride) {}
+
 
 	template<typename T>
 	void Push(unsigned int count) {
-		static_assert(true);
+		static_assert(sizeof(T) == 0, "no vertex attribute type for T");
 	}
 
-	template<>
-	void Push<float>(unsigned int count) {
-		m_Elements.push_back({GL_FLOAT, count, GL_FALSE});
-		m_Stride += VertexBufferElement::GetSizeOfType(GL_FLOAT) * count ;
-	}
+	inline void PushHalf(unsigned int count) { PushElement(GL_HALF_FLOAT, count, GL_FALSE); }
 
-	template<>
-	void Push<unsigned int>(unsigned int count) {
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT) * count;
-	}
+	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
+	inline unsigned int GetStride() const { return m_Stride; }
 
-	template<>
-	void Push<unsigned char>(unsigned int count) {
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE) * count;
+private:
+	void PushElement(unsigned int type, unsigned int count, unsigned char normalized, unsigned char integer = GL_FALSE) {
+		m_Elements.push_back({ type, count, normalized, integer });
+		m_Stride += VertexBufferElement::GetSizeOfType(type) * count;
 	}
 
-	inline const std::vector<VertexBufferElement> GetElements() const { return m_Elements; }
-	inline unsigned int GetStride() const { return m_Stride; }
+};
+
+template<>
+inline void VertexBufferLayout::Push<float>(unsigned int count) {
+	PushElement(GL_FLOAT, count, GL_FALSE);
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned int>(unsigned int count) {
+	PushElement(GL_UNSIGNED_INT, count, GL_FALSE, GL_TRUE);		// uvec in the shader, like attrib::uint1
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned char>(unsigned int count) {
+	PushElement(GL_UNSIGNED_BYTE, count, GL_TRUE);
+}
+
+template<>
+inline void VertexBufferLayout::Push<short>(unsigned int count) {
+	PushElement(GL_SHORT, count, GL_TRUE);
+}
 
-};
\ No newline at end of file
+template<>
+inline void VertexBufferLayout::Push<int>(unsigned int count) {
+	PushElement(GL_INT, count, GL_FALSE, GL_TRUE);
+}
@@ -0,0 +1,171 @@
+#include "VoxelGridFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+static const uint64_t s_Empty = ~0ull;
+static const unsigned int s_MinChunkPoints = 16384;		// below this a thread costs more than it saves
+
+// 21 bits per axis around the origin, +-10 km at 1 cm voxels; bit 63 stays clear so it can't collide with s_Empty
+static inline uint64_t VoxelKey(float x, float y, float z, float inverseSize) {
+	const int bias = 1 << 20;
+	uint64_t ix = (uint64_t)(std::min(std::max((int)std::floor(x * inverseSize) + bias, 0), 2 * bias - 1));
+	uint64_t iy = (uint64_t)(std::min(std::max((int)std::floor(y * inverseSize) + bias, 0), 2 * bias - 1));
+	uint64_t iz = (uint64_t)(std::min(std::max((int)std::floor(z * inverseSize) + bias, 0), 2 * bias - 1));
+	return ix | (iy << 21) | (iz << 42);
+}
+
+static inline uint64_t VoxelHash(uint64_t key) {
+	return key * 0x9E3779B97F4A7C15ull;			// Fibonacci hashing, the top bits pick the slot
+}
+
+static inline unsigned int ShardOf(uint64_t hash, unsigned int shardCount) {
+	return (unsigned int)((hash >> 24) & 0xFFFFFF) % shardCount;		// bits below the slot index
+}
+
+
+void VoxelGridFilter::Grid::Reserve(unsigned int entries) {
+	unsigned int bits = 10;
+	while ((1u << bits) < entries * 2) bits++;		// keep the load factor under 1/2
+	if (slots.empty() || shift > 64 - bits) {
+		slots.assign((size_t)1 << bits, Slot{ s_Empty, 0 });
+		shift = 64 - bits;
+	}
+
+	keys.reserve(entries); slotIndex.reserve(entries);
+	sumX.reserve(entries); sumY.reserve(entries); sumZ.reserve(entries);
+	sumR.reserve(entries); sumG.reserve(entries); sumB.reserve(entries);
+	counts.reserve(entries);
+}
+
+void VoxelGridFilter::Grid::Clear() {
+	for (uint32_t slot : slotIndex) slots[slot].key = s_Empty;
+	keys.clear(); slotIndex.clear();
+	sumX.clear(); sumY.clear(); sumZ.clear();
+	sumR.clear(); sumG.clear(); sumB.clear();
+	counts.clear();
+}
+
+inline void VoxelGridFilter::Grid::Add(uint64_t key, uint64_t hash, float x, float y, float z, float r, float g, float b, uint32_t count) {
+	size_t mask = slots.size() - 1;
+	size_t slot = (size_t)(hash >> shift);
+	while (slots[slot].key != key && slots[slot].key != s_Empty) slot = (slot + 1) & mask;
+
+	if (slots[slot].key == s_Empty) {
+		slots[slot] = Slot{ key, (uint32_t)keys.size() };
+		keys.push_back(key); slotIndex.push_back((uint32_t)slot);
+		sumX.push_back(x); sumY.push_back(y); sumZ.push_back(z);
+		sumR.push_back(r); sumG.push_back(g); sumB.push_back(b);
+		counts.push_back(count);
+	}
+	else {
+		uint32_t entry = slots[slot].entry;
+		sumX[entry] += x; sumY[entry] += y; sumZ[entry] += z;
+		sumR[entry] += r; sumG[entry] += g; sumB[entry] += b;
+		counts[entry] += count;
+	}
+}
+
+
+VoxelGridFilter::VoxelGridFilter(float voxelSize, const PointLayout& layout, ThreadPool* pool)
+	:m_Layout(layout), m_VoxelSize(voxelSize), m_Pool(pool) {}
+
+void VoxelGridFilter::ForEach(unsigned int taskCount, const std::function<void(unsigned int)>& task) {
+	if (m_Pool) m_Pool->ParallelFor(taskCount, task);
+	else for (unsigned int i = 0; i < taskCount; i++) task(i);
+}
+
+void VoxelGridFilter::Accumulate(const unsigned char* vertices, unsigned int begin, unsigned int end, Grid& grid) const {
+	float inverseSize = 1.0f / m_VoxelSize;
+	bool hasColor = m_Layout.colorOffset >= 0;
+
+	grid.Clear();
+	grid.Reserve(end - begin);
+
+	const unsigned char* vertex = vertices + (size_t)begin * m_Layout.stride;
+	for (unsigned int i = begin; i < end; i++, vertex += m_Layout.stride) {
+		float p[3], c[3] = { 0.0f, 0.0f, 0.0f };
+		std::memcpy(p, vertex + m_Layout.positionOffset, sizeof(p));
+		if (p[0] == 0.0f && p[1] == 0.0f && p[2] == 0.0f) continue;		// no depth at this pixel
+		if (hasColor) std::memcpy(c, vertex + m_Layout.colorOffset, sizeof(c));
+
+		uint64_t key = VoxelKey(p[0], p[1], p[2], inverseSize);
+		grid.Add(key, VoxelHash(key), p[0], p[1], p[2], c[0], c[1], c[2], 1);
+	}
+}
+
+void VoxelGridFilter::Emit(const Grid& grid, unsigned char* out) const {
+	for (unsigned int entry = 0; entry < grid.GetSize(); entry++, out += m_Layout.stride) {
+		float inverseCount = 1.0f / grid.counts[entry];
+		float p[3] = { grid.sumX[entry] * inverseCount, grid.sumY[entry] * inverseCount, grid.sumZ[entry] * inverseCount };
+		std::memcpy(out + m_Layout.positionOffset, p, sizeof(p));
+		if (m_Layout.colorOffset >= 0) {
+			float c[3] = { grid.sumR[entry] * inverseCount, grid.sumG[entry] * inverseCount, grid.sumB[entry] * inverseCount };
+			std::memcpy(out + m_Layout.colorOffset, c, sizeof(c));
+		}
+	}
+}
+
+unsigned int VoxelGridFilter::Process(const void* vertices, unsigned int count, void* out) {
+	PROFILE_SCOPE("Voxel Filter");
+
+	const unsigned char* input = (const unsigned char*)vertices;
+	unsigned char* output = (unsigned char*)out;
+
+	unsigned int threads = m_Pool ? m_Pool->GetConcurrency() : 1;
+	unsigned int chunks = std::max(1u, std::min(threads, count / s_MinChunkPoints));
+	if (m_Partials.size() < chunks) m_Partials.resize(chunks);
+
+	if (chunks == 1) {
+		Accumulate(input, 0, count, m_Partials[0]);
+		Emit(m_Partials[0], output);
+		return m_Partials[0].GetSize();
+	}
+
+	// 1. every chunk into its own grid, then sort its voxels into shard buckets
+	unsigned int shards = chunks;
+	if (m_Shards.size() < shards) m_Shards.resize(shards);
+	m_Buckets.resize((size_t)chunks * shards);
+	m_ShardOffsets.resize(shards + 1);
+
+	ForEach(chunks, [&](unsigned int chunk) {
+		Grid& grid = m_Partials[chunk];
+		Accumulate(input, (unsigned int)((uint64_t)count * chunk / chunks), (unsigned int)((uint64_t)count * (chunk + 1) / chunks), grid);
+
+		for (unsigned int s = 0; s < shards; s++) m_Buckets[(size_t)chunk * shards + s].clear();
+		for (unsigned int entry = 0; entry < grid.GetSize(); entry++)
+			m_Buckets[(size_t)chunk * shards + ShardOf(VoxelHash(grid.keys[entry]), shards)].push_back(entry);
+	});
+
+	// 2. each shard merges its voxels from every partial grid; shards own disjoint voxels
+	ForEach(shards, [&](unsigned int shard) {
+		size_t entries = 0;
+		for (unsigned int chunk = 0; chunk < chunks; chunk++) entries += m_Buckets[(size_t)chunk * shards + shard].size();
+
+		Grid& merged = m_Shards[shard];
+		merged.Clear();
+		merged.Reserve((unsigned int)entries);
+		for (unsigned int chunk = 0; chunk < chunks; chunk++) {
+			const Grid& grid = m_Partials[chunk];
+			for (uint32_t entry : m_Buckets[(size_t)chunk * shards + shard]) {
+				uint64_t key = grid.keys[entry];
+				merged.Add(key, VoxelHash(key), grid.sumX[entry], grid.sumY[entry], grid.sumZ[entry],
+					grid.sumR[entry], grid.sumG[entry], grid.sumB[entry], grid.counts[entry]);
+			}
+		}
+	});
+
+	// 3. centroids, each shard into its own slice of the output
+	m_ShardOffsets[0] = 0;
+	for (unsigned int s = 0; s < shards; s++) m_ShardOffsets[s + 1] = m_ShardOffsets[s] + m_Shards[s].GetSize();
+
+	ForEach(shards, [&](unsigned int shard) {
+		Emit(m_Shards[shard], output + (size_t)m_ShardOffsets[shard] * m_Layout.stride);
+	});
+
+	return m_ShardOffsets[shards];
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "BackProjector.h"
+
+class ThreadPool;
+
+// Downsamples a point cloud to one point per voxel: the centroid (and mean colour) of
+// every point that falls into it. Input and output use the same interleaved layout as
+// the point vertex buffer, so the result can be written straight into a mapped region.
+//
+// Each pool thread bins its share of the points into its own open addressing hash grid
+// with structure-of-arrays accumulators; partial grids are then merged in parallel
+// by splitting the voxels into hash shards, one shard per thread.
+class VoxelGridFilter {
+private:
+	struct Slot {
+		uint64_t key;							// packed voxel coordinates, Empty when free
+		uint32_t entry;
+	};
+
+	// hash index over dense accumulators kept in first-seen order, so a new voxel is an
+	// append and the voxels of the last few rows stay in cache
+	struct Grid {
+		std::vector<Slot> slots;
+		unsigned int shift;						// 64 - log2(slot count)
+		std::vector<uint64_t> keys;
+		std::vector<uint32_t> slotIndex;
+		std::vector<float> sumX, sumY, sumZ;
+		std::vector<float> sumR, sumG, sumB;
+		std::vector<uint32_t> counts;
+
+		void Reserve(unsigned int entries);
+		void Clear();
+		void Add(uint64_t key, uint64_t hash, float x, float y, float z, float r, float g, float b, uint32_t count);
+		inline unsigned int GetSize() const { return (unsigned int)keys.size(); }
+	};
+
+	PointLayout m_Layout;
+	float m_VoxelSize;
+	ThreadPool* m_Pool;
+	std::vector<Grid> m_Partials;				// one per input chunk
+	std::vector<Grid> m_Shards;					// merged, one per hash shard
+	std::vector<std::vector<uint32_t>> m_Buckets;	// [chunk * shards + shard] partial entries owned by that shard
+	std::vector<unsigned int> m_ShardOffsets;
+public:
+	VoxelGridFilter(float voxelSize, const PointLayout& layout, ThreadPool* pool = nullptr);	// no pool = single threaded
+
+	// `out` must have room for `count` vertices; returns the number of centroids written.
+	// Holes (all-zero positions) are dropped.
+	unsigned int Process(const void* vertices, unsigned int count, void* out);
+
+	inline void SetVoxelSize(float voxelSize) { m_VoxelSize = voxelSize; }
+	inline float GetVoxelSize() const { return m_VoxelSize; }
+	inline const PointLayout& GetLayout() const { return m_Layout; }
+
+private:
+	void Accumulate(const unsigned char* vertices, unsigned int begin, unsigned int end, Grid& grid) const;
+	void Emit(const Grid& grid, unsigned char* out) const;
+	void ForEach(unsigned int taskCount, const std::function<void(unsigned int)>& task);
+};
@@ -0,0 +1,90 @@
+#include "Benchmark.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "../BackProjector.h"
+
+namespace bench {
+
+	// the per-pixel loop the viewer started out with
+	static void NaiveBackProject(const DepthFrame& frame, const CameraIntrinsics& k, float* out) {
+		for (int v = 0; v < frame.height; v++) {
+			for (int u = 0; u < frame.width; u++) {
+				float z = frame.depth[(size_t)v * frame.width + u] * k.depthScale;
+				glm::vec3 p((u - k.cx) / k.fx * z, -(v - k.cy) / k.fy * z, -z);
+				float t = glm::clamp((z - 0.5f) / 4.0f, 0.0f, 1.0f);
+
+				out[0] = p.x; out[1] = p.y; out[2] = p.z;
+				out[3] = t; out[4] = 1.0f - glm::abs(2.0f * t - 1.0f); out[5] = 1.0f - t;
+				out += 6;
+			}
+		}
+	}
+
+	template<typename F>
+	static double MedianMilliseconds(int iterations, F&& f) {
+		std::vector<double> samples(iterations);
+		for (int i = 0; i < iterations; i++) {
+			Timer timer;
+			f();
+			samples[i] = timer.Milliseconds();
+		}
+		std::nth_element(samples.begin(), samples.begin() + iterations / 2, samples.end());
+		return samples[iterations / 2];
+	}
+
+	static void Report(const char* name, double ms, size_t points, double maxError) {
+		std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+			<< std::setw(9) << std::setprecision(3) << ms << " ms"
+			<< std::setw(10) << std::setprecision(1) << points / (ms * 1000.0) << " Mpts/s"
+			<< std::setw(8) << std::setprecision(1) << ms / (1000.0 / 30.0) * 100.0 << " % of 30 Hz budget"
+			<< "   max err " << std::scientific << std::setprecision(2) << maxError << std::endl;
+	}
+
+	void BackProjection() {
+		const int iterations = 200;
+		const CameraIntrinsics sets[] = { CameraIntrinsics::KinectV2(), CameraIntrinsics::KinectV1() };
+
+		for (const CameraIntrinsics& k : sets) {
+			SyntheticDepthSource source(k);
+			DepthFrame frame;
+			source.ReadFrame(frame);
+
+			size_t points = (size_t)k.width * k.height;
+			std::vector<float> reference(points * 6), output(points * 6);
+
+			std::cout << k.width << "x" << k.height << " (" << points << " points), median of " << iterations << " frames" << std::endl;
+
+			double ms = MedianMilliseconds(iterations, [&]() {
+				NaiveBackProject(frame, k, reference.data());
+				DoNotOptimize(reference.data());
+			});
+			Report("naive", ms, points, 0.0);
+
+			BackProjector projector(k, PointLayout(6 * sizeof(float), 0, 3 * sizeof(float)));
+			Simd::Level levels[] = { Simd::Level::Scalar, Simd::Level::SSE41, Simd::Level::AVX2 };
+			for (Simd::Level level : levels) {
+				if (Simd::Clamp(level) != level) continue;
+				projector.SetSimdLevel(level);
+
+				ms = MedianMilliseconds(iterations, [&]() {
+					projector.Process(frame.depth.data(), output.data());
+					DoNotOptimize(output.data());
+				});
+
+				double maxError = 0.0;
+				for (size_t i = 0; i < output.size(); i++)
+					maxError = std::max(maxError, (double)std::fabs(output[i] - reference[i]));
+				Report(Simd::GetName(level), ms, points, maxError);
+			}
+			std::cout << std::endl;
+		}
+	}
+
+}
@@ -0,0 +1,136 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "../DepthCodec.h"
+#include "../Recording.h"
+
+namespace bench {
+
+	struct DepthClip {
+		const char* name;
+		int width, height;
+		std::vector<DepthFrame> frames;
+	};
+
+	static DepthClip SyntheticClip(const char* name, unsigned int frameCount, bool noisy) {
+		CameraIntrinsics k = CameraIntrinsics::KinectV2();
+		SyntheticDepthSource source(k);
+		DepthClip clip = { name, k.width, k.height, std::vector<DepthFrame>(frameCount) };
+
+		// sensor-like: noise growing with depth, plus dropouts around depth edges
+		uint32_t seed = 12345;
+		for (DepthFrame& frame : clip.frames) {
+			source.ReadFrame(frame);
+			if (!noisy) continue;
+
+			std::vector<uint16_t> clean = frame.depth;
+			for (size_t i = 0; i < clean.size(); i++) {
+				if (!clean[i]) continue;
+				seed = seed * 1664525u + 1013904223u;
+				int sigma = 1 + clean[i] * clean[i] / 4000000;
+				int noise = (int)(seed >> 24) % (2 * sigma + 1) - sigma;
+				bool edge = i > 0 && std::abs((int)clean[i] - (int)clean[i - 1]) > 50;
+				frame.depth[i] = edge ? 0 : (uint16_t)(clean[i] + noise);
+			}
+		}
+		return clip;
+	}
+
+	static bool RecordedClip(const std::string& filepath, unsigned int maxFrames, DepthClip& clip) {
+		clip.name = "recorded";
+		bool stream = filepath.size() >= 4 && filepath.compare(filepath.size() - 4, 4, ".kvd") == 0;
+
+		if (stream) {
+			DepthStreamReader reader(filepath);
+			if (!reader.IsOpen()) return false;
+			clip.width = reader.GetIntrinsics().width;
+			clip.height = reader.GetIntrinsics().height;
+			DepthFrame frame;
+			while (clip.frames.size() < maxFrames && reader.ReadFrame(frame)) clip.frames.push_back(frame);
+		}
+		else {
+			RecordingReader reader(filepath);
+			if (!reader.IsOpen()) return false;
+			clip.width = reader.GetIntrinsics().width;
+			clip.height = reader.GetIntrinsics().height;
+			for (unsigned int i = 0; i < reader.GetFrameCount() && i < maxFrames; i++) {
+				DepthFrame frame = { i, 0.0, clip.width, clip.height, std::vector<uint16_t>((size_t)clip.width * clip.height) };
+				if (reader.GetFrame(i).DecodeDepth(frame.depth.data(), (unsigned int)frame.depth.size())) clip.frames.push_back(frame);
+			}
+		}
+		return !clip.frames.empty();
+	}
+
+	static void RunCodec(const DepthClip& clip, DepthCodec codec, Simd::Level level, const char* label) {
+		const int passes = 5;
+		unsigned int count = clip.width * clip.height;
+		size_t maxBytes = GetMaxEncodedSize(codec, count);
+
+		std::vector<std::vector<unsigned char>> encoded(clip.frames.size(), std::vector<unsigned char>(maxBytes));
+		std::vector<size_t> sizes(clip.frames.size());
+		std::vector<uint16_t> decoded(count);
+
+		double encodeSeconds = 1e30, decodeSeconds = 1e30;
+		for (int pass = 0; pass < passes; pass++) {
+			Timer timer;
+			for (size_t f = 0; f < clip.frames.size(); f++)
+				sizes[f] = EncodeDepth(codec, clip.frames[f].depth.data(), count, encoded[f].data());
+			encodeSeconds = std::min(encodeSeconds, timer.Seconds());
+
+			timer.Reset();
+			for (size_t f = 0; f < clip.frames.size(); f++) {
+				DecodeDepth(codec, encoded[f].data(), sizes[f], decoded.data(), count, level);
+				DoNotOptimize(decoded.data());
+			}
+			decodeSeconds = std::min(decodeSeconds, timer.Seconds());
+		}
+
+		// untimed round trip check
+		bool exact = true;
+		size_t encodedBytes = 0;
+		for (size_t f = 0; f < clip.frames.size(); f++) {
+			encodedBytes += sizes[f];
+			exact &= DecodeDepth(codec, encoded[f].data(), sizes[f], decoded.data(), count, level)
+				&& std::memcmp(decoded.data(), clip.frames[f].depth.data(), count * sizeof(uint16_t)) == 0;
+		}
+
+		double rawBytes = (double)count * sizeof(uint16_t) * clip.frames.size();
+		std::cout << std::left << std::setw(16) << label << std::right << std::fixed
+			<< std::setw(7) << std::setprecision(2) << rawBytes / encodedBytes << " : 1"
+			<< std::setw(10) << std::setprecision(1) << encodedBytes * 30.0 / clip.frames.size() / 1e6 << " MB/s @30Hz"
+			<< std::setw(10) << std::setprecision(0) << rawBytes / encodeSeconds / 1e6 << " MB/s enc"
+			<< std::setw(10) << rawBytes / decodeSeconds / 1e6 << " MB/s dec"
+			<< (exact ? "" : "   MISMATCH") << std::endl;
+	}
+
+	void DepthCodecs() {
+		std::vector<DepthClip> clips;
+		clips.push_back(SyntheticClip("synthetic", 60, false));
+		clips.push_back(SyntheticClip("synthetic+noise", 60, true));
+
+		DepthClip recorded;
+		if (!GetInput().empty()) {
+			if (RecordedClip(GetInput(), 300, recorded)) clips.push_back(recorded);
+			else std::cout << "Could not read frames from " << GetInput() << std::endl;
+		}
+
+		for (const DepthClip& clip : clips) {
+			std::cout << clip.name << ": " << clip.frames.size() << " frames of " << clip.width << "x" << clip.height
+				<< ", best of 5 passes, throughput in raw bytes" << std::endl;
+
+			RunCodec(clip, DepthCodec::Raw16, Simd::Level::Scalar, "raw");
+			RunCodec(clip, DepthCodec::RVL, Simd::Level::Scalar, "rvl");
+			RunCodec(clip, DepthCodec::DeltaVByte, Simd::Level::Scalar, "vbyte scalar");
+			if (Simd::Detect() >= Simd::Level::SSE41)
+				RunCodec(clip, DepthCodec::DeltaVByte, Simd::Level::SSE41, "vbyte sse4.1");
+			std::cout << std::endl;
+		}
+	}
+
+}
@@ -0,0 +1,303 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../DrawBatch.h"
+#include "../GLState.h"
+#include "../IndexBuffer.h"
+#include "../RenderQueue.h"
+#include "../Renderer.h"
+#include "../Shader.h"
+#include "../UniformBuffer.h"
+#include "../VertexArray.h"
+#include "../VertexBuffer.h"
+#include "../VertexBufferLayout.h"
+
+namespace bench {
+
+	struct Mesh {
+		std::vector<float> vertices;			// xyz rgb
+		std::vector<unsigned int> indices;
+	};
+
+	static void AddVertex(Mesh& mesh, float x, float y, float z, float r, float g, float b) {
+		float v[] = { x, y, z, r, g, b };
+		mesh.vertices.insert(mesh.vertices.end(), v, v + 6);
+	}
+
+	// four small solids so a scene mixes meshes the way chunks of different sizes would
+	static std::vector<Mesh> ChunkMeshes() {
+		std::vector<Mesh> meshes(4);
+
+		Mesh& cube = meshes[0];
+		for (int i = 0; i < 8; i++) AddVertex(cube, i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f, 1.0f, 0.3f, 0.2f);
+		cube.indices = { 0, 2, 1, 1, 2, 3,  4, 5, 6, 5, 7, 6,  0, 1, 4, 1, 5, 4,  2, 6, 3, 3, 6, 7,  0, 4, 2, 2, 4, 6,  1, 3, 5, 3, 7, 5 };
+
+		Mesh& octahedron = meshes[1];
+		const float axes[6][3] = { { 0.5f, 0, 0 }, { -0.5f, 0, 0 }, { 0, 0.5f, 0 }, { 0, -0.5f, 0 }, { 0, 0, 0.5f }, { 0, 0, -0.5f } };
+		for (auto& a : axes) AddVertex(octahedron, a[0], a[1], a[2], 0.2f, 0.8f, 0.3f);
+		octahedron.indices = { 0, 2, 4,  2, 1, 4,  1, 3, 4,  3, 0, 4,  2, 0, 5,  1, 2, 5,  3, 1, 5,  0, 3, 5 };
+
+		Mesh& tetrahedron = meshes[2];
+		AddVertex(tetrahedron, 0.5f, 0.5f, 0.5f, 0.2f, 0.4f, 1.0f);
+		AddVertex(tetrahedron, -0.5f, -0.5f, 0.5f, 0.2f, 0.4f, 1.0f);
+		AddVertex(tetrahedron, -0.5f, 0.5f, -0.5f, 0.2f, 0.4f, 1.0f);
+		AddVertex(tetrahedron, 0.5f, -0.5f, -0.5f, 0.2f, 0.4f, 1.0f);
+		tetrahedron.indices = { 0, 1, 2,  0, 3, 1,  0, 2, 3,  1, 3, 2 };
+
+		Mesh& pyramid = meshes[3];
+		AddVertex(pyramid, -0.5f, -0.5f, -0.5f, 1.0f, 0.9f, 0.2f);
+		AddVertex(pyramid, 0.5f, -0.5f, -0.5f, 1.0f, 0.9f, 0.2f);
+		AddVertex(pyramid, 0.5f, -0.5f, 0.5f, 1.0f, 0.9f, 0.2f);
+		AddVertex(pyramid, -0.5f, -0.5f, 0.5f, 1.0f, 0.9f, 0.2f);
+		AddVertex(pyramid, 0.0f, 0.5f, 0.0f, 1.0f, 0.9f, 0.2f);
+		pyramid.indices = { 0, 1, 2, 0, 2, 3,  0, 4, 1,  1, 4, 2,  2, 4, 3,  3, 4, 0 };
+
+		return meshes;
+	}
+
+	struct Chunk {
+		unsigned int mesh;
+		glm::mat4 model;
+	};
+
+	static std::vector<Chunk> ChunkScene(unsigned int count, unsigned int meshCount) {
+		std::vector<Chunk> chunks(count);
+		unsigned int side = 1;
+		while (side * side * side < count) side++;
+
+		uint32_t seed = 7;
+		for (unsigned int i = 0; i < count; i++) {
+			seed = seed * 1664525u + 1013904223u;
+			glm::vec3 cell((float)(i % side), (float)(i / side % side), (float)(i / side / side));
+			chunks[i].mesh = (seed >> 16) % meshCount;
+			chunks[i].model = glm::scale(glm::translate(glm::mat4(1.0f), (cell - side * 0.5f) * 2.0f), glm::vec3(0.8f));
+		}
+		return chunks;
+	}
+
+	static std::vector<unsigned char> ReadPixels(int width, int height) {
+		std::vector<unsigned char> pixels((size_t)width * height * 4);
+		GLCall(glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+		return pixels;
+	}
+
+	void DrawBatches() {
+		const unsigned int chunkCount = 10000;
+		const int frames = 30;
+
+		HiddenContext context(320, 240);
+		if (!context.IsValid()) return;
+		std::cout << chunkCount << " chunks of 4 mesh types, " << frames << " frames, multi-draw-indirect "
+			<< (DrawBatch::IsIndirectSupported() ? "available" : "not available") << std::endl;
+
+		std::vector<Mesh> meshes = ChunkMeshes();
+		std::vector<Chunk> chunks = ChunkScene(chunkCount, (unsigned int)meshes.size());
+		std::vector<Chunk> sorted = chunks;
+		std::stable_sort(sorted.begin(), sorted.end(), [](const Chunk& a, const Chunk& b) { return a.mesh < b.mesh; });
+
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 320.0f / 240.0f, 0.1f, 500.0f);
+		glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -90.0f));
+		Renderer renderer;
+		GLState::Enable(GL_DEPTH_TEST);
+
+		std::vector<unsigned char> reference;
+		auto report = [&](const char* label, double seconds, unsigned int calls) {
+			std::vector<unsigned char> image = ReadPixels(320, 240);		// last frame, the same picture every way it's drawn
+			if (reference.empty()) reference = image;
+			std::cout << std::left << std::setw(26) << label << std::right << std::fixed
+				<< std::setw(9) << std::setprecision(3) << seconds * 1000.0 / frames << " ms/frame"
+				<< std::setw(8) << calls << " draw calls"
+				<< std::setw(10) << std::setprecision(2) << chunkCount * frames / seconds / 1e6 << " M draws/s"
+				<< std::setw(8) << GLState::GetFrameStats().issued << " binds (" << GLState::GetFrameStats().elided << " elided)"
+				<< (image == reference ? "" : "   MISMATCH") << std::endl;
+		};
+
+		// before: a vertex array + index buffer per mesh, one uniform update and glDrawElements per chunk
+		{
+			std::vector<std::unique_ptr<VertexBuffer>> vbs;
+			std::vector<std::unique_ptr<VertexArray>> vas;
+			std::vector<std::unique_ptr<IndexBuffer>> ibs;
+			for (const Mesh& mesh : meshes) {
+				vas.emplace_back(new VertexArray());
+				vbs.emplace_back(new VertexBuffer(mesh.vertices.data(), (unsigned int)(mesh.vertices.size() * sizeof(float))));
+				vas.back()->AddBuffer(*vbs.back(), Layout<attrib::vec3f, attrib::vec3f>());
+				ibs.emplace_back(new IndexBuffer(mesh.indices.data(), (unsigned int)mesh.indices.size()));
+			}
+			Shader shader("res/shaders/Basic.shader");
+			shader.Bind();
+
+			GLCall(glFinish());
+			Timer timer;
+			for (int f = 0; f < frames; f++) {
+				renderer.Clear();
+				for (const Chunk& chunk : chunks) {
+					shader.SetUniformMVP(chunk.model, view, projection);
+					renderer.Draw(*vas[chunk.mesh], *ibs[chunk.mesh], shader);
+				}
+				GLState::EndFrame();
+			}
+			GLCall(glFinish());
+			report("per-chunk glDrawElements", timer.Seconds(), chunkCount);
+		}
+
+		// after: every mesh in one vertex + index buffer, the scene in one batch
+		std::vector<float> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<MeshRange> ranges;
+		for (const Mesh& mesh : meshes) {
+			ranges.push_back({ (unsigned int)mesh.indices.size(), (unsigned int)indices.size(), (int)(vertices.size() / 6) });
+			vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
+			indices.insert(indices.end(), mesh.indices.begin(), mesh.indices.end());
+		}
+
+		VertexArray va;
+		VertexBuffer vb(vertices.data(), (unsigned int)(vertices.size() * sizeof(float)));
+		va.AddBuffer(vb, Layout<attrib::vec3f, attrib::vec3f>());
+		IndexBuffer ib(indices.data(), (unsigned int)indices.size());
+		DrawBatch batch(va, 2, chunkCount);
+		Shader shader("res/shaders/Batch.shader");
+		shader.Bind();
+		shader.SetUniformMVP(glm::mat4(1.0f), view, projection);
+
+		struct Variant { const char* label; BatchPath path; const std::vector<Chunk>* scene; };
+		const Variant variants[] = {
+			{ "batch instanced", BatchPath::Instanced, &chunks },
+			{ "batch instanced, sorted", BatchPath::Instanced, &sorted },
+			{ "batch indirect", BatchPath::Indirect, &chunks },
+			{ "batch indirect, sorted", BatchPath::Indirect, &sorted },
+		};
+		for (const Variant& variant : variants) {
+			batch.SetPath(variant.path);
+			if (batch.GetPath() != variant.path) continue;
+
+			GLCall(glFinish());
+			Timer timer;
+			for (int f = 0; f < frames; f++) {
+				renderer.Clear();
+				batch.Clear();
+				for (const Chunk& chunk : *variant.scene) batch.Add(ranges[chunk.mesh], chunk.model);
+				batch.Upload();
+				renderer.Draw(va, ib, shader, batch);
+				GLState::EndFrame();
+			}
+			GLCall(glFinish());
+			report(variant.label, timer.Seconds(), batch.GetSubmitCalls());
+		}
+	}
+
+	void RenderQueues() {
+		const unsigned int chunkCount = 10000;
+		const int frames = 30;
+
+		HiddenContext context(320, 240);
+		if (!context.IsValid()) return;
+		std::cout << chunkCount << " chunks of 4 mesh types drawn with 2 programs, " << frames << " frames" << std::endl;
+
+		std::vector<Mesh> meshes = ChunkMeshes();
+		std::vector<Chunk> chunks = ChunkScene(chunkCount, (unsigned int)meshes.size());
+
+		std::vector<std::unique_ptr<VertexBuffer>> vbs;
+		std::vector<std::unique_ptr<VertexArray>> vas;
+		std::vector<std::unique_ptr<IndexBuffer>> ibs;
+		for (const Mesh& mesh : meshes) {
+			vas.emplace_back(new VertexArray());
+			vbs.emplace_back(new VertexBuffer(mesh.vertices.data(), (unsigned int)(mesh.vertices.size() * sizeof(float))));
+			vas.back()->AddBuffer(*vbs.back(), Layout<attrib::vec3f, attrib::vec3f>());
+			ibs.emplace_back(new IndexBuffer(mesh.indices.data(), (unsigned int)mesh.indices.size()));
+		}
+		Shader first("res/shaders/Basic.shader"), second("res/shaders/Basic.shader");		// same output, separate programs
+		Shader* shaders[2] = { &first, &second };
+		Shader firstBlocks("res/shaders/Chunk.shader"), secondBlocks("res/shaders/Chunk.shader");	// the same with Camera / Object blocks
+		Shader* blockShaders[2] = { &firstBlocks, &secondBlocks };
+		std::vector<unsigned int> programs(chunkCount);
+		for (unsigned int i = 0; i < chunkCount; i++) programs[i] = (i * 2654435761u >> 16) & 1;
+
+		glm::mat4 projection = glm::perspective(glm::radians(45.0f), 320.0f / 240.0f, 0.1f, 500.0f);
+		glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -90.0f));
+		Renderer renderer;
+		GLState::Enable(GL_DEPTH_TEST);
+
+		std::vector<unsigned char> reference;
+		auto report = [&](const char* label, double seconds, unsigned int programSwitches, unsigned int vertexArraySwitches) {
+			std::vector<unsigned char> image = ReadPixels(320, 240);
+			if (reference.empty()) reference = image;
+			std::cout << std::left << std::setw(22) << label << std::right << std::fixed
+				<< std::setw(9) << std::setprecision(3) << seconds * 1000.0 / frames << " ms/frame"
+				<< std::setw(7) << programSwitches << " programs" << std::setw(7) << vertexArraySwitches << " vertex arrays"
+				<< std::setw(8) << GLState::GetFrameStats().issued << " binds"
+				<< (image == reference ? "" : "   MISMATCH") << std::endl;
+		};
+
+		// before: immediate Renderer::Draw in scene order
+		unsigned int programSwitches = 0, vertexArraySwitches = 0;
+		{
+			GLCall(glFinish());
+			Timer timer;
+			for (int f = 0; f < frames; f++) {
+				renderer.Clear();
+				programSwitches = vertexArraySwitches = 0;
+				for (unsigned int i = 0; i < chunkCount; i++) {
+					const Chunk& chunk = chunks[i];
+					Shader& shader = *shaders[programs[i]];
+					programSwitches += i == 0 || programs[i] != programs[i - 1];
+					vertexArraySwitches += i == 0 || chunk.mesh != chunks[i - 1].mesh;
+					shader.SetUniformMVP(chunk.model, view, projection);
+					renderer.Draw(*vas[chunk.mesh], *ibs[chunk.mesh], shader);
+				}
+				GLState::EndFrame();
+			}
+			GLCall(glFinish());
+			report("immediate", timer.Seconds(), programSwitches, vertexArraySwitches);
+		}
+
+		// the same order with the camera block once per frame and each model matrix a ring range
+		{
+			UniformBuffer camera(sizeof(CameraBlock));
+			CameraBlock cameraBlock = CameraBlock::From(view, projection, glm::vec4(0.0f, 0.0f, 320.0f, 240.0f));
+			UniformRing objects(chunkCount * UniformRing::GetAlignedSize(sizeof(ObjectBlock)));
+			std::vector<unsigned int> offsets(chunkCount);
+
+			GLCall(glFinish());
+			Timer timer;
+			for (int f = 0; f < frames; f++) {
+				renderer.Clear();
+				camera.SetData(&cameraBlock, sizeof(cameraBlock));
+				camera.Bind(UniformBinding::Camera);
+				objects.Begin();
+				for (unsigned int i = 0; i < chunkCount; i++) offsets[i] = objects.Push(&chunks[i].model, sizeof(ObjectBlock));
+				objects.Upload();
+				for (unsigned int i = 0; i < chunkCount; i++) {
+					objects.Bind(UniformBinding::Object, offsets[i], sizeof(ObjectBlock));
+					renderer.Draw(*vas[chunks[i].mesh], *ibs[chunks[i].mesh], *blockShaders[programs[i]]);
+				}
+				objects.End();
+				GLState::EndFrame();
+			}
+			GLCall(glFinish());
+			report("immediate, UBOs", timer.Seconds(), programSwitches, vertexArraySwitches);
+		}
+
+		RenderQueue queue;
+		for (bool sorting : { false, true }) {
+			queue.SetSorting(sorting);
+			GLCall(glFinish());
+			Timer timer;
+			for (int f = 0; f < frames; f++) {
+				renderer.Clear();
+				queue.Begin(view, projection);
+				for (unsigned int i = 0; i < chunkCount; i++)
+					queue.Submit(*vas[chunks[i].mesh], *ibs[chunks[i].mesh], *blockShaders[programs[i]], chunks[i].model);
+				renderer.Draw(queue);
+				GLState::EndFrame();
+			}
+			GLCall(glFinish());
+			report(sorting ? "queue, sorted" : "queue, unsorted", timer.Seconds(), queue.GetStats().programSwitches, queue.GetStats().vertexArraySwitches);
+		}
+	}
+
+}
@@ -0,0 +1,97 @@
+#include "Benchmark.h"
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "../GLState.h"
+#include "../Renderer.h"
+#include "../VertexBuffer.h"
+#include "../VertexBufferLayout.h"
+#include "../VertexArray.h"
+#include "../IndexBuffer.h"
+#include "../Shader.h"
+#include "../Profiler.h"
+
+namespace bench {
+
+	static const float s_CubeVertices[] = {
+		-0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
+		 0.5f,  0.5f,  0.5f, 1.0f, 0.0f, 0.0f,
+		-0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
+		 0.5f,  0.5f, -0.5f, 1.0f, 1.0f, 0.0f,
+		-0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
+		 0.5f, -0.5f,  0.5f, 0.0f, 1.0f, 1.0f,
+		-0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f,
+		 0.5f, -0.5f, -0.5f, 0.0f, 0.0f, 1.0f,
+	};
+
+	static const unsigned int s_CubeIndices[] = {
+		2, 6, 3, 3, 6, 7,   0, 2, 1, 1, 2, 3,   4, 0, 5, 5, 0, 1,
+		6, 4, 7, 7, 4, 5,   3, 7, 1, 1, 7, 5,   0, 4, 2, 2, 4, 6,
+	};
+
+	void GLErrorModes() {
+		const int draws = 10000;
+		const int frames = 30;
+		const GLErrorMode modes[] = { GLErrorMode::Off, GLErrorMode::FrameSweep, GLErrorMode::DebugCallback, GLErrorMode::PerCall };
+
+		std::cout << draws << " cube draws per frame, " << frames << " frames"
+			<< (GL_ERROR_CHECKING ? "" : " (per-call checking compiled out in this build)") << std::endl;
+
+		double baseline = 0.0;
+		for (GLErrorMode mode : modes) {
+			HiddenContext context(640, 480, mode == GLErrorMode::DebugCallback);
+			if (!context.IsValid()) return;
+			if (!GLSetErrorMode(mode)) continue;
+
+			{
+				VertexArray va;
+				VertexBuffer vb(s_CubeVertices, sizeof(s_CubeVertices));
+				VertexBufferLayout layout;
+				layout.Push<float>(3);
+				layout.Push<float>(3);
+				va.AddBuffer(vb, layout);
+				IndexBuffer ib(s_CubeIndices, 36);
+				Shader shader("res/shaders/Basic.shader");
+				Renderer renderer;
+
+				glm::mat4 projection = glm::perspective(glm::radians(45.0f), 640.0f / 480.0f, 0.1f, 200.0f);
+				glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -120.0f));
+				std::vector<glm::mat4> models(draws);
+				for (int i = 0; i < draws; i++)
+					models[i] = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(i % 100 - 50.0f, i / 100 - 50.0f, 0.0f)), glm::vec3(0.5f));
+
+				GLState::Enable(GL_DEPTH_TEST);
+				shader.Bind();
+
+				std::vector<double> samples;
+				for (int frame = 0; frame < frames + 5; frame++) {
+					Timer timer;
+					renderer.Clear();
+					for (int i = 0; i < draws; i++) {
+						shader.SetUniformMVP(models[i], view, projection);
+						renderer.Draw(va, ib, shader);
+					}
+					GLFrameErrorSweep();
+					double submit = timer.Milliseconds();
+					glFinish();
+					if (frame >= 5) samples.push_back(submit);		// skip warm-up frames
+				}
+
+				double mean = 0.0;
+				for (double ms : samples) mean += ms;
+				mean /= samples.size();
+				if (mode == GLErrorMode::Off) baseline = mean;
+
+				std::cout << std::left << std::setw(10) << GLGetErrorModeName(mode) << std::right << std::fixed << std::setprecision(3)
+					<< std::setw(10) << mean << " ms submit/frame"
+					<< std::setw(10) << mean * 1000.0 / draws << " us/draw"
+					<< std::setw(9) << std::setprecision(2) << (baseline > 0.0 ? mean / baseline : 1.0) << "x off" << std::endl;
+			}
+
+			Profiler::Get().Shutdown();						// its query objects die with this context
+		}
+	}
+
+}
@@ -0,0 +1,124 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../vendor/std_image/stb_image.h"
+#include "../ImageDecoder.h"
+
+namespace bench {
+
+	namespace fs = std::filesystem;
+
+	struct EncodedImage {
+		std::string label;
+		std::vector<unsigned char> data;
+	};
+
+	// best of a few runs, ms per decode; `flip` false bypasses DecodeImage for stb_image without its row flip
+	static double TimeDecode(const EncodedImage& encoded, ImageDecoder decoder, bool flip, DecodedImage& image) {
+		const int repeats = 5;
+		double best = 1e30;
+		for (int r = 0; r < repeats; r++) {
+			Timer timer;
+			if (flip) {
+				if (!DecodeImage(encoded.data.data(), encoded.data.size(), image, nullptr, decoder)) return -1.0;
+			}
+			else {
+				int width = 0, height = 0, channels = 0;
+				stbi_set_flip_vertically_on_load_thread(0);
+				unsigned char* pixels = stbi_load_from_memory(encoded.data.data(), (int)encoded.data.size(), &width, &height, &channels, 4);
+				if (!pixels) return -1.0;
+				image.width = width;
+				image.height = height;
+				image.channels = channels;
+				image.pixels = std::unique_ptr<unsigned char, void (*)(void*)>(pixels, stbi_image_free);
+			}
+			best = std::min(best, timer.Milliseconds());
+			DoNotOptimize(image.pixels.get());
+		}
+		return best;
+	}
+
+	// largest and mean per channel difference, libjpeg-turbo and stb_image round and upsample chroma differently
+	static std::string Compare(const DecodedImage& a, const DecodedImage& b) {
+		if (a.width != b.width || a.height != b.height) return "(size differs from stb_image!)";
+		size_t size = (size_t)a.width * a.height * 4;
+		int largest = 0;
+		double sum = 0.0;
+		for (size_t i = 0; i < size; i++) {
+			int difference = std::abs(a.pixels.get()[i] - b.pixels.get()[i]);
+			largest = std::max(largest, difference);
+			sum += difference;
+		}
+		std::ostringstream out;
+		out << "vs stb: max " << largest << ", mean " << std::setprecision(2) << sum / size;
+		return out.str();
+	}
+
+	void ImageDecodes() {
+		// the files in the input directory, else generated PNGs and JPEGs at camera / screen sizes
+		std::vector<EncodedImage> images;
+		std::error_code error;
+		if (!GetInput().empty() && fs::is_directory(GetInput(), error)) {
+			for (const fs::directory_entry& entry : fs::directory_iterator(GetInput(), error)) {
+				if (!entry.is_regular_file()) continue;
+				std::ifstream file(entry.path(), std::ios::binary);
+				images.push_back({ entry.path().filename().string(), std::vector<unsigned char>(std::istreambuf_iterator<char>(file), {}) });
+			}
+			std::sort(images.begin(), images.end(), [](const EncodedImage& a, const EncodedImage& b) { return a.label < b.label; });
+		}
+		if (images.empty()) {
+			const int sizes[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 } };
+			for (const auto& size : sizes) {
+				std::string suffix = " " + std::to_string(size[0]) + "x" + std::to_string(size[1]);
+				images.push_back({ "png rgb" + suffix, MakePng(size[0], size[1], 3, 1) });
+				images.push_back({ "jpeg 4:2:0" + suffix, MakeJpeg(size[0], size[1], 3, 1) });
+				images.push_back({ "jpeg grey" + suffix, MakeJpeg(size[0], size[1], 1, 1) });
+			}
+		}
+
+		std::cout << images.size() << " images" << (GetInput().empty() ? std::string(" (generated, JPEG quality 90)") : " from " + GetInput())
+			<< ", RGBA8 out, libjpeg-turbo " << (IsImageDecoderAvailable(ImageDecoder::LibjpegTurbo, ImageFormat::Jpeg) ? "built in" : "not built in (USE_LIBJPEG_TURBO)")
+			<< std::endl;
+		std::cout << std::left << std::setw(26) << "image" << std::setw(22) << "decoder" << std::right << std::setw(10) << "KiB"
+			<< std::setw(10) << "ms" << std::setw(10) << "MPix/s" << std::endl;
+
+		for (const EncodedImage& encoded : images) {
+			ImageFormat format = DetectImageFormat(encoded.data.data(), encoded.data.size());
+			struct Run {
+				const char* label;
+				ImageDecoder decoder;
+				bool flip;
+			};
+			std::vector<Run> runs = { { "stb_image, no flip", ImageDecoder::Stb, false }, { "stb_image", ImageDecoder::Stb, true } };
+			if (IsImageDecoderAvailable(ImageDecoder::LibjpegTurbo, format)) runs.push_back({ "libjpeg-turbo", ImageDecoder::LibjpegTurbo, true });
+
+			DecodedImage reference;
+			for (const Run& run : runs) {
+				DecodedImage image;
+				double milliseconds = TimeDecode(encoded, run.decoder, run.flip, image);
+				std::cout << std::left << std::setw(26) << encoded.label << std::setw(22) << run.label << std::right << std::fixed
+					<< std::setprecision(1) << std::setw(10) << encoded.data.size() / 1024.0;
+				if (milliseconds < 0.0) {
+					std::cout << "  failed" << std::endl;
+					continue;
+				}
+				std::cout << std::setprecision(2) << std::setw(10) << milliseconds
+					<< std::setprecision(1) << std::setw(10) << (double)image.width * image.height / (milliseconds * 1000.0);
+				if (run.decoder == ImageDecoder::Stb && run.flip) reference = std::move(image);
+				else if (run.decoder != ImageDecoder::Stb && reference.pixels) std::cout << "  " << Compare(image, reference);
+				std::cout << std::endl;
+			}
+		}
+	}
+
+}
@@ -0,0 +1,199 @@
+#include "Benchmark.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../vendor/std_image/stb_image.h"
+#include "../Framebuffer.h"
+#include "../Mipmap.h"
+#include "../Renderer.h"
+#include "../Sampler.h"
+#include "../Shader.h"
+#include "../Texture.h"
+#include "../TextureCache.h"
+#include "../VertexArray.h"
+
+namespace bench {
+
+	static void ReportBuild(const std::string& label, double milliseconds, const char* note = "") {
+		std::cout << std::left << std::setw(34) << label << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(10) << milliseconds << "  " << note << std::endl;
+	}
+
+	// full chains built each way, best of a few runs
+	static void BuildCosts(const unsigned char* rgba, int size) {
+		const int repeats = 5;
+		std::cout << std::left << std::setw(34) << "mip chain" << std::right << std::setw(10) << "ms" << std::endl;
+
+		TextureImage reference;
+		for (Simd::Level level : { Simd::Level::Scalar, Simd::Level::SSE41 }) {
+			if (Simd::Clamp(level) != level) continue;
+
+			TextureImage chain;
+			chain.levels = GetMipLevelCount(size, size);
+			chain.data.resize(GetMipChainSize(BlockFormat::None, size, size, chain.levels));
+			double best = 1e30;
+			for (int r = 0; r < repeats; r++) {
+				Timer timer;
+				const unsigned char* source = rgba;
+				unsigned char* out = chain.data.data() + (size_t)size * size * 4;
+				for (int l = 1; l < chain.levels; l++) {
+					DownsampleBox(source, GetMipSize(size, l - 1), GetMipSize(size, l - 1), out, level);
+					source = out;
+					out += (size_t)GetMipSize(size, l) * GetMipSize(size, l) * 4;
+				}
+				best = std::min(best, timer.Milliseconds());
+				DoNotOptimize(chain.data.data());
+			}
+			if (level == Simd::Level::Scalar) reference = chain;
+			ReportBuild(std::string("cpu box ") + Simd::GetName(level), best, chain.data == reference.data ? "" : "(differs from scalar!)");
+		}
+
+		{
+			Texture texture("", size, size, rgba);
+			double best = 1e30;
+			for (int r = 0; r < repeats; r++) {
+				GLCall(glFinish());
+				Timer timer;
+				texture.GenerateMipmaps();
+				GLCall(glFinish());
+				best = std::min(best, timer.Milliseconds());
+			}
+			ReportBuild("gpu glGenerateMipmap", best);
+		}
+
+		if (GLEW_EXT_texture_compression_s3tc) {
+			TextureImage single, chain;
+			Timer timer;
+			TextureCache::Encode(rgba, size, size, BlockFormat::BC1, false, single);
+			double singleMs = timer.Milliseconds();
+			timer.Reset();
+			TextureCache::Encode(rgba, size, size, BlockFormat::BC1, true, chain);
+			ReportBuild("bc1, level 0 only", singleMs);
+			ReportBuild("bc1, cpu box chain + every level", timer.Milliseconds());
+		}
+	}
+
+	void TextureMipmaps() {
+		const int width = 1280, height = 720, frames = 40;
+
+		HiddenContext context(width, height);
+		if (!context.IsValid()) return;
+
+		// the input image, else a generated 1024x1024 one
+		int size = 1024, w = 0, h = 0, channels = 0;
+		unsigned char* rgba = nullptr;
+		if (!GetInput().empty()) {
+			rgba = stbi_load(GetInput().c_str(), &w, &h, &channels, 4);
+			if (rgba && w != h) {
+				std::cout << "Input isn't square, using a generated image" << std::endl;
+				stbi_image_free(rgba);
+				rgba = nullptr;
+			}
+			if (rgba) size = w;
+		}
+		if (!rgba) {
+			std::vector<unsigned char> png = MakePng(size, size, 3, 5);
+			rgba = stbi_load_from_memory(png.data(), (int)png.size(), &w, &h, &channels, 4);
+		}
+		if (!rgba) return;
+
+		BuildCosts(rgba, size);
+		std::cout << std::endl;
+
+		// the same image three ways: one level, GPU chain, CPU chain; BC1 with and without a chain
+		Texture single("", size, size, rgba);
+		Texture gpu("", size, size, rgba);
+		gpu.GenerateMipmaps();
+		TextureImage image;
+		TextureCache::Encode(rgba, size, size, BlockFormat::None, true, image);
+		Texture cpu("", 1, 1, nullptr);
+		cpu.SetImage(image);
+
+		bool bc1 = GLEW_EXT_texture_compression_s3tc != 0;
+		Texture compressed("", 1, 1, nullptr), compressedChain("", 1, 1, nullptr);
+		if (bc1) {
+			TextureCache::Encode(rgba, size, size, BlockFormat::BC1, false, image);
+			compressed.SetImage(image);
+			TextureCache::Encode(rgba, size, size, BlockFormat::BC1, true, image);
+			compressedChain.SetImage(image);
+		}
+		stbi_image_free(rgba);
+
+		struct Case {
+			const char* label;
+			Texture* texture;
+			TextureFilter filter;
+			float anisotropy;
+		};
+		std::vector<Case> cases = {
+			{ "rgba8, linear, no mips", &single, TextureFilter::Linear, 1.0f },
+			{ "rgba8, bilinear, gpu mips", &gpu, TextureFilter::Bilinear, 1.0f },
+			{ "rgba8, trilinear, gpu mips", &gpu, TextureFilter::Trilinear, 1.0f },
+			{ "rgba8, trilinear, cpu mips", &cpu, TextureFilter::Trilinear, 1.0f },
+		};
+		float maxAnisotropy = Sampler::GetMaxAnisotropy();
+		if (maxAnisotropy >= 4.0f) cases.push_back({ "rgba8, trilinear, aniso 4x", &gpu, TextureFilter::Trilinear, 4.0f });
+		if (maxAnisotropy >= 16.0f) cases.push_back({ "rgba8, trilinear, aniso 16x", &gpu, TextureFilter::Trilinear, 16.0f });
+		if (bc1) {
+			cases.push_back({ "bc1, linear, no mips", &compressed, TextureFilter::Linear, 1.0f });
+			cases.push_back({ "bc1, trilinear, cpu mips", &compressedChain, TextureFilter::Trilinear, 1.0f });
+		}
+
+		// a tiled floor running to the horizon: most of its texels land far below one per pixel
+		Framebuffer target(width, height);
+		target.Bind();
+		Renderer renderer;
+		VertexArray va;
+		Shader shader("res/shaders/Floor.shader");
+		glm::mat4 projection = glm::perspective(glm::radians(60.0f), (float)width / height, 0.1f, 500.0f);
+		glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 1.5f, 0.0f), glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 model = glm::scale(glm::mat4(1.0f), glm::vec3(400.0f, 1.0f, 400.0f));
+		shader.Bind();
+		shader.SetUniformMat4f("u_MVP", projection * view * model);
+		shader.SetUniform("u_Tiling", 200.0f);
+		shader.SetUniform("u_Texture", 0);
+
+		std::cout << "Floor of " << size << "x" << size << " texture tiles at " << width << "x" << height << ", "
+			<< frames << " frames each, max anisotropy " << maxAnisotropy << std::endl;
+		std::cout << std::left << std::setw(34) << "sampling" << std::right << std::setw(12) << "frame ms"
+			<< std::setw(10) << "levels" << std::setw(12) << "VRAM MiB" << std::endl;
+
+		Sampler sampler;
+		for (const Case& c : cases) {
+			SamplerSettings settings;
+			settings.filter = c.filter;
+			settings.wrap = TextureWrap::Repeat;
+			settings.anisotropy = c.anisotropy;
+			sampler.SetSettings(settings);
+			sampler.Bind(0);
+			c.texture->Bind(0);
+
+			renderer.Clear();
+			renderer.DrawQuad(va, shader);								// warm up, first use uploads / lays out the texture
+			GLCall(glFinish());
+
+			Timer timer;
+			for (int frame = 0; frame < frames; frame++) {
+				renderer.Clear();
+				renderer.DrawQuad(va, shader);
+			}
+			GLCall(glFinish());
+			double milliseconds = timer.Milliseconds() / frames;
+
+			std::cout << std::left << std::setw(34) << c.label << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(12) << milliseconds << std::setw(10) << c.texture->GetLevelCount()
+				<< std::setw(12) << c.texture->GetMemorySize() / (1024.0 * 1024.0) << std::endl;
+		}
+		Sampler::Unbind(0);
+		target.Unbind();
+	}
+
+}
@@ -0,0 +1,189 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../BackProjector.h"
+#include "../PointPacking.h"
+#include "../Renderer.h"
+#include "../Shader.h"
+#include "../UniformBuffer.h"
+#include "../VertexArray.h"
+#include "../VertexBuffer.h"
+
+namespace bench {
+
+	struct PackCase {
+		PointFormat format;
+		Simd::Level level;
+		const char* label;
+	};
+
+	static const PackCase s_PackCases[] = {
+		{ PointFormat::Float32, Simd::Level::Scalar, "float copy" },
+		{ PointFormat::Half, Simd::Level::Scalar, "half scalar" },
+		{ PointFormat::Half, Simd::Level::AVX2, "half f16c" },
+		{ PointFormat::Snorm16, Simd::Level::Scalar, "snorm16 scalar" },
+		{ PointFormat::Snorm16, Simd::Level::SSE41, "snorm16 sse4.1" },
+	};
+
+	// largest distance between the float position and what the vertex shader rebuilds, in metres
+	static float MaxPositionError(PointFormat format, const float* points, const unsigned char* packed, unsigned int count, const PointQuantization& q) {
+		float worst = 0.0f;
+		unsigned int stride = GetPointStride(format);
+		for (unsigned int i = 0; i < count; i++, points += 6, packed += stride) {
+			if (points[2] == 0.0f) continue;
+			float stored[3];
+			for (int k = 0; k < 3; k++) {
+				if (format == PointFormat::Half) {
+					uint16_t h;
+					std::memcpy(&h, packed + 2 * k, sizeof(h));
+					stored[k] = HalfToFloat(h);
+				}
+				else if (format == PointFormat::Snorm16) {
+					int16_t s;
+					std::memcpy(&s, packed + 2 * k, sizeof(s));
+					stored[k] = std::max(s / 32767.0f, -1.0f);
+				}
+				else std::memcpy(&stored[k], packed + 4 * k, sizeof(float));
+			}
+			glm::vec3 rebuilt = format == PointFormat::Float32 ? glm::vec3(stored[0], stored[1], stored[2])
+				: q.origin + glm::vec3(stored[0], stored[1], stored[2]) * q.scale;
+			worst = std::max(worst, glm::length(rebuilt - glm::vec3(points[0], points[1], points[2])));
+		}
+		return worst;
+	}
+
+	static void PackKernels(const std::vector<float>& cloud, unsigned int count, const PointLayout& layout, const PointQuantization& q) {
+		const int passes = 20;
+		std::cout << count << " points, best of " << passes << " passes" << std::endl;
+
+		for (const PackCase& c : s_PackCases) {
+			if (Simd::Clamp(c.level) != c.level) continue;
+			unsigned int stride = GetPointStride(c.format);
+			std::vector<unsigned char> packed((size_t)count * stride), reference(packed.size());
+
+			double seconds = 1e30;
+			for (int pass = 0; pass < passes; pass++) {
+				Timer timer;
+				PackPoints(c.format, layout, cloud.data(), count, q, packed.data(), c.level);
+				DoNotOptimize(packed.data());
+				seconds = std::min(seconds, timer.Seconds());
+			}
+
+			PackPoints(c.format, layout, cloud.data(), count, q, reference.data(), Simd::Level::Scalar);
+			bool exact = packed == reference;
+			double frameMB = (double)count * stride / 1e6;
+
+			std::cout << std::left << std::setw(16) << c.label << std::right << std::fixed
+				<< std::setw(4) << stride << " B/pt"
+				<< std::setw(8) << std::setprecision(2) << frameMB << " MB/frame"
+				<< std::setw(8) << std::setprecision(1) << frameMB * 30.0 << " MB/s @30Hz"
+				<< std::setw(9) << std::setprecision(3) << seconds * 1000.0 << " ms"
+				<< std::setw(8) << std::setprecision(0) << count / seconds / 1e6 << " Mpts/s"
+				<< std::setw(9) << std::setprecision(3) << MaxPositionError(c.format, cloud.data(), packed.data(), count, q) * 1000.0 << " mm max err"
+				<< (exact ? "" : "   MISMATCH") << std::endl;
+		}
+		std::cout << std::endl;
+	}
+
+	// back-projected floats -> packed straight into the streaming buffer -> draw, per frame
+	static void StreamUploads(const std::vector<float>& cloud, unsigned int count, const PointLayout& layout, const PointQuantization& q) {
+		const int frames = 120;
+		HiddenContext context;
+		if (!context.IsValid()) return;
+		UniformBuffer camera(sizeof(CameraBlock));
+		camera.Bind(UniformBinding::Camera);
+
+		std::cout << "streaming upload + draw, " << frames << " frames" << std::endl;
+		const PointFormat formats[] = { PointFormat::Float32, PointFormat::Half, PointFormat::Snorm16 };
+		for (PointFormat format : formats) {
+			unsigned int stride = GetPointStride(format);
+			VertexArray va;
+			VertexBuffer vb(count * stride, BufferUsage::Streaming, 3);
+			if (format == PointFormat::Half) va.AddBuffer(vb, HalfPointVertex());
+			else if (format == PointFormat::Snorm16) va.AddBuffer(vb, Snorm16PointVertex());
+			else va.AddBuffer(vb, FloatPointVertex());
+
+			PointQuantization transform = format == PointFormat::Float32 ? PointQuantization::None() : q;
+			Shader shader("res/shaders/Points.shader");
+			shader.Bind();
+			shader.SetUniform4f("u_PositionTransform", transform.origin.x, transform.origin.y, transform.origin.z, transform.scale);
+			shader.SetUniformMat4f("model", glm::mat4(1.0f));
+			CameraBlock cameraBlock = CameraBlock::From(glm::mat4(1.0f), glm::perspective(glm::radians(45.0f), 640.0f / 480.0f, 0.1f, 100.0f), glm::vec4(0.0f, 0.0f, 640.0f, 480.0f));
+			camera.SetData(&cameraBlock, sizeof(cameraBlock));
+			Renderer renderer;
+
+			GLCall(glFinish());
+			Timer timer;
+			for (int f = 0; f < frames; f++) {
+				PackPoints(format, layout, cloud.data(), count, transform, vb.BeginWrite());
+				vb.EndWrite(count * stride);
+				renderer.DrawPoints(va, shader, vb.GetRegionOffset() / stride, count);
+				vb.FenceRegion();
+			}
+			GLCall(glFinish());
+			double ms = timer.Milliseconds() / frames;
+
+			const StreamStats& stats = vb.GetStats();
+			std::cout << std::left << std::setw(16) << GetPointFormatName(format) << std::right << std::fixed
+				<< std::setw(4) << stride << " B/pt"
+				<< std::setw(9) << std::setprecision(3) << ms << " ms/frame"
+				<< std::setw(9) << std::setprecision(0) << stats.GetWriteMBps() << " MB/s packed"
+				<< std::setw(6) << stats.stalls << " stalls" << std::endl;
+		}
+	}
+
+	void PointPacking() {
+		CameraIntrinsics k = CameraIntrinsics::KinectV2();
+		SyntheticDepthSource source(k);
+		PointLayout layout = PointLayout::From<FloatPointVertex>();
+		BackProjector projector(k, layout);
+
+		unsigned int count = k.width * k.height;
+		std::vector<float> cloud((size_t)count * 6);
+		DepthFrame frame;
+		source.ReadFrame(frame);
+		projector.Process(frame.depth.data(), cloud.data());
+
+		PointQuantization q = PointQuantization::Box(glm::vec3(0.0f, 0.0f, -4.0f), 4.5f);
+		PackKernels(cloud, count, layout, q);
+		StreamUploads(cloud, count, layout, q);
+
+		// octahedral normals: error over a spread of directions
+		const unsigned int normalCount = 100000;
+		std::vector<float> normals((size_t)normalCount * 3);
+		uint32_t seed = 1;
+		for (unsigned int i = 0; i < normalCount; i++) {
+			glm::vec3 n;
+			do {
+				for (int a = 0; a < 3; a++) {
+					seed = seed * 1664525u + 1013904223u;
+					n[a] = (seed >> 8) / 8388608.0f - 1.0f;
+				}
+			} while (glm::length(n) < 0.1f || glm::length(n) > 1.0f);
+			n = glm::normalize(n);
+			std::memcpy(&normals[(size_t)i * 3], &n[0], sizeof(n));
+		}
+		std::vector<int16_t> octahedral((size_t)normalCount * 2);
+		Timer timer;
+		PackOctahedral(normals.data(), normalCount, octahedral.data());
+		double seconds = timer.Seconds();
+
+		float worstDegrees = 0.0f;
+		for (unsigned int i = 0; i < normalCount; i++) {
+			glm::vec3 n(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]);
+			glm::vec3 decoded = UnpackOctahedral(octahedral[i * 2], octahedral[i * 2 + 1]);
+			worstDegrees = std::max(worstDegrees, glm::degrees(std::acos(std::min(glm::dot(n, decoded), 1.0f))));
+		}
+		std::cout << std::endl << "octahedral normals: 12 -> 4 B, " << std::fixed << std::setprecision(0) << normalCount / seconds / 1e6
+			<< " Mnormals/s, " << std::setprecision(4) << worstDegrees << " deg max err" << std::endl;
+	}
+
+}
@@ -0,0 +1,83 @@
+#include "Benchmark.h"
+
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../Renderer.h"
+#include "../Shader.h"
+#include "../ShaderCache.h"
+#include "../ShaderLibrary.h"
+
+namespace bench {
+
+	static const char* s_ShaderFiles[] = { "res/shaders/Basic.shader", "res/shaders/Points.shader", "res/shaders/Batch.shader" };
+
+	// every shader the viewer ships, as at startup; glFinish so a driver that links lazily still pays here
+	static double CreateShaders() {
+		Timer timer;
+		std::vector<std::unique_ptr<Shader>> shaders;
+		for (const char* file : s_ShaderFiles) shaders.emplace_back(new Shader(file));
+		GLCall(glFinish());
+		return timer.Milliseconds();
+	}
+
+	// the same through a library: all submitted, then the first use of each
+	static double LoadLibrary() {
+		Timer timer;
+		ShaderLibrary library;
+		for (const char* file : s_ShaderFiles) library.Load(file, file);
+		for (const char* file : s_ShaderFiles) library.Get(file).Bind();
+		GLCall(glFinish());
+		return timer.Milliseconds();
+	}
+
+	void ShaderCaches() {
+		const int runs = 5;
+		const std::string directory = (std::filesystem::temp_directory_path() / "kinect-viewer-shadercache").string();
+
+		HiddenContext context;
+		if (!context.IsValid()) return;
+
+		std::cout << sizeof(s_ShaderFiles) / sizeof(s_ShaderFiles[0]) << " programs, " << runs << " runs each, parallel compile "
+			<< (ShaderLibrary::IsParallelSupported() ? "available" : "not available") << std::endl;
+		std::cout << "(driver-side caches such as Mesa's still apply; MESA_SHADER_CACHE_DISABLE=true for a true cold compile)" << std::endl;
+
+		auto report = [&](const char* label, double total) {
+			std::cout << std::left << std::setw(38) << label << std::right << std::fixed
+				<< std::setw(9) << std::setprecision(3) << total / runs << " ms" << std::endl;
+		};
+
+		ShaderCache::SetDirectory("");
+		CreateShaders();						// warm-up, the first program created pays for driver setup
+		double blocking = 0.0, deferred = 0.0;
+		for (int run = 0; run < runs; run++) {
+			blocking += CreateShaders();
+			deferred += LoadLibrary();
+		}
+		report("blocking compile + link", blocking);
+		report("deferred library", deferred);
+
+		ShaderCache::SetDirectory(directory);
+		if (!ShaderCache::IsEnabled()) return;
+
+		double cold = 0.0, warm = 0.0;
+		for (int run = 0; run < runs; run++) {
+			std::filesystem::remove_all(directory);
+			ShaderCache::SetDirectory(directory);
+			cold += CreateShaders();
+			warm += CreateShaders();
+		}
+		report("cold binary cache (compile + store)", cold);
+		report("warm binary cache (glProgramBinary)", warm);
+
+		const ShaderCacheStats& stats = ShaderCache::GetStats();
+		std::cout << stats.hits << " loaded, " << stats.compiled << " compiled, " << stats.stored << " stored, " << stats.rejected << " rejected" << std::endl;
+
+		ShaderCache::SetDirectory("");
+		std::filesystem::remove_all(directory);
+	}
+
+}
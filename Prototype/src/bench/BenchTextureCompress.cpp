@@ -0,0 +1,187 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "../vendor/std_image/stb_image.h"
+#include "../BlockCompression.h"
+#include "../GLState.h"
+#include "../Renderer.h"
+#include "../Texture.h"
+#include "../TextureCache.h"
+
+namespace bench {
+
+	// PSNR of the texture as the GPU samples it against the RGB of the source, via glGetTexImage
+	static double ReadbackPsnr(const Texture& texture, const unsigned char* rgba, int width, int height, bool grey) {
+		std::vector<unsigned char> decoded((size_t)width * height * 4);
+		GLState::BindTexture(GL_TEXTURE_2D, texture.GetRendererID());
+		GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+		GLCall(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, decoded.data()));
+		GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+		double squared = 0.0;
+		int channels = grey ? 1 : 3;
+		for (size_t i = 0; i < (size_t)width * height; i++)
+			for (int c = 0; c < channels; c++) {
+				double error = (double)decoded[i * 4 + c] - rgba[i * 4 + c];
+				squared += error * error;
+			}
+		double mse = squared / ((double)width * height * channels);
+		return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+	}
+
+	static void Encoders() {
+		const int width = 1024, height = 1024, repeats = 8;
+
+		std::cout << std::left << std::setw(18) << "encoder" << std::right << std::setw(12) << "MB/s in"
+			<< std::setw(12) << "Mtexel/s" << std::setw(12) << "bit-exact" << std::endl;
+
+		for (BlockFormat format : { BlockFormat::BC1, BlockFormat::BC4 }) {
+			int channels = format == BlockFormat::BC4 ? 1 : 3;
+			std::vector<unsigned char> png = MakePng(width, height, channels, 7);
+			int w = 0, h = 0, n = 0;
+			unsigned char* rgba = stbi_load_from_memory(png.data(), (int)png.size(), &w, &h, &n, 4);
+			if (!rgba) continue;
+
+			size_t size = GetBlockCompressedSize(format, width, height);
+			std::vector<unsigned char> reference(size), blocks(size);
+			CompressBlocks(format, rgba, width, height, reference.data(), Simd::Level::Scalar);
+
+			for (Simd::Level level : { Simd::Level::Scalar, Simd::Level::SSE41 }) {
+				if (Simd::Clamp(level) != level) continue;
+
+				Timer timer;
+				for (int r = 0; r < repeats; r++) {
+					CompressBlocks(format, rgba, width, height, blocks.data(), level);
+					DoNotOptimize(blocks.data());
+				}
+				double seconds = timer.Seconds();
+				double texels = (double)width * height * repeats;
+				std::cout << std::left << std::setw(18) << (std::string(GetBlockFormatName(format)) + " " + Simd::GetName(level)) << std::right
+					<< std::fixed << std::setprecision(1) << std::setw(12) << texels * 4.0 / seconds / 1e6 << std::setw(12) << texels / seconds / 1e6
+					<< std::setw(12) << (blocks == reference ? "yes" : "NO") << std::endl;
+			}
+			stbi_image_free(rgba);
+		}
+	}
+
+	static void Quality() {
+		const int width = 512, height = 512;
+
+		std::cout << std::left << std::setw(18) << "format" << std::right << std::setw(12) << "PSNR dB" << std::setw(14) << "VRAM KiB" << std::endl;
+		for (BlockFormat format : { BlockFormat::None, BlockFormat::BC1, BlockFormat::BC4 }) {
+			bool grey = format == BlockFormat::BC4;
+			std::vector<unsigned char> png = MakePng(width, height, grey ? 1 : 3, 3);
+			int w = 0, h = 0, n = 0;
+			unsigned char* rgba = stbi_load_from_memory(png.data(), (int)png.size(), &w, &h, &n, 4);
+			if (!rgba) continue;
+
+			TextureImage image;
+			TextureCache::Encode(rgba, width, height, format, false, image);
+			Texture texture("", 1, 1, nullptr);
+			texture.SetImage(image);
+
+			std::cout << std::left << std::setw(18) << GetBlockFormatName(format) << std::right << std::fixed << std::setprecision(2)
+				<< std::setw(12) << ReadbackPsnr(texture, rgba, width, height, grey)
+				<< std::setw(14) << std::setprecision(0) << texture.GetMemorySize() / 1024.0 << std::endl;
+			stbi_image_free(rgba);
+		}
+	}
+
+	void TextureCompressions() {
+		namespace fs = std::filesystem;
+		const int imageCount = 120;
+
+		HiddenContext context;
+		if (!context.IsValid()) return;
+
+		TextureCache::SetCompression(true);
+		if (!GLEW_EXT_texture_compression_s3tc) {
+			std::cout << "No EXT_texture_compression_s3tc, skipping" << std::endl;
+			return;
+		}
+
+		Encoders();
+		std::cout << std::endl;
+		Quality();
+		std::cout << std::endl;
+
+		// the images in the input directory, else generated ones: two colour for every greyscale
+		std::vector<std::string> files;
+		fs::path generated;
+		std::error_code error;
+		if (!GetInput().empty() && fs::is_directory(GetInput(), error)) {
+			for (const fs::directory_entry& entry : fs::directory_iterator(GetInput(), error))
+				if (entry.is_regular_file()) files.push_back(entry.path().string());
+			std::sort(files.begin(), files.end());
+			if (files.size() > imageCount) files.resize(imageCount);
+		}
+		if (files.empty()) {
+			generated = fs::temp_directory_path() / "kinect-viewer-textures";
+			fs::create_directories(generated, error);
+			for (int i = 0; i < imageCount; i++) {
+				std::vector<unsigned char> png = MakePng(512, 512, i % 3 == 2 ? 1 : 3, i);
+				files.push_back((generated / ("image" + std::to_string(i) + ".png")).string());
+				std::ofstream(files.back(), std::ios::binary).write((const char*)png.data(), png.size());
+			}
+		}
+		fs::path cache = fs::temp_directory_path() / "kinect-viewer-texture-cache";
+		fs::remove_all(cache, error);
+
+		std::cout << files.size() << " images" << (generated.empty() ? " from " + GetInput() : std::string(" (generated 512x512 PNGs, 1 in 3 greyscale)")) << std::endl;
+		std::cout << std::left << std::setw(30) << "load" << std::right << std::setw(10) << "total ms" << std::setw(10) << "ms/image"
+			<< std::setw(12) << "VRAM MiB" << std::setw(10) << "BC1" << std::setw(6) << "BC4" << std::setw(7) << "RGBA" << std::endl;
+
+		auto run = [&](const char* label, bool compressing, bool mipmaps, const std::string& directory) {
+			TextureCache::SetCompression(compressing);
+			TextureCache::SetMipmaps(mipmaps);
+			TextureCache::SetDirectory(directory);
+
+			std::vector<std::unique_ptr<Texture>> textures;
+			Timer timer;
+			for (const std::string& file : files) textures.emplace_back(new Texture(file));
+			GLCall(glFinish());
+			double seconds = timer.Seconds();
+
+			size_t vram = 0;
+			unsigned int counts[3] = {};
+			for (const std::unique_ptr<Texture>& texture : textures) {
+				vram += texture->GetMemorySize();
+				counts[(int)texture->GetCompression()]++;
+			}
+			std::cout << std::left << std::setw(30) << label << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << seconds * 1000.0 << std::setw(10) << std::setprecision(2) << seconds * 1000.0 / files.size()
+				<< std::setw(12) << std::setprecision(1) << vram / (1024.0 * 1024.0)
+				<< std::setw(10) << counts[(int)BlockFormat::BC1] << std::setw(6) << counts[(int)BlockFormat::BC4] << std::setw(7) << counts[(int)BlockFormat::None] << std::endl;
+		};
+
+		run("stb_image + RGBA8 every launch", false, false, "");
+		run("compress, cold cache", true, false, cache.string());
+		run("compress, warm cache", true, false, cache.string());
+		run("stb_image + RGBA8 + cpu mips", false, true, "");
+		run("compress + mips, cold cache", true, true, cache.string());
+		run("compress + mips, warm cache", true, true, cache.string());
+
+		size_t disk = 0;
+		for (const fs::directory_entry& entry : fs::directory_iterator(cache, error))
+			if (entry.is_regular_file()) disk += (size_t)entry.file_size();
+		TextureCacheStats stats = TextureCache::GetStats();
+		std::cout << "Cache: " << stats.hits << " hits, " << stats.encoded << " encoded, " << stats.stored << " stored, " << stats.rejected << " rejected, "
+			<< std::fixed << std::setprecision(1) << disk / (1024.0 * 1024.0) << " MiB on disk; decode " << stats.decodeSeconds * 1000.0
+			<< " ms, encode " << stats.encodeSeconds * 1000.0 << " ms, cache reads " << stats.readSeconds * 1000.0 << " ms" << std::endl;
+
+		TextureCache::SetCompression(false);
+		TextureCache::SetMipmaps(false);
+		TextureCache::SetDirectory("");
+		fs::remove_all(cache, error);
+		if (!generated.empty()) fs::remove_all(generated, error);
+	}
+
+}
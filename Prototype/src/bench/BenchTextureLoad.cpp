@@ -0,0 +1,95 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../Renderer.h"
+#include "../Texture.h"
+#include "../TextureLoader.h"
+#include "../ThreadPool.h"
+
+namespace bench {
+
+	void TextureLoads() {
+		namespace fs = std::filesystem;
+		const int imageCount = 500;
+
+		HiddenContext context;
+		if (!context.IsValid()) return;
+
+		// the images in the input directory, else generated ones
+		std::vector<std::string> files;
+		fs::path generated;
+		std::error_code error;
+		if (!GetInput().empty() && fs::is_directory(GetInput(), error)) {
+			for (const fs::directory_entry& entry : fs::directory_iterator(GetInput(), error))
+				if (entry.is_regular_file()) files.push_back(entry.path().string());
+			std::sort(files.begin(), files.end());
+		}
+		if (files.empty()) {
+			generated = fs::temp_directory_path() / "kinect-viewer-textures";
+			fs::create_directories(generated, error);
+			for (int i = 0; i < imageCount; i++) {
+				std::vector<unsigned char> png = MakePng(256, 192, 3, i);
+				files.push_back((generated / ("image" + std::to_string(i) + ".png")).string());
+				std::ofstream(files.back(), std::ios::binary).write((const char*)png.data(), png.size());
+			}
+		}
+		for (size_t available = files.size(), i = available; i < imageCount; i++) files.push_back(files[i % available]);		// repeat a small directory
+		files.resize(imageCount);
+
+		std::cout << imageCount << " images" << (generated.empty() ? " from " + GetInput() : std::string(" (generated 256x192 PNGs)")) << ", 2 ms upload budget a frame" << std::endl;
+		std::cout << std::left << std::setw(26) << "" << std::right << std::setw(10) << "total ms" << std::setw(11) << "images/s"
+			<< std::setw(9) << "frames" << std::setw(19) << "worst frame ms" << std::endl;
+
+		auto report = [&](const std::string& label, double seconds, unsigned int frames, double worst) {
+			std::cout << std::left << std::setw(26) << label << std::right << std::fixed << std::setprecision(1)
+				<< std::setw(10) << seconds * 1000.0 << std::setw(11) << imageCount / seconds
+				<< std::setw(9) << frames << std::setw(19) << std::setprecision(3) << worst * 1000.0 << std::endl;
+		};
+
+		{
+			std::vector<std::unique_ptr<Texture>> textures;
+			double worst = 0.0;
+			Timer timer;
+			for (const std::string& file : files) {
+				Timer load;
+				textures.emplace_back(new Texture(file));
+				worst = std::max(worst, load.Seconds());
+			}
+			GLCall(glFinish());
+			report("Texture(path), blocking", timer.Seconds(), imageCount, worst);
+		}
+
+		unsigned int hardware = std::max(4u, std::thread::hardware_concurrency());
+		for (unsigned int workers = 1; workers <= hardware; workers *= 2) {
+			ThreadPool pool(workers);
+			TextureLoader loader(pool);
+			std::vector<std::shared_ptr<Texture>> textures;
+
+			Timer timer;
+			for (const std::string& file : files) textures.push_back(loader.Load(file));
+			unsigned int frames = 0;
+			while (loader.GetPendingCount()) {
+				loader.Update();
+				frames++;
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));		// the rest of the frame
+			}
+			GLCall(glFinish());
+			double seconds = timer.Seconds();
+
+			const TextureLoaderStats& stats = loader.GetStats();
+			if (stats.failed) std::cout << stats.failed << " images failed to load" << std::endl;
+			report("TextureLoader, " + std::to_string(workers) + (workers == 1 ? " worker" : " workers"), seconds, frames, stats.worstFrameSeconds);
+		}
+
+		if (!generated.empty()) fs::remove_all(generated, error);
+	}
+
+}
@@ -0,0 +1,99 @@
+#include "Benchmark.h"
+
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "../Renderer.h"
+#include "../GLState.h"
+#include "../Texture.h"
+
+namespace bench {
+
+	struct UploadTimes {
+		double cpu;								// in the upload calls, copy included
+		double latency;							// upload start until the GPU has the pixels
+	};
+
+	// paced like the camera: one upload per 1/30 s tick, then a fence to see when the GPU is done
+	static UploadTimes PacedUploads(int frames, const std::function<void(int)>& upload) {
+		const auto period = std::chrono::microseconds(33333);
+		UploadTimes total = {};
+		auto tick = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; frame++) {
+			std::this_thread::sleep_until(tick);
+			tick += period;
+
+			Timer timer;
+			upload(frame);
+			total.cpu += timer.Milliseconds();
+			GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {}
+			total.latency += timer.Milliseconds();
+			glDeleteSync(fence);
+		}
+		return { total.cpu / frames, total.latency / frames };
+	}
+
+	static void Fill(std::vector<unsigned char>& pixels, int frame) {
+		for (size_t i = 0; i < pixels.size(); i += 64) pixels[i] = (unsigned char)(frame + i);		// dirty every cache line
+	}
+
+	void TextureStreams() {
+		const int width = 1920, height = 1080, frames = 90;
+
+		HiddenContext context;
+		if (!context.IsValid()) return;
+
+		std::vector<unsigned char> color((size_t)width * height * 4, 128);
+		std::cout << width << "x" << height << " BGRA8 at 30 Hz, " << frames << " frames per row ("
+			<< color.size() / (1024.0 * 1024.0) << " MB a frame)" << std::endl;
+
+		auto report = [&](const char* label, const UploadTimes& times) {
+			std::cout << std::left << std::setw(34) << label << std::right << std::fixed << std::setprecision(3)
+				<< std::setw(9) << times.cpu << " ms CPU" << std::setw(9) << times.latency << " ms latency" << std::endl;
+		};
+
+		unsigned int texture = 0;
+		GLCall(glGenTextures(1, &texture));
+		GLState::BindTexture(GL_TEXTURE_2D, texture);
+		report("glTexImage2D every frame", PacedUploads(frames, [&](int frame) {
+			Fill(color, frame);
+			GLState::BindTexture(GL_TEXTURE_2D, texture);
+			GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, color.data()));
+		}));
+		report("glTexSubImage2D from memory", PacedUploads(frames, [&](int frame) {
+			Fill(color, frame);
+			GLState::BindTexture(GL_TEXTURE_2D, texture);
+			GLCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_BGRA, GL_UNSIGNED_BYTE, color.data()));
+		}));
+		GLState::DeleteTexture(texture);
+
+		{
+			Texture stream(width, height, TextureFormat::BGRA8);
+			report(stream.IsPersistent() ? "PBO ring (persistent), copy in" : "PBO (orphaned), copy in", PacedUploads(frames, [&](int frame) {
+				Fill(color, frame);
+				stream.Update(color.data());
+			}));
+			report("PBO ring, written in place", PacedUploads(frames, [&](int frame) {
+				unsigned char* pixels = (unsigned char*)stream.BeginUpdate();
+				if (pixels)
+					for (size_t i = 0; i < color.size(); i += 64) pixels[i] = (unsigned char)(frame + i);
+				stream.EndUpdate();
+			}));
+			std::cout << "ring stalls: " << stream.GetStats().stalls << " (" << stream.GetStats().stallSeconds * 1000.0 << " ms)" << std::endl;
+		}
+
+		{
+			std::vector<unsigned char> depth(512 * 424 * 2);
+			Texture stream(512, 424, TextureFormat::R16UI);
+			report("PBO ring, 512x424 R16UI depth", PacedUploads(frames, [&](int frame) {
+				Fill(depth, frame);
+				stream.Update(depth.data());
+			}));
+		}
+	}
+
+}
@@ -0,0 +1,61 @@
+#include "Benchmark.h"
+
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+
+#include "../Renderer.h"
+#include "../Shader.h"
+
+namespace bench {
+
+	// what Shader::GetUniformLocation used to do: a std::string per call, find, then operator[]
+	static unsigned int StringMapLookup(std::unordered_map<std::string, unsigned int>& cache, unsigned int program, const std::string& name) {
+		if (cache.find(name) != cache.end()) return cache[name];
+		unsigned int location = glGetUniformLocation(program, name.c_str());
+		cache[name] = location;
+		return location;
+	}
+
+	void UniformLookups() {
+		const int iterations = 3000000;
+
+		HiddenContext context;
+		if (!context.IsValid()) return;
+		Shader shader("res/shaders/Basic.shader");
+		shader.Bind();
+		std::cout << iterations << " lookups of model / view / projection each" << std::endl;
+
+		auto report = [&](const char* label, double seconds, long long sum) {
+			DoNotOptimize(&sum);
+			std::cout << std::left << std::setw(34) << label << std::right << std::fixed
+				<< std::setw(8) << std::setprecision(2) << seconds * 1e9 / (iterations * 3.0) << " ns/lookup" << std::endl;
+		};
+
+		{
+			std::unordered_map<std::string, unsigned int> cache;
+			long long sum = 0;
+			Timer timer;
+			for (int i = 0; i < iterations; i++)
+				sum += StringMapLookup(cache, shader.GetRendererID(), "model") + StringMapLookup(cache, shader.GetRendererID(), "view") + StringMapLookup(cache, shader.GetRendererID(), "projection");
+			report("std::string + unordered_map", timer.Seconds(), sum);
+		}
+		{
+			long long sum = 0;
+			Timer timer;
+			for (int i = 0; i < iterations; i++)
+				sum += shader.GetUniformLocation("model") + shader.GetUniformLocation("view") + shader.GetUniformLocation("projection");
+			report("hashed literal, flat table", timer.Seconds(), sum);
+		}
+		{
+			static constexpr UniformName model("model"), view("view"), projection("projection");
+			long long sum = 0;
+			Timer timer;
+			for (int i = 0; i < iterations; i++)
+				sum += shader.GetUniformLocation(model) + shader.GetUniformLocation(view) + shader.GetUniformLocation(projection);
+			report("constexpr handle, flat table", timer.Seconds(), sum);
+		}
+	}
+
+}
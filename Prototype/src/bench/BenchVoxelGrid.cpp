@@ -0,0 +1,83 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../BackProjector.h"
+#include "../ThreadPool.h"
+#include "../VoxelGridFilter.h"
+
+namespace bench {
+
+	// back-projected synthetic frames, `frames` of them back to back in the viewer's pos + colour layout
+	static std::vector<float> SyntheticCloud(unsigned int frames) {
+		CameraIntrinsics k = CameraIntrinsics::KinectV2();
+		SyntheticDepthSource source(k);
+		BackProjector projector(k, PointLayout(6 * sizeof(float), 0, 3 * sizeof(float)));
+
+		size_t points = (size_t)k.width * k.height;
+		std::vector<float> cloud(points * 6 * frames);
+		DepthFrame frame;
+		for (unsigned int f = 0; f < frames; f++) {
+			source.ReadFrame(frame);
+			projector.Process(frame.depth.data(), cloud.data() + points * 6 * f);
+		}
+		return cloud;
+	}
+
+	void VoxelGrid() {
+		const int iterations = 20;
+		unsigned int hardware = std::max(1u, std::thread::hardware_concurrency());
+		unsigned int maxThreads = std::max(hardware, 4u);
+		const float voxelSizes[] = { 0.01f, 0.05f };
+		const unsigned int frameCounts[] = { 1, 8 };
+
+		std::cout << hardware << " hardware threads, median of " << iterations << " runs" << std::endl;
+
+		for (unsigned int frames : frameCounts) {
+			std::vector<float> cloud = SyntheticCloud(frames);
+			unsigned int count = (unsigned int)(cloud.size() / 6);
+			std::vector<float> output(cloud.size());
+
+			for (float voxelSize : voxelSizes) {
+				std::cout << count << " points, " << voxelSize * 100.0f << " cm voxels" << std::endl;
+
+				double baseline = 0.0;
+				unsigned int baselineCentroids = 0;
+				for (unsigned int threads = 1; threads <= maxThreads; threads *= 2) {
+					std::unique_ptr<ThreadPool> pool(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+					VoxelGridFilter filter(voxelSize, PointLayout(6 * sizeof(float), 0, 3 * sizeof(float)), pool.get());
+
+					unsigned int centroids = 0;
+					std::vector<double> samples(iterations);
+					for (int i = 0; i < iterations; i++) {
+						Timer timer;
+						centroids = filter.Process(cloud.data(), count, output.data());
+						DoNotOptimize(output.data());
+						samples[i] = timer.Milliseconds();
+					}
+					std::nth_element(samples.begin(), samples.begin() + iterations / 2, samples.end());
+					double ms = samples[iterations / 2];
+					if (threads == 1) {
+						baseline = ms;
+						baselineCentroids = centroids;
+					}
+
+					std::cout << std::setw(4) << threads << " threads" << std::fixed
+						<< std::setw(9) << std::setprecision(3) << ms << " ms"
+						<< std::setw(9) << std::setprecision(1) << count / (ms * 1000.0) << " Mpts/s"
+						<< std::setw(7) << std::setprecision(2) << baseline / ms << "x"
+						<< std::setw(10) << centroids << " centroids"
+						<< (centroids == baselineCentroids ? "" : "   MISMATCH")
+						<< (threads > hardware ? "   (oversubscribed)" : "") << std::endl;
+				}
+			}
+			std::cout << std::endl;
+		}
+	}
+
+}
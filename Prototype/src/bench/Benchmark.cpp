@@ -0,0 +1,93 @@
+#include "Benchmark.h"
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include <iostream>
+
+#include "../GLState.h"
+
+namespace bench {
+
+	struct Entry {
+		const char* name;
+		void (*function)();
+		const char* description;
+	};
+
+	static const Entry s_Benchmarks[] = {
+		{ "backproject", BackProjection, "depth -> point cloud kernel vs naive glm loop" },
+		{ "glerrors", GLErrorModes, "GLCall overhead per error mode on a 10k draw scene" },
+		{ "depthcodec", DepthCodecs, "depth compression ratio + encode/decode throughput [recording.kvr|.kvd]" },
+		{ "voxelgrid", VoxelGrid, "voxel grid downsampling points/sec vs thread count" },
+		{ "pointpack", PointPacking, "half / snorm16 vertex packing throughput, error and upload cost" },
+		{ "batch", DrawBatches, "draws/sec per-draw vs instanced vs multi-draw-indirect on 10k chunks" },
+		{ "queue", RenderQueues, "program / vertex array switches and frame time, immediate vs sorted render queue" },
+		{ "shadercache", ShaderCaches, "startup shader creation: blocking vs deferred library vs cold / warm program binary cache" },
+		{ "uniforms", UniformLookups, "uniform location lookup: std::string map vs pre-hashed names" },
+		{ "texstream", TextureStreams, "1080p colour texture upload CPU time / latency: glTexImage2D vs glTexSubImage2D vs PBO ring" },
+		{ "texload", TextureLoads, "500 image loads: blocking Texture(path) vs TextureLoader with 1..N decode workers [image directory]" },
+		{ "texcompress", TextureCompressions, "BC1 / BC4 encoder throughput and quality, VRAM and load time: stb_image each launch vs cold / warm compressed cache, with and without mips [image directory]" },
+		{ "mipmaps", TextureMipmaps, "mip chain build cost (CPU box vs glGenerateMipmap) and frame time on a minified floor per filter / anisotropy [square image]" },
+		{ "imgdecode", ImageDecodes, "PNG / JPEG decode ms and MPixel/s per size: stb_image (SSE2) with and without the row flip vs libjpeg-turbo when built in [image directory]" },
+	};
+
+	static volatile const void* s_Sink = nullptr;
+	static std::string s_Input;
+
+	void DoNotOptimize(const void* p) {
+		s_Sink = p;
+	}
+
+	HiddenContext::HiddenContext(int width, int height, bool debug)
+		:m_Window(nullptr) {
+
+		if (!glfwInit()) return;
+
+		glfwDefaultWindowHints();
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debug);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+		m_Window = glfwCreateWindow(width, height, "bench", NULL, NULL);
+		if (!m_Window) {
+			std::cout << "Could not create a GL context" << std::endl;
+			return;
+		}
+
+		glfwMakeContextCurrent(m_Window);
+		glfwSwapInterval(0);
+		if (glewInit() != GLEW_OK) std::cout << "Error!" << std::endl;
+		GLState::Invalidate();
+	}
+
+	HiddenContext::~HiddenContext() {
+		if (m_Window) glfwDestroyWindow(m_Window);
+		glfwTerminate();
+	}
+
+	bool Run(const std::string& name, const std::string& input) {
+		s_Input = input;
+		for (const Entry& entry : s_Benchmarks) {
+			if (name == entry.name || name == "all") {
+				std::cout << "== " << entry.name << " ==" << std::endl;
+				entry.function();
+				if (name != "all") return true;
+			}
+		}
+		return name == "all";
+	}
+
+	const std::string& GetInput() {
+		return s_Input;
+	}
+
+	void List() {
+		std::cout << "Benchmarks (Prototype --bench <name|all> [input]):" << std::endl;
+		for (const Entry& entry : s_Benchmarks)
+			std::cout << "  " << entry.name << "\t" << entry.description << std::endl;
+	}
+
+}
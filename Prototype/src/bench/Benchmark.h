@@ -0,0 +1,66 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+struct GLFWwindow;
+
+// Micro benchmarks run from the command line with `Prototype --bench <name>`.
+// Each one prints its own table to stdout; they are not part of the normal viewer run.
+namespace bench {
+
+	class Timer {
+	private:
+		std::chrono::steady_clock::time_point m_Start;
+	public:
+		Timer()
+			:m_Start(std::chrono::steady_clock::now()) {}
+
+		inline void Reset() { m_Start = std::chrono::steady_clock::now(); }
+		inline double Seconds() const { return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_Start).count(); }
+		inline double Milliseconds() const { return Seconds() * 1000.0; }
+	};
+
+	// keeps the optimiser from discarding results
+	void DoNotOptimize(const void* p);
+
+	// invisible window + GL 3.3 core context for GPU benchmarks, vsync off
+	class HiddenContext {
+	private:
+		GLFWwindow* m_Window;
+	public:
+		HiddenContext(int width = 640, int height = 480, bool debug = false);
+		~HiddenContext();
+
+		inline bool IsValid() const { return m_Window != nullptr; }
+		inline GLFWwindow* GetWindow() const { return m_Window; }
+	};
+
+	// test images, TestImages.cpp. PNG: grey (1 channel) or RGB (3), every row Paeth-filtered, and
+	// stored (uncompressed) deflate blocks: no zlib here to compress, but the decoder still runs its
+	// inflate loop and unfiltering. JPEG: baseline, grey or 4:2:0 colour, quality 1..100
+	std::vector<unsigned char> MakePng(int width, int height, int channels, int seed);
+	std::vector<unsigned char> MakeJpeg(int width, int height, int channels, int seed, int quality = 90);
+
+	bool Run(const std::string& name, const std::string& input = "");		// false when no benchmark has that name
+	void List();
+	const std::string& GetInput();			// optional file after the name, e.g. a recording to benchmark on
+
+	// registered benchmarks
+	void BackProjection();
+	void GLErrorModes();
+	void DepthCodecs();
+	void VoxelGrid();
+	void PointPacking();
+	void DrawBatches();
+	void RenderQueues();
+	void ShaderCaches();
+	void UniformLookups();
+	void TextureStreams();
+	void TextureLoads();
+	void TextureCompressions();
+	void TextureMipmaps();
+	void ImageDecodes();
+
+}
@@ -0,0 +1,312 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// Test images written without an encoding library, so the decode benchmarks have input on any
+// machine. Not fast, and not meant to be.
+namespace bench {
+
+	static uint32_t Crc32(const unsigned char* data, size_t size, uint32_t crc = 0) {
+		static uint32_t table[256];
+		if (!table[1])
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++) c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				table[i] = c;
+			}
+		crc = ~crc;
+		for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	static void PutBig32(std::vector<unsigned char>& out, uint32_t value) {
+		for (int shift = 24; shift >= 0; shift -= 8) out.push_back((unsigned char)(value >> shift));
+	}
+
+	static void PutChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) {
+		PutBig32(out, (uint32_t)data.size());
+		size_t start = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		PutBig32(out, Crc32(out.data() + start, out.size() - start));
+	}
+
+	std::vector<unsigned char> MakePng(int width, int height, int channels, int seed) {
+		// smooth ramps, more like a photo than noise, stored as Paeth residuals
+		int stride = width * channels;
+		std::vector<unsigned char> image((size_t)stride * height), rows;
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				for (int c = 0; c < channels; c++) image[(size_t)y * stride + x * channels + c] = (unsigned char)(x + y * 2 + c * 80 + seed * 31 + ((x * y) >> 7));
+		for (int y = 0; y < height; y++) {
+			rows.push_back(4);
+			for (int i = 0; i < stride; i++) {
+				int left = i >= channels ? image[(size_t)y * stride + i - channels] : 0;
+				int up = y > 0 ? image[(size_t)(y - 1) * stride + i] : 0;
+				int corner = i >= channels && y > 0 ? image[(size_t)(y - 1) * stride + i - channels] : 0;
+				int p = left + up - corner, pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - corner);
+				int predictor = pa <= pb && pa <= pc ? left : pb <= pc ? up : corner;
+				rows.push_back((unsigned char)(image[(size_t)y * stride + i] - predictor));
+			}
+		}
+
+		std::vector<unsigned char> zlib = { 0x78, 0x01 };
+		for (size_t offset = 0; offset < rows.size(); offset += 65535) {
+			size_t length = std::min<size_t>(65535, rows.size() - offset);
+			zlib.push_back(offset + length == rows.size() ? 1 : 0);
+			zlib.push_back((unsigned char)length);
+			zlib.push_back((unsigned char)(length >> 8));
+			zlib.push_back((unsigned char)~length);
+			zlib.push_back((unsigned char)(~length >> 8));
+			zlib.insert(zlib.end(), rows.begin() + offset, rows.begin() + offset + length);
+		}
+		uint32_t a = 1, b = 0;
+		for (unsigned char c : rows) {
+			a = (a + c) % 65521;
+			b = (b + a) % 65521;
+		}
+		PutBig32(zlib, (b << 16) | a);
+
+		std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' }, header;
+		PutBig32(header, width);
+		PutBig32(header, height);
+		header.insert(header.end(), { 8, (unsigned char)(channels == 1 ? 0 : 2), 0, 0, 0 });		// 8 bit grey or RGB
+		PutChunk(png, "IHDR", header);
+		PutChunk(png, "IDAT", zlib);
+		PutChunk(png, "IEND", {});
+		return png;
+	}
+
+	// baseline JPEG, the standard (Annex K) quantisation and Huffman tables
+	static const int s_Zigzag[64] = {
+		0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5, 12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+		35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+	};
+	static const unsigned char s_LumaQuant[64] = {
+		16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55, 14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+		18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92, 49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99
+	};
+	static const unsigned char s_ChromaQuant[64] = {
+		17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99, 24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99,
+		99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99
+	};
+	static const unsigned char s_DcLumaBits[16] = { 0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0 };
+	static const unsigned char s_DcChromaBits[16] = { 0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0 };
+	static const unsigned char s_DcValues[12] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+	static const unsigned char s_AcLumaBits[16] = { 0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7d };
+	static const unsigned char s_AcLumaValues[162] = {
+		0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+		0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+		0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+		0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+		0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+		0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+		0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+	};
+	static const unsigned char s_AcChromaBits[16] = { 0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77 };
+	static const unsigned char s_AcChromaValues[162] = {
+		0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+		0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1, 0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+		0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+		0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+		0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+		0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+		0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa
+	};
+
+	struct HuffmanCode {
+		uint16_t code;
+		uint8_t length;
+	};
+
+	struct HuffmanTable {
+		HuffmanCode codes[256];
+
+		HuffmanTable(const unsigned char bits[16], const unsigned char* values) {
+			int code = 0, k = 0;
+			for (int length = 1; length <= 16; length++, code <<= 1)
+				for (int i = 0; i < bits[length - 1]; i++, code++, k++) codes[values[k]] = { (uint16_t)code, (uint8_t)length };
+		}
+	};
+
+	// entropy coded bits, MSB first, with a 0 stuffed after every 0xff
+	struct BitWriter {
+		std::vector<unsigned char>& out;
+		uint32_t buffer;
+		int count;
+
+		void Put(uint32_t bits, int length) {
+			buffer = (buffer << length) | (bits & ((1u << length) - 1));
+			for (count += length; count >= 8; count -= 8) {
+				unsigned char byte = (unsigned char)(buffer >> (count - 8));
+				out.push_back(byte);
+				if (byte == 0xff) out.push_back(0);
+			}
+		}
+		void Flush() {
+			if (count) Put(0x7f, 8 - count);			// pad with ones
+		}
+	};
+
+	static void PutMarker(std::vector<unsigned char>& out, unsigned char marker, const std::vector<unsigned char>& segment) {
+		out.insert(out.end(), { 0xff, marker, (unsigned char)((segment.size() + 2) >> 8), (unsigned char)(segment.size() + 2) });
+		out.insert(out.end(), segment.begin(), segment.end());
+	}
+
+	static void PutHuffman(std::vector<unsigned char>& segment, unsigned char id, const unsigned char bits[16], const unsigned char* values) {
+		int count = 0;
+		for (int i = 0; i < 16; i++) count += bits[i];
+		segment.push_back(id);
+		segment.insert(segment.end(), bits, bits + 16);
+		segment.insert(segment.end(), values, values + count);
+	}
+
+	// level shifted 8x8 block -> quantised coefficients -> Huffman bits; returns the DC for the next block
+	static int EncodeBlock(BitWriter& writer, const float block[64], const float divisors[64], int previousDc, const HuffmanTable& dc, const HuffmanTable& ac) {
+		static float cosines[8][8];
+		if (cosines[0][0] == 0.0f)
+			for (int u = 0; u < 8; u++)
+				for (int x = 0; x < 8; x++) cosines[u][x] = (u == 0 ? std::sqrt(0.125f) : 0.5f) * std::cos((2 * x + 1) * u * 3.14159265f / 16.0f);
+
+		float rows[64], coefficients[64];
+		for (int y = 0; y < 8; y++)
+			for (int u = 0; u < 8; u++) {
+				float sum = 0.0f;
+				for (int x = 0; x < 8; x++) sum += cosines[u][x] * block[y * 8 + x];
+				rows[y * 8 + u] = sum;
+			}
+		for (int v = 0; v < 8; v++)
+			for (int u = 0; u < 8; u++) {
+				float sum = 0.0f;
+				for (int y = 0; y < 8; y++) sum += cosines[v][y] * rows[y * 8 + u];
+				coefficients[v * 8 + u] = sum;
+			}
+
+		int quantised[64];
+		for (int k = 0; k < 64; k++) quantised[k] = (int)std::lround(coefficients[s_Zigzag[k]] / divisors[s_Zigzag[k]]);
+
+		auto put = [&](const HuffmanCode& code, int value, int category) {
+			writer.Put(code.code, code.length);
+			if (category) writer.Put(value < 0 ? value - 1 : value, category);			// negative values as their ones' complement
+		};
+		auto categoryOf = [](int value) {
+			int category = 0;
+			for (int magnitude = std::abs(value); magnitude; magnitude >>= 1) category++;
+			return category;
+		};
+
+		int difference = quantised[0] - previousDc, category = categoryOf(difference);
+		put(dc.codes[category], difference, category);
+
+		int run = 0;
+		for (int k = 1; k < 64; k++) {
+			if (quantised[k] == 0) {
+				run++;
+				continue;
+			}
+			for (; run >= 16; run -= 16) writer.Put(ac.codes[0xf0].code, ac.codes[0xf0].length);		// 16 zeros
+			category = categoryOf(quantised[k]);
+			put(ac.codes[(run << 4) | category], quantised[k], category);
+			run = 0;
+		}
+		if (run) writer.Put(ac.codes[0x00].code, ac.codes[0x00].length);						// end of block
+		return quantised[0];
+	}
+
+	std::vector<unsigned char> MakeJpeg(int width, int height, int channels, int seed, int quality) {
+		// the same ramps as MakePng plus a little noise, so the AC coefficients aren't all zero
+		std::vector<unsigned char> image((size_t)width * height * channels);
+		for (int y = 0; y < height; y++)
+			for (int x = 0; x < width; x++)
+				for (int c = 0; c < channels; c++) {
+					uint32_t noise = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ ((uint32_t)c * 83492791u + seed);
+					noise = (noise ^ (noise >> 13)) * 0x5bd1e995u;
+					image[((size_t)y * width + x) * channels + c] = (unsigned char)(x + y * 2 + c * 80 + seed * 31 + ((x * y) >> 7) + (int)((noise >> 24) & 15));
+				}
+
+		int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+		unsigned char tables[2][64];
+		float divisors[2][64];
+		for (int t = 0; t < 2; t++)
+			for (int i = 0; i < 64; i++) {
+				tables[t][i] = (unsigned char)std::min(std::max(((t ? s_ChromaQuant : s_LumaQuant)[i] * scale + 50) / 100, 1), 255);
+				divisors[t][i] = tables[t][i];
+			}
+
+		bool colour = channels == 3;
+		int components = colour ? 3 : 1;
+		std::vector<unsigned char> out = { 0xff, 0xd8 }, segment;
+		PutMarker(out, 0xe0, { 'J', 'F', 'I', 'F', 0, 1, 1, 0, 0, 1, 0, 1, 0, 0 });
+		for (int t = 0; t < (colour ? 2 : 1); t++) {
+			segment = { (unsigned char)t };
+			for (int k = 0; k < 64; k++) segment.push_back(tables[t][s_Zigzag[k]]);
+			PutMarker(out, 0xdb, segment);
+		}
+		segment = { 8, (unsigned char)(height >> 8), (unsigned char)height, (unsigned char)(width >> 8), (unsigned char)width, (unsigned char)components };
+		segment.insert(segment.end(), { 1, (unsigned char)(colour ? 0x22 : 0x11), 0 });		// 4:2:0, like camera output
+		if (colour) segment.insert(segment.end(), { 2, 0x11, 1, 3, 0x11, 1 });
+		PutMarker(out, 0xc0, segment);
+		segment.clear();
+		PutHuffman(segment, 0x00, s_DcLumaBits, s_DcValues);
+		PutHuffman(segment, 0x10, s_AcLumaBits, s_AcLumaValues);
+		if (colour) {
+			PutHuffman(segment, 0x01, s_DcChromaBits, s_DcValues);
+			PutHuffman(segment, 0x11, s_AcChromaBits, s_AcChromaValues);
+		}
+		PutMarker(out, 0xc4, segment);
+		segment = { (unsigned char)components, 1, 0x00 };
+		if (colour) segment.insert(segment.end(), { 2, 0x11, 3, 0x11 });
+		segment.insert(segment.end(), { 0, 63, 0 });
+		PutMarker(out, 0xda, segment);
+
+		static const HuffmanTable dcLuma(s_DcLumaBits, s_DcValues), acLuma(s_AcLumaBits, s_AcLumaValues);
+		static const HuffmanTable dcChroma(s_DcChromaBits, s_DcValues), acChroma(s_AcChromaBits, s_AcChromaValues);
+		BitWriter writer = { out, 0, 0 };
+		int dc[3] = {};
+		float block[64], cb[64], cr[64];
+
+		// YCbCr at (x, y), edges repeated
+		auto sample = [&](int x, int y, float ycc[3]) {
+			const unsigned char* p = &image[((size_t)std::min(y, height - 1) * width + std::min(x, width - 1)) * channels];
+			if (!colour) {
+				ycc[0] = p[0];
+				return;
+			}
+			ycc[0] = 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+			ycc[1] = -0.168736f * p[0] - 0.331264f * p[1] + 0.5f * p[2] + 128.0f;
+			ycc[2] = 0.5f * p[0] - 0.418688f * p[1] - 0.081312f * p[2] + 128.0f;
+		};
+
+		int mcu = colour ? 16 : 8;
+		for (int my = 0; my < height; my += mcu)
+			for (int mx = 0; mx < width; mx += mcu) {
+				if (colour) std::fill(cb, cb + 64, 0.0f), std::fill(cr, cr + 64, 0.0f);
+				for (int b = 0; b < (colour ? 4 : 1); b++) {
+					int bx = mx + (b & 1) * 8, by = my + (b >> 1) * 8;
+					for (int y = 0; y < 8; y++)
+						for (int x = 0; x < 8; x++) {
+							float ycc[3];
+							sample(bx + x, by + y, ycc);
+							block[y * 8 + x] = ycc[0] - 128.0f;
+							if (!colour) continue;
+							int chroma = ((by - my + y) >> 1) * 8 + ((bx - mx + x) >> 1);		// 2x2 average
+							cb[chroma] += (ycc[1] - 128.0f) * 0.25f;
+							cr[chroma] += (ycc[2] - 128.0f) * 0.25f;
+						}
+					dc[0] = EncodeBlock(writer, block, divisors[0], dc[0], dcLuma, acLuma);
+				}
+				if (colour) {
+					dc[1] = EncodeBlock(writer, cb, divisors[1], dc[1], dcChroma, acChroma);
+					dc[2] = EncodeBlock(writer, cr, divisors[1], dc[2], dcChroma, acChroma);
+				}
+			}
+		writer.Flush();
+		out.insert(out.end(), { 0xff, 0xd9 });
+		return out;
+	}
+
+}